@@ -0,0 +1,414 @@
+//
+// Name: access_trace
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "access_trace.h"
+#include <cstring>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Zigzag keeps small negative deltas short, e.g. a loop walking an array backwards
+static inline uint8_t *PutDelta(uint8_t *position, int64_t delta) {
+    return PutVarint(position, ZigzagEncode(delta));
+}
+
+// Read a delta which must end before end, a record running past its block means the trace is corrupted
+static inline int64_t GetDelta(const uint8_t *&position, const uint8_t *end) {
+    uint64_t encoded;
+    if (!GetVarint(position, end, &encoded)) {
+        FATAL("Access trace block is corrupted, a record runs past its end\n");
+    }
+    return ZigzagDecode(encoded);
+}
+
+// Flags byte of a record: kind in bits 0-1, size code in bits 2-4 and bit 5 set if pc is the one before
+// Size code c below 7 is a size of 1 << c bytes, 7 is followed by a varint size
+#define ACCESS_FLAG_SAME_PC 0x20
+#define ACCESS_SIZE_EXPLICIT 7
+
+AccessTraceWriter::AccessTraceWriter(const char *file_name) {
+    this->writer = new BufferedWriter(file_name, DEFAULT_WRITER_BUFFER_SIZE);
+    uint32_t header[2] = {ACCESS_TRACE_MAGIC, ACCESS_TRACE_VERSION};
+    writer->Write(header, sizeof(header));
+    this->offset = sizeof(header);
+    this->accesses = 0;
+    this->finishing = false;
+    for (int i = 0; i < ACCESS_TRACE_QUEUED_BLOCKS + 1; i++) {
+        AccessTraceBlock *block = new AccessTraceBlock;
+        block->data = new uint8_t[ACCESS_TRACE_BLOCK_RECORDS * ACCESS_TRACE_MAX_RECORD_SIZE];
+        free_blocks.push_back(block);
+    }
+    this->current = NULL;
+    this->QueueBlock();
+    this->compressed.resize(compressBound(ACCESS_TRACE_BLOCK_RECORDS * ACCESS_TRACE_MAX_RECORD_SIZE));
+    this->thread = std::thread(&AccessTraceWriter::WriterLoop, this);
+}
+
+AccessTraceWriter::~AccessTraceWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current->records > 0)
+            full_blocks.push_back(current);
+        else
+            free_blocks.push_back(current);
+        current = NULL;
+        finishing = true;
+    }
+    queued.notify_one();
+    thread.join();
+
+    // Index lets readers seek, trailer at the end lets them find the index
+    uint32_t tag = ACCESS_TRACE_INDEX_TAG;
+    int64_t entries = index.size();
+    AccessTraceTrailer trailer;
+    trailer.index_offset = offset;
+    trailer.accesses = accesses;
+    trailer.tag = ACCESS_TRACE_INDEX_TAG;
+    trailer.version = ACCESS_TRACE_VERSION;
+    writer->Write(&tag, sizeof(tag));
+    writer->Write(&entries, sizeof(entries));
+    if (entries > 0)
+        writer->Write(&index[0], entries * sizeof(AccessTraceIndexEntry));
+    writer->Write(&trailer, sizeof(trailer));
+    delete writer;
+    for (size_t i = 0; i < free_blocks.size(); i++) {
+        delete[] free_blocks[i]->data;
+        delete free_blocks[i];
+    }
+}
+
+void AccessTraceWriter::QueueBlock() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (current != NULL) {
+        full_blocks.push_back(current);
+        queued.notify_one();
+    }
+    while (free_blocks.empty())
+        freed.wait(lock);
+    current = free_blocks.front();
+    free_blocks.pop_front();
+    lock.unlock();
+
+    current->size = 0;
+    current->records = 0;
+    current->first_access = accesses;
+    for (int i = 0; i < NUM_OF_ACCESS_KINDS; i++)
+        last_address[i] = 0;
+    last_pc = 0;
+    last_cycle = 0;
+    last_instruction = 0;
+}
+
+void AccessTraceWriter::Record(int32_t kind, int64_t address, int32_t size, int64_t pc, int64_t cycle,
+                               int64_t instruction) {
+    if (current->records == 0)
+        current->first_instruction = instruction;
+    uint8_t *position = current->data + current->size;
+    int32_t size_code = ACCESS_SIZE_EXPLICIT;
+    if (size > 0 && (size & (size - 1)) == 0 && size < (1 << ACCESS_SIZE_EXPLICIT))
+        size_code = __builtin_ctz(size);
+    *position++ = (uint8_t) (kind | (size_code << 2) | (pc == last_pc ? ACCESS_FLAG_SAME_PC : 0));
+    if (size_code == ACCESS_SIZE_EXPLICIT)
+        position = PutVarint(position, (uint32_t) size);
+    position = PutDelta(position, address - last_address[kind]);
+    if (pc != last_pc)
+        position = PutDelta(position, pc - last_pc);
+    position = PutDelta(position, cycle - last_cycle);
+    position = PutDelta(position, instruction - last_instruction);
+    last_address[kind] = address;
+    last_pc = pc;
+    last_cycle = cycle;
+    last_instruction = instruction;
+    current->size = position - current->data;
+    current->records++;
+    accesses++;
+    if (current->records == ACCESS_TRACE_BLOCK_RECORDS)
+        this->QueueBlock();
+}
+
+int64_t AccessTraceWriter::GetAccesses() {
+    return accesses;
+}
+
+void AccessTraceWriter::WriterLoop() {
+    for (;;) {
+        AccessTraceBlock *block;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (full_blocks.empty() && !finishing)
+                queued.wait(lock);
+            if (full_blocks.empty())
+                return;
+            block = full_blocks.front();
+            full_blocks.pop_front();
+        }
+        this->WriteBlock(block);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_blocks.push_back(block);
+        }
+        freed.notify_one();
+    }
+}
+
+void AccessTraceWriter::WriteBlock(AccessTraceBlock *block) {
+    // Fastest level, the encoding already removed most of the redundancy
+    uLongf compressed_size = compressed.size();
+    if (compress2(&compressed[0], &compressed_size, block->data, block->size, Z_BEST_SPEED) != Z_OK) {
+        FATAL("Unable to compress access trace block\n");
+    }
+    AccessTraceBlockHeader header;
+    header.tag = ACCESS_TRACE_BLOCK_TAG;
+    header.records = block->records;
+    header.raw_size = block->size;
+    header.compressed_size = compressed_size;
+    header.first_instruction = block->first_instruction;
+    header.first_access = block->first_access;
+
+    AccessTraceIndexEntry entry;
+    entry.offset = offset;
+    entry.first_instruction = block->first_instruction;
+    entry.first_access = block->first_access;
+    index.push_back(entry);
+
+    writer->Write(&header, sizeof(header));
+    writer->Write(&compressed[0], compressed_size);
+    offset += sizeof(header) + compressed_size;
+}
+
+AccessTraceReader::AccessTraceReader(const char *file_name, bool prefetch) {
+    int fd = open(file_name, O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) < 0) {
+        FATAL("Unable to open access trace %s\n", file_name);
+    }
+    this->map_size = file_stat.st_size;
+    uint32_t header[2];
+    if (map_size < (int64_t) sizeof(header)) {
+        FATAL("%s is not an access trace of this simulator\n", file_name);
+    }
+    void *address = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        FATAL("Unable to map access trace %s\n", file_name);
+    }
+    this->map = (const uint8_t *) address;
+    madvise(address, map_size, MADV_SEQUENTIAL);
+    memcpy(header, map, sizeof(header));
+    if (header[0] != ACCESS_TRACE_MAGIC || header[1] != ACCESS_TRACE_VERSION) {
+        FATAL("%s is not an access trace of this simulator\n", file_name);
+    }
+
+    // Trace of a simulation which did not finish has blocks only
+    this->data_end = map_size;
+    this->accesses = -1;
+    AccessTraceTrailer trailer;
+    if (map_size >= (int64_t) (sizeof(header) + sizeof(trailer))) {
+        memcpy(&trailer, map + map_size - sizeof(trailer), sizeof(trailer));
+        uint32_t tag;
+        int64_t entries;
+        int64_t entries_offset = trailer.index_offset + sizeof(tag) + sizeof(entries);
+        if (trailer.tag == ACCESS_TRACE_INDEX_TAG && trailer.index_offset >= (int64_t) sizeof(header) &&
+            entries_offset <= map_size - (int64_t) sizeof(trailer)) {
+            memcpy(&tag, map + trailer.index_offset, sizeof(tag));
+            memcpy(&entries, map + trailer.index_offset + sizeof(tag), sizeof(entries));
+            if (tag == ACCESS_TRACE_INDEX_TAG && entries >= 0 &&
+                entries_offset + entries * (int64_t) sizeof(AccessTraceIndexEntry) <= map_size) {
+                index.resize(entries);
+                if (entries > 0)
+                    memcpy(&index[0], map + entries_offset, entries * sizeof(AccessTraceIndexEntry));
+                this->data_end = trailer.index_offset;
+                this->accesses = trailer.accesses;
+            }
+        }
+    }
+
+    this->next_offset = sizeof(header);
+    this->block = new AccessTraceRawBlock;
+    this->position = NULL;
+    this->block_end = NULL;
+    this->records_left = 0;
+    this->has_pending = false;
+    this->prefetch = prefetch;
+    this->stopping = false;
+    if (prefetch) {
+        for (int i = 0; i < ACCESS_TRACE_QUEUED_BLOCKS; i++)
+            free_blocks.push_back(new AccessTraceRawBlock);
+        this->StartPrefetch();
+    }
+}
+
+AccessTraceReader::~AccessTraceReader() {
+    if (prefetch) {
+        this->StopPrefetch();
+        for (size_t i = 0; i < free_blocks.size(); i++)
+            delete free_blocks[i];
+    }
+    delete block;
+    munmap((void *) map, map_size);
+}
+
+void AccessTraceReader::DecompressBlock(AccessTraceRawBlock *raw) {
+    AccessTraceBlockHeader header;
+    raw->records = -1;
+    if (next_offset + (int64_t) sizeof(header) > data_end)
+        return;
+    memcpy(&header, map + next_offset, sizeof(header));
+    if (header.tag != ACCESS_TRACE_BLOCK_TAG ||
+        next_offset + (int64_t) sizeof(header) + header.compressed_size > data_end)
+        return;
+    raw->data.resize(header.raw_size);
+    uLongf raw_size = header.raw_size;
+    if (uncompress(&raw->data[0], &raw_size, map + next_offset + sizeof(header), header.compressed_size) != Z_OK ||
+        raw_size != header.raw_size) {
+        FATAL("Access trace block of access %ld is corrupted\n", header.first_access);
+    }
+    raw->records = header.records;
+    next_offset += sizeof(header) + header.compressed_size;
+}
+
+bool AccessTraceReader::ReadBlock() {
+    if (!prefetch) {
+        this->DecompressBlock(block);
+    } else {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (ready_blocks.empty())
+            ready.wait(lock);
+        // End of trace stays queued, so later calls see it too
+        if (ready_blocks.front()->records < 0)
+            return false;
+        free_blocks.push_back(block);
+        block = ready_blocks.front();
+        ready_blocks.pop_front();
+        lock.unlock();
+        freed.notify_one();
+    }
+    if (block->records < 0)
+        return false;
+    position = block->data.data();
+    block_end = position + block->data.size();
+    records_left = block->records;
+    for (int i = 0; i < NUM_OF_ACCESS_KINDS; i++)
+        last_address[i] = 0;
+    last_pc = 0;
+    last_cycle = 0;
+    last_instruction = 0;
+    return true;
+}
+
+void AccessTraceReader::PrefetchLoop() {
+    for (;;) {
+        AccessTraceRawBlock *raw;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (free_blocks.empty() && !stopping)
+                freed.wait(lock);
+            if (stopping)
+                return;
+            raw = free_blocks.front();
+            free_blocks.pop_front();
+        }
+        this->DecompressBlock(raw);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready_blocks.push_back(raw);
+        }
+        ready.notify_one();
+        if (raw->records < 0)
+            return;
+    }
+}
+
+void AccessTraceReader::StartPrefetch() {
+    stopping = false;
+    thread = std::thread(&AccessTraceReader::PrefetchLoop, this);
+}
+
+void AccessTraceReader::StopPrefetch() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    freed.notify_one();
+    thread.join();
+    while (!ready_blocks.empty()) {
+        free_blocks.push_back(ready_blocks.front());
+        ready_blocks.pop_front();
+    }
+}
+
+bool AccessTraceReader::Next(AccessRecord *record) {
+    if (has_pending) {
+        *record = pending;
+        has_pending = false;
+        return true;
+    }
+    while (records_left == 0) {
+        if (!this->ReadBlock())
+            return false;
+    }
+    if (position >= block_end) {
+        FATAL("Access trace block is corrupted, it ends before its last record\n");
+    }
+    uint8_t flags = *position++;
+    record->kind = flags & 3;
+    int32_t size_code = (flags >> 2) & 7;
+    record->size = 1 << size_code;
+    if (size_code == ACCESS_SIZE_EXPLICIT) {
+        uint64_t size;
+        if (!GetVarint(position, block_end, &size)) {
+            FATAL("Access trace block is corrupted, a record runs past its end\n");
+        }
+        record->size = (int32_t) size;
+    }
+    last_address[record->kind] += GetDelta(position, block_end);
+    if (!(flags & ACCESS_FLAG_SAME_PC))
+        last_pc += GetDelta(position, block_end);
+    last_cycle += GetDelta(position, block_end);
+    last_instruction += GetDelta(position, block_end);
+    record->address = last_address[record->kind];
+    record->pc = last_pc;
+    record->cycle = last_cycle;
+    record->instruction = last_instruction;
+    records_left--;
+    return true;
+}
+
+bool AccessTraceReader::SeekInstruction(int64_t instruction) {
+    if (accesses < 0)
+        return false;
+    if (prefetch)
+        this->StopPrefetch();
+    records_left = 0;
+    has_pending = false;
+
+    // Last block starting before instruction, the access wanted is in it or at the start of the next one
+    size_t low = 0, high = index.size();
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (index[middle].first_instruction < instruction)
+            low = middle;
+        else
+            high = middle;
+    }
+    next_offset = index.empty() ? data_end : index[low].offset;
+    if (prefetch)
+        this->StartPrefetch();
+    while (this->Next(&pending)) {
+        if (pending.instruction >= instruction) {
+            has_pending = true;
+            break;
+        }
+    }
+    return true;
+}
+
+int64_t AccessTraceReader::GetAccesses() {
+    return accesses;
+}
@@ -0,0 +1,190 @@
+//
+// Name: access_trace
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_ACCESS_TRACE_H
+#define RISC_V_SIMULATOR_ACCESS_TRACE_H
+
+#include "utility.h"
+#include "buffered_writer.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Kinds of accesses sent to L1 cache
+#define ACCESS_FETCH 0
+#define ACCESS_READ 1
+#define ACCESS_WRITE 2
+#define NUM_OF_ACCESS_KINDS 3
+
+#define ACCESS_TRACE_MAGIC 0x52544341       // "ACTR"
+#define ACCESS_TRACE_VERSION 1
+#define ACCESS_TRACE_BLOCK_TAG 0x4b4c4241   // "ABLK"
+#define ACCESS_TRACE_INDEX_TAG 0x58444e41   // "ANDX"
+#define ACCESS_TRACE_BLOCK_RECORDS 65536    // records compressed together
+#define ACCESS_TRACE_MAX_RECORD_SIZE 51     // flags byte and five varints
+#define ACCESS_TRACE_QUEUED_BLOCKS 4        // blocks waiting for writer thread before simulation waits
+
+// An access as it reaches L1 cache
+typedef struct AccessRecord_ {
+    int64_t address;
+    int64_t pc;                         // instruction making the access
+    int64_t cycle;                      // cycle the access is sent
+    int64_t instruction;                // instructions committed before the access
+    int32_t size;
+    int32_t kind;                       // one of ACCESS_*
+} AccessRecord;
+
+// File starts with magic and version as two uint32_t, then blocks, then the index
+// Records of a block are encoded as deltas from the record before in the same block, so each block decodes alone
+typedef struct AccessTraceBlockHeader_ {
+    uint32_t tag;                       // ACCESS_TRACE_BLOCK_TAG
+    uint32_t records;
+    uint32_t raw_size;                  // bytes of encoded records
+    uint32_t compressed_size;           // bytes of zlib stream following the header
+    int64_t first_instruction;          // instruction of first record
+    int64_t first_access;               // records in blocks before
+} AccessTraceBlockHeader;
+
+// Index is a tag, the number of entries as int64_t and the entries, the file ends with a trailer
+typedef struct AccessTraceIndexEntry_ {
+    int64_t offset;                     // file offset of block header
+    int64_t first_instruction;
+    int64_t first_access;
+} AccessTraceIndexEntry;
+
+typedef struct AccessTraceTrailer_ {
+    int64_t index_offset;
+    int64_t accesses;                   // records in the file
+    uint32_t tag;                       // ACCESS_TRACE_INDEX_TAG
+    uint32_t version;
+} AccessTraceTrailer;
+
+// Encoded records of a block being filled or waiting to be written
+typedef struct AccessTraceBlock_ {
+    uint8_t *data;
+    int64_t size;
+    int32_t records;
+    int64_t first_instruction;
+    int64_t first_access;
+} AccessTraceBlock;
+
+// Writes accesses to a trace file, full blocks are compressed and written by a background thread
+class AccessTraceWriter {
+private:
+    AccessTraceBlock *current;          // block being filled by simulation
+    int64_t accesses;                   // records so far
+    int64_t last_address[NUM_OF_ACCESS_KINDS];  // each kind is a stream of its own, e.g. fetches are sequential
+    int64_t last_pc;
+    int64_t last_cycle;
+    int64_t last_instruction;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable queued;     // a block is queued or trace is finishing
+    std::condition_variable freed;      // a block is written and can be filled again
+    std::deque<AccessTraceBlock *> full_blocks;
+    std::deque<AccessTraceBlock *> free_blocks;
+    bool finishing;
+
+    // Used by writer thread only
+    BufferedWriter *writer;
+    int64_t offset;                     // bytes written to file
+    std::vector<uint8_t> compressed;
+    std::vector<AccessTraceIndexEntry> index;
+
+    // Hand current block to writer thread and take a free one, waiting if the writer is behind
+    void QueueBlock();
+
+    // Compress and write blocks until trace is finished
+    void WriterLoop();
+
+    // Compress and write a block, add it to index
+    void WriteBlock(AccessTraceBlock *block);
+
+public:
+    AccessTraceWriter(const char *file_name);
+
+    // Write the last block and the index, then close file
+    ~AccessTraceWriter();
+
+    // Append an access
+    void Record(int32_t kind, int64_t address, int32_t size, int64_t pc, int64_t cycle, int64_t instruction);
+
+    // Number of accesses recorded
+    int64_t GetAccesses();
+};
+
+// Decompressed records of a block, records is -1 past the last block
+typedef struct AccessTraceRawBlock_ {
+    std::vector<uint8_t> data;
+    int32_t records;
+} AccessTraceRawBlock;
+
+// Reads a mapped trace a block at a time, a trace whose index was never written is read up to its last whole block
+// With prefetch, a background thread decompresses the blocks ahead while records of the current one are decoded
+class AccessTraceReader {
+private:
+    const uint8_t *map;                 // whole trace file
+    int64_t map_size;
+    int64_t data_end;                   // offset of index, or end of file if there is no index
+    std::vector<AccessTraceIndexEntry> index;
+    int64_t accesses;                   // records in trace, -1 if there is no index
+    int64_t next_offset;                // block to decompress next, owned by prefetch thread while it runs
+
+    AccessTraceRawBlock *block;         // block being decoded
+    const uint8_t *position;            // next encoded record of block
+    const uint8_t *block_end;           // end of decompressed block, no record may be read past it
+    int32_t records_left;               // records left in block
+    int64_t last_address[NUM_OF_ACCESS_KINDS];
+    int64_t last_pc;
+    int64_t last_cycle;
+    int64_t last_instruction;
+    bool has_pending;                   // pending is returned by the next call of Next
+    AccessRecord pending;
+
+    bool prefetch;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable ready;      // a block is decompressed
+    std::condition_variable freed;      // a block is decoded and can be filled again, or prefetch is stopping
+    std::deque<AccessTraceRawBlock *> ready_blocks;
+    std::deque<AccessTraceRawBlock *> free_blocks;
+    bool stopping;
+
+    // Decompress block at next_offset into raw and move to the one after, records is -1 at end of trace
+    void DecompressBlock(AccessTraceRawBlock *raw);
+
+    // Make the next block current, return false at end of trace
+    bool ReadBlock();
+
+    // Decompress blocks ahead until end of trace or StopPrefetch
+    void PrefetchLoop();
+
+    void StartPrefetch();
+
+    // Wait for prefetch thread and drop the blocks it decompressed
+    void StopPrefetch();
+
+public:
+    AccessTraceReader(const char *file_name, bool prefetch);
+
+    ~AccessTraceReader();
+
+    // Read next access, return false at end of trace
+    bool Next(AccessRecord *record);
+
+    // Go to the first access made when at least instruction instructions are committed
+    // Return false if the trace has no index, in which case the position is unchanged
+    bool SeekInstruction(int64_t instruction);
+
+    // Number of accesses in trace, -1 if it is unknown
+    int64_t GetAccesses();
+};
+
+#endif //RISC_V_SIMULATOR_ACCESS_TRACE_H
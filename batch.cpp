@@ -0,0 +1,212 @@
+//
+// Name: batch
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "batch.h"
+#include "machine.h"
+#include "config.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char *batch_mode_names[] = {"pipeline", "functional", "jit"};
+
+BatchRunner::BatchRunner(const char *manifest, const BatchDefaults &defaults) {
+    this->defaults = defaults;
+    this->wall_time = 0;
+
+    std::ifstream file(manifest);
+    if (!file) {
+        FATAL("Unable to open batch manifest %s\n", manifest);
+    }
+    std::string line;
+    for (int64_t line_number = 1; std::getline(file, line); line_number++) {
+        // Everything after # is a comment
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        this->ParseJob(manifest, line_number, line);
+    }
+    if (jobs.empty()) {
+        FATAL("Batch manifest %s has no job\n", manifest);
+    }
+}
+
+BatchRunner::~BatchRunner() {
+    for (size_t i = 0; i < queue_locks.size(); i++)
+        delete queue_locks[i];
+}
+
+void BatchRunner::ParseJob(const char *manifest, int64_t line_number, const std::string &line) {
+    BatchJob job;
+    std::istringstream fields(line);
+    fields >> job.binary;
+    size_t slash = job.binary.rfind('/');
+    job.name = slash == std::string::npos ? job.binary : job.binary.substr(slash + 1);
+    job.output = "/dev/null";
+    job.mode = defaults.mode;
+    for (int i = 0; i < 3; i++)
+        job.custom_cache[i] = false;
+    job.exit_code = 0;
+    memset(&job.result, 0, sizeof(job.result));
+    job.host_time = 0;
+
+    std::string field;
+    while (fields >> field) {
+        size_t equal = field.find('=');
+        if (equal == std::string::npos || equal == 0 || equal + 1 == field.size()) {
+            FATAL("%s:%ld: expected <key>=<value> but got %s\n", manifest, line_number, field.c_str());
+        }
+        std::string key = field.substr(0, equal), value = field.substr(equal + 1);
+        if (key == "name") {
+            job.name = value;
+        } else if (key == "input") {
+            job.input = value;
+        } else if (key == "output") {
+            job.output = value;
+        } else if (key == "sandbox") {
+            job.sandbox = value;
+        } else if (key == "mode") {
+            if (value == "pipeline")
+                job.mode = BATCH_MODE_PIPELINE;
+            else if (value == "functional")
+                job.mode = BATCH_MODE_FUNCTIONAL;
+            else if (value == "jit")
+                job.mode = BATCH_MODE_JIT;
+            else {
+                FATAL("%s:%ld: unknown mode %s\n", manifest, line_number, value.c_str());
+            }
+        } else if (key == "l1" || key == "l2" || key == "l3") {
+            int level = key[1] - '1';
+            if (!parse_cache_config(value.c_str(), job.cache_config[level])) {
+                FATAL("%s:%ld: invalid cache config %s\n", manifest, line_number, field.c_str());
+            }
+            job.custom_cache[level] = true;
+        } else {
+            FATAL("%s:%ld: unknown key %s\n", manifest, line_number, key.c_str());
+        }
+    }
+    jobs.push_back(job);
+}
+
+int64_t BatchRunner::TakeJob(int32_t worker) {
+    {
+        std::lock_guard<std::mutex> lock(*queue_locks[worker]);
+        if (!queues[worker].empty()) {
+            int64_t job = queues[worker].back();
+            queues[worker].pop_back();
+            return job;
+        }
+    }
+
+    // Own queue is empty, steal the oldest job of another worker
+    int32_t num_workers = queues.size();
+    for (int32_t i = 1; i < num_workers; i++) {
+        int32_t victim = (worker + i) % num_workers;
+        std::lock_guard<std::mutex> lock(*queue_locks[victim]);
+        if (!queues[victim].empty()) {
+            int64_t job = queues[victim].front();
+            queues[victim].pop_front();
+            return job;
+        }
+    }
+    return -1;
+}
+
+void BatchRunner::Work(int32_t worker) {
+    for (;;) {
+        int64_t job = this->TakeJob(worker);
+        if (job < 0)
+            break;
+        this->RunJob(&jobs[job]);
+    }
+}
+
+void BatchRunner::RunJob(BatchJob *job) {
+    double start_time = HostTime();
+    Machine *machine = new Machine();
+    machine->SetExitMessage(false);
+    if (!job->input.empty())
+        machine->SetInput(job->input.c_str());
+    int fd = open(job->output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        FATAL("Unable to open output file %s of job %s\n", job->output.c_str(), job->name.c_str());
+    }
+    machine->SetConsole(fd, DEFAULT_CONSOLE_BUFFER_SIZE, CONSOLE_FLUSH_FULL);
+    if (!job->sandbox.empty())
+        machine->SetSandboxRoot(job->sandbox.c_str());
+    else if (defaults.sandbox_directory != NULL)
+        machine->SetSandboxRoot(defaults.sandbox_directory);
+    if (defaults.accel_cache && job->mode == BATCH_MODE_PIPELINE)
+        machine->EnableAccelCache();
+    for (int level = STORAGE_LEVEL_L1; level <= STORAGE_LEVEL_L3; level++)
+        if (job->custom_cache[level])
+            machine->SetCacheConfig(level, job->cache_config[level]);
+    if (defaults.image_cache_directory != NULL)
+        machine->EnableImageCache(defaults.image_cache_directory);
+    if (!machine->LoadExecutableFile(job->binary.c_str())) {
+        FATAL("Unable to load executable file %s of job %s\n", job->binary.c_str(), job->name.c_str());
+    }
+
+    if (job->mode == BATCH_MODE_PIPELINE) {
+        while (!machine->IsExit())
+            machine->OneCycle();
+    } else {
+        machine->RunFunctional(job->mode == BATCH_MODE_JIT);
+    }
+
+    machine->TakeSnapshot(&job->result);
+    job->exit_code = machine->GetExitCode();
+    // Console is flushed into fd when machine is deleted
+    delete machine;
+    close(fd);
+    job->host_time = HostTime() - start_time;
+}
+
+void BatchRunner::Run(int32_t num_workers) {
+    ASSERT(num_workers > 0);
+    if (num_workers > (int32_t) jobs.size())
+        num_workers = jobs.size();
+
+    // Deal jobs round robin, so each worker starts with a share of the manifest
+    queues.assign(num_workers, std::deque<int64_t>());
+    for (int32_t i = 0; i < num_workers; i++)
+        queue_locks.push_back(new std::mutex());
+    for (size_t i = 0; i < jobs.size(); i++)
+        queues[i % num_workers].push_front(i);
+
+    double start_time = HostTime();
+    std::vector<std::thread> workers;
+    for (int32_t i = 0; i < num_workers; i++)
+        workers.push_back(std::thread(&BatchRunner::Work, this, i));
+    for (int32_t i = 0; i < num_workers; i++)
+        workers[i].join();
+    wall_time = HostTime() - start_time;
+}
+
+void BatchRunner::PrintResults(FILE *file) {
+    int64_t total_instructions = 0;
+    fprintf(file, "%-20s %-10s %5s %14s %14s %7s %10s %10s %10s %9s %9s\n", "Job", "Mode", "Exit", "Instructions",
+            "Cycles", "CPI", "L1 miss", "L2 miss", "L3 miss", "Host (s)", "MIPS");
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const BatchJob &job = jobs[i];
+        const IntervalSnapshot &result = job.result;
+        double cpi = result.instructions == 0 ? 0 : (double) result.cycles / result.instructions;
+        double mips = job.host_time == 0 ? 0 : result.instructions / job.host_time / 1e6;
+        fprintf(file, "%-20s %-10s %5d %14ld %14ld %7.3lf %10ld %10ld %10ld %9.3lf %9.3lf\n", job.name.c_str(),
+                batch_mode_names[job.mode], (int32_t) job.exit_code, result.instructions, result.cycles, cpi,
+                result.storage[STORAGE_LEVEL_L1].miss_num, result.storage[STORAGE_LEVEL_L2].miss_num,
+                result.storage[STORAGE_LEVEL_L3].miss_num, job.host_time, mips);
+        total_instructions += result.instructions;
+    }
+    fprintf(file, "%ld jobs on %ld workers, wall time: %.3lf s, aggregate speed: %.3lf MIPS\n", (int64_t) jobs.size(),
+            (int64_t) queues.size(), wall_time, wall_time == 0 ? 0 : total_instructions / wall_time / 1e6);
+}
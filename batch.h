@@ -0,0 +1,84 @@
+//
+// Name: batch
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_BATCH_H
+#define RISC_V_SIMULATOR_BATCH_H
+
+#include "utility.h"
+#include "cache.h"
+#include "interval_stats.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#define BATCH_MODE_PIPELINE 0
+#define BATCH_MODE_FUNCTIONAL 1
+#define BATCH_MODE_JIT 2
+
+// Options shared by all jobs of a batch, a job may override mode
+typedef struct BatchDefaults_ {
+    int mode;                           // one of BATCH_MODE_*
+    bool accel_cache;
+    const char *sandbox_directory;      // NULL if jobs may not open files
+    const char *image_cache_directory;  // NULL if images are not kept
+} BatchDefaults;
+
+// A line of manifest and its result
+typedef struct BatchJob_ {
+    std::string name;                   // shown in results, file name of binary by default
+    std::string binary;
+    std::string input;                  // file read as program input, empty for none
+    std::string output;                 // file program output is written to, /dev/null by default
+    std::string sandbox;                // sandbox directory, empty for the batch default
+    int mode;                           // one of BATCH_MODE_*
+    bool custom_cache[3];               // is config of L1, L2 or L3 given in manifest?
+    CacheConfig cache_config[3];
+
+    int64_t exit_code;
+    IntervalSnapshot result;            // counters at exit
+    double host_time;                   // seconds the job took on host
+} BatchJob;
+
+// Runs jobs of a manifest concurrently, one Machine per job
+// Each worker takes jobs from the back of its own queue and steals from the front of others' when it runs out,
+// so long jobs dealt to one worker do not leave the others idle
+class BatchRunner {
+private:
+    std::vector<BatchJob> jobs;
+    BatchDefaults defaults;
+    std::vector<std::deque<int64_t> > queues;   // indexes of jobs not started, one queue per worker
+    std::vector<std::mutex *> queue_locks;
+    double wall_time;                           // seconds from first job started to last one finished
+
+    // Parse one non-empty manifest line into a job
+    void ParseJob(const char *manifest, int64_t line_number, const std::string &line);
+
+    // Next job for worker, -1 if every queue is empty
+    int64_t TakeJob(int32_t worker);
+
+    // Run jobs until there is none left
+    void Work(int32_t worker);
+
+    // Load and run the job on a fresh machine, and collect its counters
+    void RunJob(BatchJob *job);
+
+public:
+    // Read jobs from manifest, one per line: <binary> [name=..] [input=..] [output=..] [sandbox=..]
+    // [mode=pipeline|functional|jit] [l1|l2|l3=<size>[K|M]:<associativity>]
+    BatchRunner(const char *manifest, const BatchDefaults &defaults);
+
+    ~BatchRunner();
+
+    // Run all jobs on num_workers threads
+    void Run(int32_t num_workers);
+
+    // Print a row of counters for every job in manifest order
+    void PrintResults(FILE *file);
+};
+
+#endif //RISC_V_SIMULATOR_BATCH_H
@@ -0,0 +1,77 @@
+//
+// Name: buffered_writer
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "buffered_writer.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+BufferedWriter::BufferedWriter(int fd, int64_t buffer_size) {
+    ASSERT(buffer_size > 0);
+    this->fd = fd;
+    this->own_fd = false;
+    this->buffer = new char[buffer_size];
+    this->buffer_size = buffer_size;
+    this->used = 0;
+}
+
+BufferedWriter::BufferedWriter(const char *file_name, int64_t buffer_size) {
+    ASSERT(buffer_size > 0);
+    this->fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0) {
+        FATAL("Unable to open file %s\n", file_name);
+    }
+    this->own_fd = true;
+    this->buffer = new char[buffer_size];
+    this->buffer_size = buffer_size;
+    this->used = 0;
+}
+
+BufferedWriter::~BufferedWriter() {
+    this->Flush();
+    if (own_fd)
+        close(fd);
+    delete[] buffer;
+}
+
+void BufferedWriter::WriteAll(const char *data, int64_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            FATAL("Unable to write to file descriptor %d\n", fd);
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void BufferedWriter::Printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer + used, buffer_size - used, format, args);
+    va_end(args);
+    if (length >= 0 && used + length < buffer_size) {
+        used += length;
+        return;
+    }
+
+    // Not enough space, flush and format again
+    this->Flush();
+    va_start(args, format);
+    length = vsnprintf(buffer, buffer_size, format, args);
+    va_end(args);
+    ASSERT(length >= 0 && length < buffer_size);
+    used = length;
+}
+
+void BufferedWriter::Flush() {
+    if (used > 0)
+        this->WriteAll(buffer, used);
+    used = 0;
+}
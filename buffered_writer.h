@@ -0,0 +1,60 @@
+//
+// Name: buffered_writer
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_BUFFERED_WRITER_H
+#define RISC_V_SIMULATOR_BUFFERED_WRITER_H
+
+#include "utility.h"
+#include <cstring>
+
+#define DEFAULT_WRITER_BUFFER_SIZE (1 << 20)
+
+// Writer which collects small writes in memory and hands them to write(2) in large blocks
+class BufferedWriter {
+private:
+    int fd;                         // file descriptor to write to
+    bool own_fd;                    // should fd be closed when writer is deleted?
+    char *buffer;                   // pending data
+    int64_t buffer_size;            // capacity of buffer
+    int64_t used;                   // number of pending bytes in buffer
+
+    // Write all bytes to fd, retrying on short writes
+    void WriteAll(const char *data, int64_t size);
+
+public:
+    // Write to an already opened file descriptor, which is not closed by the writer
+    BufferedWriter(int fd, int64_t buffer_size);
+
+    // Create or truncate file and write to it
+    BufferedWriter(const char *file_name, int64_t buffer_size);
+
+    ~BufferedWriter();
+
+    // Append data, flush if buffer is full
+    inline void Write(const void *data, int64_t size) {
+        if (used + size > buffer_size) {
+            this->Flush();
+            if (size > buffer_size) {
+                this->WriteAll((const char *) data, size);
+                return;
+            }
+        }
+        memcpy(buffer + used, data, size);
+        used += size;
+    }
+
+    // Append formatted text
+    void Printf(const char *format, ...);
+
+    // Number of pending bytes
+    int64_t Pending() const { return used; }
+
+    // Write all pending data
+    void Flush();
+};
+
+#endif //RISC_V_SIMULATOR_BUFFERED_WRITER_H
@@ -7,6 +7,7 @@
 
 #include "cache.h"
 #include "utility.h"
+#include "trace.h"
 
 void Cache::HandleRequest(uint64_t addr, int bytes, int read, int &hit, int &time) {
     hit = 0;
@@ -16,16 +17,16 @@ void Cache::HandleRequest(uint64_t addr, int bytes, int read, int &hit, int &tim
     uint64_t tag = addr >> (config_.num_of_bits_block + config_.num_of_bits_index);
 
     if (read) {
-        DEBUG("\nRead");
+        TRACE(CACHE_READ);
     } else {
-        DEBUG("\nWrite");
+        TRACE(CACHE_WRITE);
     }
 
     // Cache hit?
     CacheBlock *target_block = SearchCache(index, tag);
     if (target_block != NULL) {
         // Cache hit
-        DEBUG(" cache HIT at %16.16lx, index %lx, tag %lx\n", addr, index, tag);
+        TRACE(CACHE_HIT, addr, index, tag);
         hit = 1;
         time += latency_.bus_latency + latency_.hit_latency;
         stats_.access_time += time;
@@ -33,7 +34,7 @@ void Cache::HandleRequest(uint64_t addr, int bytes, int read, int &hit, int &tim
         if (!read) {
             if (config_.write_through) {
                 // Write to lower cache
-                DEBUG("Write through to lower level\n");
+                TRACE(CACHE_WRITE_THROUGH);
                 int lower_hit, lower_time;
                 lower_->HandleRequest(addr, bytes, read, lower_hit, lower_time);
                 time += latency_.bus_latency + lower_time;
@@ -44,7 +45,7 @@ void Cache::HandleRequest(uint64_t addr, int bytes, int read, int &hit, int &tim
         return;
     } else {
         // Cache miss
-        DEBUG(" cache MISS at %16.16lx, index %lx, tag %lx\n", addr, index, tag);
+        TRACE(CACHE_MISS, addr, index, tag);
         int lower_hit, lower_time;
         stats_.miss_num++;
         hit = 0;
@@ -68,7 +69,7 @@ void Cache::HandleRequest(uint64_t addr, int bytes, int read, int &hit, int &tim
         } else {
             // Write allocate or not?
             if (config_.write_allocate) {
-                DEBUG("Write allocate from lower level\n");
+                TRACE(CACHE_WRITE_ALLOCATE);
                 // Find a cache block to store data
                 CacheBlock *target_block = FindEmptyBlock(index);
                 int choose_victim_time;
@@ -109,11 +110,11 @@ CacheBlock *Cache::SearchCache(uint64_t index, uint64_t tag) {
 CacheBlock *Cache::FindEmptyBlock(uint64_t index) {
     for (int i = 0; i < config_.associativity; i++) {
         if (!cache_blocks_[index][i].valid_) {
-            DEBUG("Empty block FOUND, index %lx, line %lx\n", index, i);
+            TRACE(CACHE_EMPTY_FOUND, index, i);
             return &cache_blocks_[index][i];
         }
     }
-    DEBUG("Empty block NOT FOUND in index %lx. ", index);
+    TRACE(CACHE_EMPTY_NOT_FOUND, index);
     return NULL;
 }
 
@@ -136,14 +137,15 @@ CacheBlock *Cache::ChooseVictim(uint64_t index, int &time) {
 }
 
 CacheBlock *Cache::LRUReplacement(uint64_t index) {
-    int min_access_counter = cache_blocks_[index][0].access_counter, min_index = 0;
+    int64_t min_access_counter = cache_blocks_[index][0].access_counter;
+    int min_index = 0;
     for (int i = 1; i < config_.associativity; i++) {
         if (cache_blocks_[index][i].access_counter < min_access_counter) {
             min_access_counter = cache_blocks_[index][i].access_counter;
             min_index = i;
         }
     }
-    DEBUG("Victim choosed, index %lx, line %lx\n", index, min_index);
+    TRACE(CACHE_VICTIM, index, min_index);
     return &cache_blocks_[index][min_index];
 }
 
@@ -160,9 +162,7 @@ Cache::Cache() {
 }
 
 Cache::~Cache() {
-    for (int i = 0; i < config_.set_num; i++)
-        delete cache_blocks_[i];
-    delete cache_blocks_;
+    FreeBlocks();
 }
 
 void Cache::BuildBlocks() {
@@ -173,3 +173,12 @@ void Cache::BuildBlocks() {
             cache_blocks_[i][j].valid_ = false;
     }
 }
+
+void Cache::FreeBlocks() {
+    if (cache_blocks_ == NULL)
+        return;
+    for (int i = 0; i < config_.set_num; i++)
+        delete[] cache_blocks_[i];
+    delete[] cache_blocks_;
+    cache_blocks_ = NULL;
+}
@@ -26,7 +26,7 @@ typedef struct CacheBlock_ {
 public:
     bool valid_;
     bool dirty_;
-    int access_counter; // Used for LRU replacement
+    int64_t access_counter; // Used for LRU replacement, stamp from access_counter of stats
     uint64_t tag_;
 } CacheBlock;
 
@@ -38,11 +38,18 @@ public:
 
     // Sets & Gets
     void SetConfig(CacheConfig cc) {
+        FreeBlocks();
         config_ = cc;
         BuildBlocks();
     }
 
-    void GetConfig(CacheConfig cc) { cc = config_; }
+    void GetConfig(CacheConfig &cc) { cc = config_; }
+
+    // Change write policy only, cached blocks are kept
+    void SetWritePolicy(int write_through, int write_allocate) {
+        config_.write_through = write_through;
+        config_.write_allocate = write_allocate;
+    }
 
     void SetLower(Storage *ll) { lower_ = ll; }
 
@@ -66,6 +73,8 @@ private:
 
     void BuildBlocks();
 
+    void FreeBlocks();
+
     CacheConfig config_;
     Storage *lower_;
     CacheBlock **cache_blocks_;
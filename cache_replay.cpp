@@ -0,0 +1,99 @@
+//
+// Name: cache_replay
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "cache_replay.h"
+#include "config.h"
+
+CacheReplay::CacheReplay() {
+    for (int i = 0; i < NUM_OF_ACCESS_KINDS; i++)
+        accesses[i] = 0;
+    total_access_time = 0;
+    host_time = 0;
+
+    // Same hierarchy as Machine builds
+    memory = new MemoryForCache();
+    memory->SetLatency(get_memory_latency());
+    memory->SetStats(get_zero_stats());
+
+    l1 = new Cache();
+    l1->SetLatency(get_l1_cache_latency());
+    l1->SetConfig(get_l1_cache_config());
+    l1->SetStats(get_zero_stats());
+
+    l2 = new Cache();
+    l2->SetLatency(get_l2_cache_latency());
+    l2->SetConfig(get_l2_cache_config());
+    l2->SetStats(get_zero_stats());
+
+    l3 = new Cache();
+    l3->SetLatency(get_l3_cache_latency());
+    l3->SetConfig(get_l3_cache_config());
+    l3->SetStats(get_zero_stats());
+
+    l3->SetLower(memory);
+    l2->SetLower(l3);
+    l1->SetLower(l2);
+}
+
+CacheReplay::~CacheReplay() {
+    delete memory;
+    delete l1;
+    delete l2;
+    delete l3;
+}
+
+Cache *CacheReplay::CacheLevel(int level) {
+    switch (level) {
+        case STORAGE_LEVEL_L1:
+            return l1;
+        case STORAGE_LEVEL_L2:
+            return l2;
+        case STORAGE_LEVEL_L3:
+            return l3;
+        default: FATAL("Invalid cache level %d\n", level);
+    }
+}
+
+void CacheReplay::SetCacheConfig(int level, CacheConfig config) {
+    this->CacheLevel(level)->SetConfig(config);
+}
+
+void CacheReplay::Run(const char *file_name) {
+    double start_time = HostTime();
+    AccessTraceReader reader(file_name, true);
+    AccessRecord record;
+    int hit, time;
+    while (reader.Next(&record)) {
+        l1->HandleRequest(record.address, record.size, record.kind != ACCESS_WRITE, hit, time);
+        total_access_time += time;
+        accesses[record.kind]++;
+    }
+    host_time += HostTime() - start_time;
+}
+
+void CacheReplay::PrintStats(FILE *file) {
+    int64_t total = accesses[ACCESS_FETCH] + accesses[ACCESS_READ] + accesses[ACCESS_WRITE];
+    fprintf(file, "Replayed %ld accesses: %ld fetches, %ld reads, %ld writes\n", total, accesses[ACCESS_FETCH],
+            accesses[ACCESS_READ], accesses[ACCESS_WRITE]);
+    fprintf(file, "Host time: %.3lf s, replay speed: %.3lf M accesses/s\n", host_time,
+            host_time == 0 ? 0 : total / host_time / 1e6);
+
+    fprintf(file, "\n****************\n");
+    static const char *names[STORAGE_LEVEL_MEMORY] = {"L1", "L2", "L3"};
+    StorageStats stats;
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        this->CacheLevel(level)->GetStats(stats);
+        float miss_rate = (float) stats.miss_num / stats.access_counter;
+        fprintf(file, "Total %s access time: %ld cycle, access count: %ld, miss rate: %.6f\n",
+                names[level], stats.access_time, stats.access_counter, miss_rate);
+        fprintf(file, "        miss num: %ld, replace num: %ld\n", stats.miss_num, stats.replace_num);
+        fprintf(file, "        fetch num: %ld, prefetch num: %ld\n", stats.fetch_num, stats.prefetch_num);
+    }
+    memory->GetStats(stats);
+    fprintf(file, "Total memory access time: %ld cycle, access count: %ld\n", stats.access_time, stats.access_counter);
+    fprintf(file, "TOTAL ACCESS TIME: %ld cycle\n", total_access_time);
+}
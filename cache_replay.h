@@ -0,0 +1,49 @@
+//
+// Name: cache_replay
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_CACHE_REPLAY_H
+#define RISC_V_SIMULATOR_CACHE_REPLAY_H
+
+#include "utility.h"
+#include "storage.h"
+#include "interval_stats.h"
+#include "memory.h"
+#include "cache.h"
+#include "access_trace.h"
+
+// Drives the cache hierarchy of a machine with an access trace, nothing is decoded or executed and there is no
+// guest memory, so cache designs are compared without running the program again
+class CacheReplay {
+private:
+    MemoryForCache *memory;
+    Cache *l1;
+    Cache *l2;
+    Cache *l3;
+    int64_t accesses[NUM_OF_ACCESS_KINDS];  // replayed accesses of each kind
+    int64_t total_access_time;
+    double host_time;                       // seconds spent replaying
+
+    // Cache of a level, one of STORAGE_LEVEL_L1/L2/L3
+    Cache *CacheLevel(int level);
+
+public:
+    // Hierarchy has the default configs of a machine
+    CacheReplay();
+
+    ~CacheReplay();
+
+    // Replace config of a cache level, one of STORAGE_LEVEL_L1/L2/L3, should be called before Run
+    void SetCacheConfig(int level, CacheConfig config);
+
+    // Send every access of trace file to L1 cache
+    void Run(const char *file_name);
+
+    // Print counters of every level in the format of Machine::PrintCacheStats, and the replay speed
+    void PrintStats(FILE *file);
+};
+
+#endif //RISC_V_SIMULATOR_CACHE_REPLAY_H
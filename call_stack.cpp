@@ -0,0 +1,58 @@
+//
+// Name: call_stack
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "call_stack.h"
+#include <string>
+
+CallStackSampler::CallStackSampler(int64_t entry_pc, int64_t sample_period) {
+    ASSERT(sample_period > 0);
+    this->stack.push_back(entry_pc);
+    this->sample_period = sample_period;
+    this->next_sample_cycle = sample_period;
+}
+
+void CallStackSampler::Call(int64_t target_pc) {
+    stack.push_back(target_pc);
+}
+
+void CallStackSampler::Return() {
+    // Never pop the entry function, unmatched returns (e.g. after longjmp) are ignored
+    if (stack.size() > 1)
+        stack.pop_back();
+}
+
+void CallStackSampler::Sample(int64_t current_cycle) {
+    while (current_cycle >= next_sample_cycle) {
+        stack_samples[stack]++;
+        next_sample_cycle += sample_period;
+    }
+}
+
+void CallStackSampler::WriteCollapsedStacks(FILE *file, const SymbolTable *symbol_table) {
+    // Different entry pcs in the same function are merged by name
+    std::map<std::string, int64_t> collapsed_stacks;
+    char address_name[32];
+    for (std::map<std::vector<int64_t>, int64_t>::iterator it = stack_samples.begin();
+         it != stack_samples.end(); it++) {
+        std::string collapsed;
+        for (int i = 0; i < it->first.size(); i++) {
+            const FunctionSymbol *symbol = symbol_table->FindFunction(it->first[i]);
+            if (i != 0)
+                collapsed += ";";
+            if (symbol != NULL) {
+                collapsed += symbol->name;
+            } else {
+                sprintf(address_name, "0x%lx", it->first[i]);
+                collapsed += address_name;
+            }
+        }
+        collapsed_stacks[collapsed] += it->second * sample_period;
+    }
+
+    for (std::map<std::string, int64_t>::iterator it = collapsed_stacks.begin(); it != collapsed_stacks.end(); it++)
+        fprintf(file, "%s %ld\n", it->first.c_str(), it->second);
+}
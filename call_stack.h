@@ -0,0 +1,41 @@
+//
+// Name: call_stack
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_CALL_STACK_H
+#define RISC_V_SIMULATOR_CALL_STACK_H
+
+#include "utility.h"
+#include "elf_reader.h"
+#include <map>
+#include <vector>
+
+#define DEFAULT_SAMPLE_PERIOD 1000
+
+class CallStackSampler {
+private:
+    std::vector<int64_t> stack;                             // shadow call stack, entry pc of each function
+    std::map<std::vector<int64_t>, int64_t> stack_samples;  // number of samples of each call stack
+    int64_t sample_period;                                  // sample once every sample_period cycles
+    int64_t next_sample_cycle;                              // cycle number of next sample
+
+public:
+    CallStackSampler(int64_t entry_pc, int64_t sample_period);
+
+    // A call instruction (JAL/JALR with rd == ra) jumps to target_pc
+    void Call(int64_t target_pc);
+
+    // A return instruction (JR ra) is executed
+    void Return();
+
+    // Take samples until next sample cycle is after current cycle
+    void Sample(int64_t current_cycle);
+
+    // Write collapsed stacks weighted by cycles, one "f1;f2;f3 cycles" line per call stack
+    void WriteCollapsedStacks(FILE *file, const SymbolTable *symbol_table);
+};
+
+#endif //RISC_V_SIMULATOR_CALL_STACK_H
@@ -102,3 +102,31 @@ CacheConfig get_l3_cache_config() {
 
     return config;
 }
+
+bool make_cache_config(int size, int associativity, CacheConfig &config) {
+    // Block size and write policy are the same as the default caches
+    config = get_l1_cache_config();
+    if (size <= 0 || associativity <= 0 || size % (config.block_size * associativity) != 0)
+        return false;
+    config.size = size;
+    config.associativity = associativity;
+    config.set_num = size / (config.block_size * associativity);
+    config.num_of_bits_index = 0;
+    while ((1 << config.num_of_bits_index) < config.set_num)
+        config.num_of_bits_index++;
+    return config.set_num == 1 << config.num_of_bits_index;
+}
+
+bool parse_cache_config(const char *spec, CacheConfig &config) {
+    char *end;
+    long size = strtol(spec, &end, 10);
+    if (*end == 'K' || *end == 'k') {
+        size <<= 10;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        size <<= 20;
+        end++;
+    }
+    long associativity = *end == ':' ? strtol(end + 1, &end, 10) : 0;
+    return *end == '\0' && make_cache_config((int) size, (int) associativity, config);
+}
@@ -26,4 +26,10 @@ CacheConfig get_l2_cache_config();
 
 CacheConfig get_l3_cache_config();
 
+// Config of a cache of size bytes with default block size, false if sets would not be a power of 2
+bool make_cache_config(int size, int associativity, CacheConfig &config);
+
+// Config of a cache given as "<size>[K|M]:<associativity>", false if it is invalid
+bool parse_cache_config(const char *spec, CacheConfig &config);
+
 #endif //CACHE_CONFIG_H
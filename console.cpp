@@ -0,0 +1,42 @@
+//
+// Name: console
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "console.h"
+#include <cstring>
+
+ConsoleBuffer::ConsoleBuffer(int fd, int64_t buffer_size, int policy) {
+    this->writer = new BufferedWriter(fd, buffer_size);
+    this->policy = policy;
+}
+
+ConsoleBuffer::~ConsoleBuffer() {
+    this->Flush();
+    delete writer;
+}
+
+void ConsoleBuffer::Write(const char *data, int64_t size) {
+    writer->Write(data, size);
+    if (policy == CONSOLE_FLUSH_ALWAYS || (policy == CONSOLE_FLUSH_LINE && memchr(data, '\n', size) != NULL))
+        this->Flush();
+}
+
+void ConsoleBuffer::Printf(const char *format, ...) {
+    char text[64];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    ASSERT(length >= 0 && length < (int) sizeof(text));
+    this->Write(text, length);
+}
+
+void ConsoleBuffer::Flush() {
+    if (writer->Pending() == 0)
+        return;
+    fflush(stdout);
+    writer->Flush();
+}
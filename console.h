@@ -0,0 +1,41 @@
+//
+// Name: console
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_CONSOLE_H
+#define RISC_V_SIMULATOR_CONSOLE_H
+
+#include "utility.h"
+#include "buffered_writer.h"
+
+// When output of the simulated program is handed to the host
+#define CONSOLE_FLUSH_FULL 0            // when buffer reaches its size, and at exit
+#define CONSOLE_FLUSH_LINE 1            // also after every newline
+#define CONSOLE_FLUSH_ALWAYS 2          // after every system call
+#define DEFAULT_CONSOLE_BUFFER_SIZE (64 << 10)
+
+// Output of the simulated program, kept apart from simulator diagnostics on stdout
+class ConsoleBuffer {
+private:
+    BufferedWriter *writer;
+    int policy;                     // one of CONSOLE_FLUSH_*
+
+public:
+    ConsoleBuffer(int fd, int64_t buffer_size, int policy);
+
+    ~ConsoleBuffer();
+
+    // Append program output, flush according to policy
+    void Write(const char *data, int64_t size);
+
+    // Append a formatted number or short text
+    void Printf(const char *format, ...);
+
+    // Hand all pending output to the host, stdout is flushed first to keep diagnostics in order
+    void Flush();
+};
+
+#endif //RISC_V_SIMULATOR_CONSOLE_H
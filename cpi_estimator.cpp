@@ -0,0 +1,295 @@
+//
+// Name: cpi_estimator
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "cpi_estimator.h"
+#include "interpreter.h"
+#include "config.h"
+#include <cmath>
+
+CPIEstimator::CPIEstimator() {
+    CacheConfig configs[STORAGE_LEVEL_MEMORY] = {get_l1_cache_config(), get_l2_cache_config(),
+                                                 get_l3_cache_config()};
+    StorageLatency latencies[STORAGE_LEVEL_MEMORY] = {get_l1_cache_latency(), get_l2_cache_latency(),
+                                                      get_l3_cache_latency()};
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        caches[level].tags = NULL;
+        caches[level].last_use = NULL;
+        caches[level].dirty = NULL;
+        this->SetLevel(level, configs[level], latencies[level]);
+    }
+    memory_latency = get_memory_latency();
+    memory_accesses = 0;
+    for (int i = 0; i < NUM_OF_OP_TYPES; i++)
+        op_counts[i] = 0;
+    instructions = 0;
+    load_use = 0;
+    branches = 0;
+    taken_branches = 0;
+    jumps = 0;
+    last_load_rd = REG_zero;
+}
+
+CPIEstimator::~CPIEstimator() {
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        delete[] caches[level].tags;
+        delete[] caches[level].last_use;
+        delete[] caches[level].dirty;
+    }
+}
+
+void CPIEstimator::SetLevel(int level, CacheConfig config, StorageLatency latency) {
+    if (level == STORAGE_LEVEL_MEMORY) {
+        memory_latency = latency;
+        return;
+    }
+    ASSERT(level >= 0 && level < STORAGE_LEVEL_MEMORY);
+    EstimatorCache &cache = caches[level];
+    delete[] cache.tags;
+    delete[] cache.last_use;
+    delete[] cache.dirty;
+    int64_t lines = (int64_t) config.set_num * config.associativity;
+    cache.config = config;
+    cache.latency = latency;
+    cache.tags = new uint64_t[lines];
+    cache.last_use = new uint64_t[lines];
+    cache.dirty = new bool[lines];
+    for (int64_t i = 0; i < lines; i++) {
+        cache.last_use[i] = 0;
+        cache.dirty[i] = false;
+    }
+    cache.clock = 0;
+    cache.accesses = 0;
+    cache.misses = 0;
+    cache.writebacks = 0;
+}
+
+void CPIEstimator::Access(int level, uint64_t address, bool read) {
+    if (level == STORAGE_LEVEL_MEMORY) {
+        memory_accesses++;
+        return;
+    }
+    EstimatorCache &cache = caches[level];
+    const CacheConfig &config = cache.config;
+    cache.accesses++;
+    uint64_t index = (address >> config.num_of_bits_block) & ((1 << config.num_of_bits_index) - 1);
+    uint64_t tag = address >> (config.num_of_bits_block + config.num_of_bits_index);
+    int64_t first = index * config.associativity;
+
+    // Same policies as Cache: LRU replacement, write back or through, write allocate or not
+    int64_t victim = first;
+    for (int64_t line = first; line < first + config.associativity; line++) {
+        if (cache.last_use[line] != 0 && cache.tags[line] == tag) {
+            cache.last_use[line] = ++cache.clock;
+            if (!read) {
+                if (config.write_through)
+                    this->Access(level + 1, address, false);
+                else
+                    cache.dirty[line] = true;
+            }
+            return;
+        }
+        if (cache.last_use[line] < cache.last_use[victim])
+            victim = line;
+    }
+    cache.misses++;
+    if (!read && !config.write_allocate) {
+        this->Access(level + 1, address, false);
+        return;
+    }
+    if (cache.last_use[victim] != 0 && cache.dirty[victim] && !config.write_through) {
+        cache.writebacks++;
+        uint64_t victim_address = (cache.tags[victim] << (config.num_of_bits_block + config.num_of_bits_index))
+                                  + (index << config.num_of_bits_block);
+        this->Access(level + 1, victim_address, false);
+    }
+    cache.tags[victim] = tag;
+    cache.last_use[victim] = ++cache.clock;
+    cache.dirty[victim] = !read;
+    this->Access(level + 1, address, true);
+}
+
+void CPIEstimator::Observe(const Instruction *instruction, int64_t pc, int64_t length, const int64_t *registers) {
+    instructions++;
+    op_counts[instruction->op_type]++;
+    this->Access(STORAGE_LEVEL_L1, pc, true);
+
+    // Pipeline stalls whatever follows a load, dependent or not
+    if (last_load_rd != REG_zero)
+        load_use++;
+    last_load_rd = REG_zero;
+
+    bool taken = false;
+    switch (instruction->op_type) {
+        case OP_LB:
+        case OP_LH:
+        case OP_LW:
+        case OP_LD:
+        case OP_LBU:
+        case OP_LHU:
+        case OP_LWU:
+            this->Access(STORAGE_LEVEL_L1, registers[instruction->rs1] + instruction->imm, true);
+            last_load_rd = instruction->rd;
+            break;
+        case OP_LWSP:
+        case OP_LDSP:
+            this->Access(STORAGE_LEVEL_L1, registers[REG_sp] + instruction->imm, true);
+            last_load_rd = instruction->rd;
+            break;
+        case OP_SB:
+        case OP_SH:
+        case OP_SW:
+        case OP_SD:
+            this->Access(STORAGE_LEVEL_L1, registers[instruction->rs1] + instruction->imm, false);
+            break;
+        case OP_SWSP:
+        case OP_SDSP:
+            this->Access(STORAGE_LEVEL_L1, registers[REG_sp] + instruction->imm, false);
+            break;
+        case OP_JAL:
+        case OP_J:
+        case OP_JALR:
+        case OP_JR:
+            jumps++;
+            taken = true;
+            break;
+        default:
+            if (IsBranch(instruction->op_type)) {
+                branches++;
+                taken = BranchTaken(instruction, registers);
+                if (taken)
+                    taken_branches++;
+            }
+    }
+
+    // Instruction after a taken jump or branch is fetched before it is flushed
+    if (taken)
+        this->Access(STORAGE_LEVEL_L1, pc + length, true);
+}
+
+void CPIEstimator::Estimate(CPIEstimate &estimate) {
+    // Every request a level receives costs its bus latency, and its hit latency if it hits there
+    int64_t access_time = memory_accesses * (memory_latency.bus_latency + memory_latency.hit_latency);
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        const EstimatorCache &cache = caches[level];
+        access_time += cache.accesses * cache.latency.bus_latency +
+                       (cache.accesses - cache.misses) * cache.latency.hit_latency;
+    }
+    estimate.instructions = instructions;
+    estimate.stalls_by_data = load_use;
+    estimate.stalls_by_ctrl = taken_branches + jumps;
+    estimate.stalls_by_memory = access_time - caches[STORAGE_LEVEL_L1].accesses;
+    estimate.cycles = PIPELINE_FILL_CYCLES + instructions + estimate.stalls_by_data + estimate.stalls_by_ctrl +
+                      estimate.stalls_by_memory;
+}
+
+// Relative error of estimate against actual value, 0 if both are 0
+static double RelativeError(int64_t estimate, int64_t actual) {
+    if (actual == 0)
+        return estimate == 0 ? 0 : 1;
+    return (double) (estimate - actual) / actual;
+}
+
+void CPIEstimator::PrintReport(FILE *file, Stats *detailed) {
+    // Op mix in classes which the pipeline treats differently
+    int64_t loads = 0, stores = 0, multiplies = 0, system = 0;
+    for (int op = 0; op < NUM_OF_OP_TYPES; op++) {
+        switch (op) {
+            case OP_LB:
+            case OP_LH:
+            case OP_LW:
+            case OP_LD:
+            case OP_LBU:
+            case OP_LHU:
+            case OP_LWU:
+            case OP_LWSP:
+            case OP_LDSP:
+                loads += op_counts[op];
+                break;
+            case OP_SB:
+            case OP_SH:
+            case OP_SW:
+            case OP_SD:
+            case OP_SWSP:
+            case OP_SDSP:
+                stores += op_counts[op];
+                break;
+            case OP_MUL:
+            case OP_MULH:
+            case OP_MULHSU:
+            case OP_MULHU:
+            case OP_MULW:
+            case OP_DIV:
+            case OP_DIVU:
+            case OP_DIVW:
+            case OP_DIVUW:
+            case OP_REM:
+            case OP_REMU:
+            case OP_REMW:
+            case OP_REMUW:
+                multiplies += op_counts[op];
+                break;
+            case OP_ECALL:
+            case OP_CSRRW:
+            case OP_CSRRS:
+            case OP_CSRRC:
+            case OP_CSRRWI:
+            case OP_CSRRSI:
+            case OP_CSRRCI:
+                system += op_counts[op];
+                break;
+        }
+    }
+    int64_t alu = instructions - loads - stores - multiplies - system - branches - jumps;
+    double total = instructions == 0 ? 1 : instructions;
+
+    fprintf(file, "\n****************\n");
+    fprintf(file, "CPI estimate of %ld instructions\n", instructions);
+    fprintf(file, "%-16s %14s %9s\n", "Op class", "Count", "Share");
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "ALU", alu, 100.0 * alu / total);
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "Mul/div", multiplies, 100.0 * multiplies / total);
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "Load", loads, 100.0 * loads / total);
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "Store", stores, 100.0 * stores / total);
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "Branch", branches, 100.0 * branches / total);
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "Jump", jumps, 100.0 * jumps / total);
+    fprintf(file, "%-16s %14ld %8.2lf%%\n", "System", system, 100.0 * system / total);
+    fprintf(file, "Load-use pairs: %ld, taken branches: %ld of %ld\n", load_use, taken_branches, branches);
+
+    static const char *names[STORAGE_LEVEL_MEMORY] = {"L1", "L2", "L3"};
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        const EstimatorCache &cache = caches[level];
+        double miss_rate = cache.accesses == 0 ? 0 : (double) cache.misses / cache.accesses;
+        fprintf(file, "%s accesses: %ld, misses: %ld, miss rate: %.6lf, writebacks: %ld\n", names[level],
+                cache.accesses, cache.misses, miss_rate, cache.writebacks);
+    }
+    fprintf(file, "Memory accesses: %ld\n", memory_accesses);
+
+    CPIEstimate estimate;
+    this->Estimate(estimate);
+    fprintf(file, "Estimated CPI: %.6lf = base %.6lf + data %.6lf + ctrl %.6lf + memory %.6lf\n",
+            estimate.cycles / total, (instructions + PIPELINE_FILL_CYCLES) / total, estimate.stalls_by_data / total,
+            estimate.stalls_by_ctrl / total, estimate.stalls_by_memory / total);
+    if (detailed == NULL)
+        return;
+
+    // Compare with the counters of a pipeline run of the same program
+    int64_t estimated[5] = {estimate.instructions, estimate.cycles, estimate.stalls_by_ctrl,
+                            estimate.stalls_by_data, estimate.stalls_by_memory};
+    int64_t actual[5] = {detailed->GetInstructions(), detailed->GetCycles(), detailed->GetStallsByCtrl(),
+                         detailed->GetStallsByData(), detailed->GetStallsByMemory()};
+    static const char *counters[5] = {"Instructions", "Cycles", "Ctrl stalls", "Data stalls", "Memory stalls"};
+    fprintf(file, "\n%-16s %14s %14s %9s\n", "Counter", "Estimated", "Pipeline", "Error");
+    for (int i = 0; i < 5; i++)
+        fprintf(file, "%-16s %14ld %14ld %8.2lf%%\n", counters[i], estimated[i], actual[i],
+                100.0 * RelativeError(estimated[i], actual[i]));
+    double estimated_cpi = estimate.cycles / total;
+    double actual_cpi = actual[0] == 0 ? 0 : (double) actual[1] / actual[0];
+    double error = actual_cpi == 0 ? 0 : (estimated_cpi - actual_cpi) / actual_cpi;
+    fprintf(file, "%-16s %14.6lf %14.6lf %8.2lf%%\n", "CPI", estimated_cpi, actual_cpi, 100.0 * error);
+    bool trusted = fabs(error) <= TRUSTED_CPI_ERROR;
+    fprintf(file, "Estimate is %s, CPI error %s %.0lf%%\n", trusted ? "trusted" : "NOT trusted",
+            trusted ? "within" : "over", 100.0 * TRUSTED_CPI_ERROR);
+}
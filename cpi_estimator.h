@@ -0,0 +1,87 @@
+//
+// Name: cpi_estimator
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_CPI_ESTIMATOR_H
+#define RISC_V_SIMULATOR_CPI_ESTIMATOR_H
+
+#include "utility.h"
+#include "instruction.h"
+#include "storage.h"
+#include "cache.h"
+#include "stats.h"
+#include "interval_stats.h"
+
+// Cycles from the first fetch until the first instruction reaches Execute stage, which the pipeline spends once
+#define PIPELINE_FILL_CYCLES 2
+
+// Error of estimated CPI against the pipeline below which the estimate is reported as trusted
+#define TRUSTED_CPI_ERROR 0.02
+
+// Tags of one cache level, there is no data, timing or prefetching, only the hits, misses and writebacks which
+// the latencies of the level are charged for
+typedef struct EstimatorCache_ {
+    CacheConfig config;
+    StorageLatency latency;
+    uint64_t *tags;
+    uint64_t *last_use;                 // access stamp of each line for LRU, 0 if line is invalid
+    bool *dirty;
+    uint64_t clock;                     // stamp of last access
+    int64_t accesses;                   // requests reaching this level, including writebacks from above
+    int64_t misses;
+    int64_t writebacks;                 // dirty lines evicted to level below
+} EstimatorCache;
+
+// Estimate of the counters of class Stats
+typedef struct CPIEstimate_ {
+    int64_t instructions;
+    int64_t cycles;
+    int64_t stalls_by_ctrl;
+    int64_t stalls_by_data;
+    int64_t stalls_by_memory;
+} CPIEstimate;
+
+// Counts op mix, load-use pairs, taken branches and misses of each level while the functional interpreter runs,
+// and computes the cycles of the pipeline from them and the storage latencies instead of simulating it
+// Costs follow Machine: a load-use pair and a taken jump or branch stall one cycle each, and an access stalls
+// its access time minus one cycle, which is the sum of bus and hit latencies of the levels it reaches
+class CPIEstimator {
+private:
+    EstimatorCache caches[STORAGE_LEVEL_MEMORY];
+    StorageLatency memory_latency;
+    int64_t memory_accesses;
+    int64_t op_counts[NUM_OF_OP_TYPES];
+    int64_t instructions;
+    int64_t load_use;                   // instructions right after a load, the pipeline stalls them all
+    int64_t branches;
+    int64_t taken_branches;
+    int64_t jumps;
+    int32_t last_load_rd;               // register loaded by last instruction, REG_zero if it was no load
+
+    // Send a request to a level, one of STORAGE_LEVEL_*, misses and writebacks are sent on to the level below
+    void Access(int level, uint64_t address, bool read);
+
+public:
+    // Levels have the configs and latencies of config.cpp
+    CPIEstimator();
+
+    ~CPIEstimator();
+
+    // Replace config and latency of a level, one of STORAGE_LEVEL_*, config is unused for memory
+    // Should be called before the first instruction is observed
+    void SetLevel(int level, CacheConfig config, StorageLatency latency);
+
+    // Account an instruction about to be executed at pc, registers hold the values before it is executed
+    void Observe(const Instruction *instruction, int64_t pc, int64_t length, const int64_t *registers);
+
+    // Cycles and stalls the pipeline would take for the instructions observed
+    void Estimate(CPIEstimate &estimate);
+
+    // Print op mix, misses and estimated CPI, and compare with the counters of the pipeline if detailed is not NULL
+    void PrintReport(FILE *file, Stats *detailed);
+};
+
+#endif //RISC_V_SIMULATOR_CPI_ESTIMATOR_H
@@ -0,0 +1,131 @@
+//
+// Name: csr
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "machine.h"
+#include "csr.h"
+#include "stats.h"
+
+int64_t Machine::ExecuteCSR(Instruction *instruction, int64_t value_rs1) {
+    int32_t csr = Decode_csr(instruction->binary_code);
+    int64_t old_value, new_value;
+    bool write;
+
+    if (!this->ReadCSR(csr, &old_value)) {
+        FATAL("Invalid CSR %x at pc %lx\n", csr, instruction->instr_pc);
+    }
+
+    // Immediate variants use rs1 field as a 5-bit zero-extended source
+    int64_t source = value_rs1;
+    if (instruction->op_type == OP_CSRRWI || instruction->op_type == OP_CSRRSI ||
+        instruction->op_type == OP_CSRRCI)
+        source = instruction->rs1;
+
+    switch (instruction->op_type) {
+        case OP_CSRRW:
+        case OP_CSRRWI:
+            new_value = source;
+            write = true;
+            break;
+        case OP_CSRRS:
+        case OP_CSRRSI:
+            new_value = old_value | source;
+            write = instruction->rs1 != 0;
+            break;
+        case OP_CSRRC:
+        case OP_CSRRCI:
+            new_value = old_value & ~source;
+            write = instruction->rs1 != 0;
+            break;
+        default: FATAL("Invalid CSR op type %d\n", instruction->op_type);
+    }
+
+    if (write && !this->WriteCSR(csr, new_value)) {
+        FATAL("CSR %x is read only, pc %lx\n", csr, instruction->instr_pc);
+    }
+    return old_value;
+}
+
+int64_t Machine::ReadCounter(int32_t counter) {
+    switch (counter) {
+        case COUNTER_CYCLE:
+        case COUNTER_TIME:
+            // Simulated time advances one tick per cycle
+            return stats->GetCycles();
+        case COUNTER_INSTRET:
+            // Instruction in Execute stage has been counted but not retired
+            return stats->GetInstructions() - 1;
+        default:
+            return this->ReadHPMEvent(hpm_events[counter]);
+    }
+}
+
+int64_t Machine::ReadHPMEvent(int64_t event) {
+    StorageStats storage_stats;
+    switch (event) {
+        case HPM_EVENT_STALL_CTRL:
+            return stats->GetStallsByCtrl();
+        case HPM_EVENT_STALL_DATA:
+            return stats->GetStallsByData();
+        case HPM_EVENT_STALL_MEMORY:
+            return stats->GetStallsByMemory();
+        case HPM_EVENT_L1_ACCESS:
+            l1->GetStats(storage_stats);
+            return storage_stats.access_counter;
+        case HPM_EVENT_L1_MISS:
+            l1->GetStats(storage_stats);
+            return storage_stats.miss_num;
+        case HPM_EVENT_L2_ACCESS:
+            l2->GetStats(storage_stats);
+            return storage_stats.access_counter;
+        case HPM_EVENT_L2_MISS:
+            l2->GetStats(storage_stats);
+            return storage_stats.miss_num;
+        case HPM_EVENT_L3_ACCESS:
+            l3->GetStats(storage_stats);
+            return storage_stats.access_counter;
+        case HPM_EVENT_L3_MISS:
+            l3->GetStats(storage_stats);
+            return storage_stats.miss_num;
+        case HPM_EVENT_MEMORY_ACCESS:
+            memory->GetStats(storage_stats);
+            return storage_stats.access_counter;
+        default:
+            // Unknown events count nothing
+            return 0;
+    }
+}
+
+bool Machine::ReadCSR(int32_t csr, int64_t *value) {
+    if ((csr >= CSR_CYCLE && csr <= CSR_HPMCOUNTER31) || csr == CSR_MCYCLE || csr == CSR_MINSTRET ||
+        (csr >= CSR_MHPMCOUNTER3 && csr <= CSR_MHPMCOUNTER31)) {
+        int32_t counter = csr & (NUM_OF_COUNTERS - 1);
+        *value = this->ReadCounter(counter) - counter_offsets[counter];
+        return true;
+    }
+    if (csr >= CSR_MHPMEVENT3 && csr <= CSR_MHPMEVENT31) {
+        *value = hpm_events[csr & (NUM_OF_COUNTERS - 1)];
+        return true;
+    }
+    return false;
+}
+
+bool Machine::WriteCSR(int32_t csr, int64_t value) {
+    // Machine counters are writable, user counters are their read only shadows
+    if (csr == CSR_MCYCLE || csr == CSR_MINSTRET || (csr >= CSR_MHPMCOUNTER3 && csr <= CSR_MHPMCOUNTER31)) {
+        int32_t counter = csr & (NUM_OF_COUNTERS - 1);
+        counter_offsets[counter] = this->ReadCounter(counter) - value;
+        return true;
+    }
+    if (csr >= CSR_MHPMEVENT3 && csr <= CSR_MHPMEVENT31) {
+        // Counter restarts from zero when a new event is selected
+        int32_t counter = csr & (NUM_OF_COUNTERS - 1);
+        hpm_events[counter] = value;
+        counter_offsets[counter] = this->ReadHPMEvent(value);
+        return true;
+    }
+    return false;
+}
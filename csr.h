@@ -0,0 +1,44 @@
+//
+// Name: csr
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_CSR_H
+#define RISC_V_SIMULATOR_CSR_H
+
+// CSR address macro definitions
+#define CSR_MHPMEVENT3 0x323
+#define CSR_MHPMEVENT31 0x33F
+#define CSR_MCYCLE 0xB00
+#define CSR_MINSTRET 0xB02
+#define CSR_MHPMCOUNTER3 0xB03
+#define CSR_MHPMCOUNTER31 0xB1F
+#define CSR_CYCLE 0xC00
+#define CSR_TIME 0xC01
+#define CSR_INSTRET 0xC02
+#define CSR_HPMCOUNTER3 0xC03
+#define CSR_HPMCOUNTER31 0xC1F
+
+// Performance counter indexes, which are the low 5 bits of counter CSR addresses
+#define COUNTER_CYCLE 0
+#define COUNTER_TIME 1
+#define COUNTER_INSTRET 2
+#define COUNTER_HPM3 3
+#define NUM_OF_COUNTERS 32
+
+// Events which can be selected by mhpmevent CSRs
+#define HPM_EVENT_NONE 0
+#define HPM_EVENT_STALL_CTRL 1
+#define HPM_EVENT_STALL_DATA 2
+#define HPM_EVENT_STALL_MEMORY 3
+#define HPM_EVENT_L1_ACCESS 4
+#define HPM_EVENT_L1_MISS 5
+#define HPM_EVENT_L2_ACCESS 6
+#define HPM_EVENT_L2_MISS 7
+#define HPM_EVENT_L3_ACCESS 8
+#define HPM_EVENT_L3_MISS 9
+#define HPM_EVENT_MEMORY_ACCESS 10
+
+#endif //RISC_V_SIMULATOR_CSR_H
@@ -7,64 +7,175 @@
 
 #include "elf_reader.h"
 #include "machine.h"
-#include <fstream>
+#include "trace.h"
+#include <vector>
 #include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+void SymbolTable::AddSymbol(int64_t address, int64_t size, const char *name) {
+    FunctionSymbol symbol;
+    symbol.address = address;
+    symbol.size = size;
+    symbol.name = name;
+
+    // Aliases share the same address, keep the first one
+    this->symbols.insert(std::make_pair(address, symbol));
+}
+
+const FunctionSymbol *SymbolTable::FindFunction(int64_t address) const {
+    // Find the last symbol starts at or before given address
+    std::map<int64_t, FunctionSymbol>::const_iterator it = this->symbols.upper_bound(address);
+    if (it == this->symbols.begin())
+        return NULL;
+    it--;
+
+    // Symbols without size cover everything until next symbol
+    if (it->second.size != 0 && address >= it->second.address + it->second.size)
+        return NULL;
+    return &it->second;
+}
+
+int64_t SymbolTable::Size() const {
+    return (int64_t) this->symbols.size();
+}
 
 bool Machine::LoadExecutableFile(const char *file_name) {
-    // Local variables
-    std::ifstream executable_file;
-    Elf64_Ehdr elf_header;
-    Elf64_Phdr program_header;
-    int64_t value64;
+    // Map the whole executable file, headers and segments are read from the mapping in place
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to open executable file %s\n", file_name);
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || file_stat.st_size < (off_t) sizeof(Elf64_Ehdr)) {
+        fprintf(stderr, "Executable file %s is not an ELF file\n", file_name);
+        close(fd);
+        return false;
+    }
+    int64_t file_size = file_stat.st_size;
+    const char *file = (const char *) mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        fprintf(stderr, "Unable to map executable file %s\n", file_name);
+        return false;
+    }
 
-    // Open executable file
-    executable_file.open(file_name, std::ios::in | std::ios::binary);
+    bool loaded = this->LoadExecutable(file, file_size);
+    munmap((void *) file, file_size);
+    if (!loaded)
+        fprintf(stderr, "Executable file %s is not a RISC-V executable or has a segment out of file\n", file_name);
+    return loaded;
+}
 
+bool Machine::LoadExecutable(const char *file, int64_t file_size) {
     // Read elf header and check if header info is compatible
-    executable_file.read((char *) &elf_header, sizeof(Elf64_Ehdr));
-    ASSERT(elf_header.e_ident[EI_MAG0] == 0x7F
-           && elf_header.e_ident[EI_MAG1] == 'E'
-           && elf_header.e_ident[EI_MAG2] == 'L'
-           && elf_header.e_ident[EI_MAG3] == 'F');
-    ASSERT(elf_header.e_type == ET_EXEC);
-    ASSERT(elf_header.e_machine == EM_RISCV);
+    if (file_size < (int64_t) sizeof(Elf64_Ehdr))
+        return false;
+    const Elf64_Ehdr *elf_header = (const Elf64_Ehdr *) file;
+    if (elf_header->e_ident[EI_MAG0] != 0x7F || elf_header->e_ident[EI_MAG1] != 'E' ||
+        elf_header->e_ident[EI_MAG2] != 'L' || elf_header->e_ident[EI_MAG3] != 'F' ||
+        elf_header->e_ident[EI_CLASS] != ELFCLASS64 || elf_header->e_type != ET_EXEC ||
+        elf_header->e_machine != EM_RISCV)
+        return false;
+    if (elf_header->e_phoff + (int64_t) elf_header->e_phentsize * elf_header->e_phnum > file_size)
+        return false;
+
+    // Use pre-decoded image of the same contents if there is one
+    uint64_t hash = 0;
+    bool image_loaded = false;
+    if (image_cache != NULL) {
+        hash = ImageCache::Hash(file, file_size);
+        image_loaded = image_cache->Open(hash, file_size);
+    }
 
     // Set PC as program entry
-    this->reg_pc = elf_header.e_entry;
+    this->reg_pc = elf_header->e_entry;
+    this->bubble_pc = elf_header->e_entry;
     this->registers[REG_sp] = (int64_t) (1) << 48;
-    DEBUG("Number of program headers: %d\n", elf_header.e_phnum);
-    DEBUG("Offset to program header table: %ld\n", elf_header.e_phoff);
-
-    // Read each segment and load into memory
-    DEBUG("\nSegment table:\n")
-    for (int i = 0; i < elf_header.e_phnum; i++) {
-        // Read program header
-        executable_file.seekg(elf_header.e_phoff + elf_header.e_phentsize * i, std::ios::beg);
-        executable_file.read((char *) &program_header, sizeof(Elf64_Phdr));
-        DEBUG("Segment %d, address: %16.16lx, offset: %16.16lx\n", i, program_header.p_vaddr, program_header.p_offset);
-        DEBUG("\t\tfile size: %16.16lx, memory size: %16.16lx\n", program_header.p_filesz, program_header.p_memsz);
-
-        // Load segment into memory
-        executable_file.seekg(program_header.p_offset, std::ios::beg);
-        int vi;
-        for (vi = 0; vi < program_header.p_filesz / 8; vi++) {
-            executable_file.read((char *) &value64, 8);
-            this->main_memory->WriteMemory(program_header.p_vaddr + 8 * vi, 8, value64);
+    TRACE(LOADER_PROGRAM_HEADERS, elf_header->e_phnum);
+    TRACE(LOADER_PROGRAM_HEADER_OFFSET, elf_header->e_phoff);
+
+    if (image_loaded) {
+        TRACE(LOADER_IMAGE, hash);
+        image_cache->LoadSegments(this->main_memory);
+        this->SetHeapPointer(image_cache->HeapStart());
+    } else {
+        // Load each PT_LOAD segment into memory
+        TRACE(LOADER_SEGMENT_TABLE);
+        std::vector<ImageSegment> loaded_segments;
+        int64_t heap_address = 0;
+        for (int i = 0; i < elf_header->e_phnum; i++) {
+            const Elf64_Phdr *program_header = (const Elf64_Phdr *) (file + elf_header->e_phoff +
+                                                                     elf_header->e_phentsize * i);
+            TRACE(LOADER_SEGMENT, i, program_header->p_type, program_header->p_vaddr, program_header->p_offset);
+            TRACE(LOADER_SEGMENT_SIZE, program_header->p_filesz, program_header->p_memsz);
+            if (program_header->p_type != PT_LOAD)
+                continue;
+            if (program_header->p_offset + program_header->p_filesz > (uint64_t) file_size ||
+                program_header->p_filesz > program_header->p_memsz)
+                return false;
+
+            // Copy file contents page by page, bss after them is left to pages zero filled on first access
+            this->main_memory->WriteBlock(program_header->p_vaddr, file + program_header->p_offset,
+                                          program_header->p_filesz);
+
+            // Heap starts after the highest segment
+            int64_t segment_end = RoundUp(program_header->p_vaddr + program_header->p_memsz, PageSizeBitsNum);
+            if (segment_end > heap_address)
+                heap_address = segment_end;
+
+            ImageSegment segment;
+            segment.address = program_header->p_vaddr;
+            segment.size = program_header->p_filesz;
+            segment.executable = (program_header->p_flags & PF_X) != 0;
+            loaded_segments.push_back(segment);
         }
+        this->SetHeapPointer(heap_address);
 
-        if (vi * 8 < program_header.p_filesz) {
-            // p_filesz is not a multiplier of 8
-            // There are several bytes that has not been load into memory
-            for (vi = vi * 8; vi < program_header.p_filesz; vi++) {
-                executable_file.read((char *) &value64, 1);
-                this->main_memory->WriteMemory(program_header.p_vaddr + vi, 1, value64);
-            }
+        // Write image for later runs
+        if (image_cache != NULL) {
+            image_cache->Build(hash, file_size, elf_header->e_entry, heap_address, loaded_segments,
+                               this->main_memory);
+            image_cache->Open(hash, file_size);
         }
+    }
+
+    // Read function symbols from .symtab, which are used by profiler
+    for (int i = 0; i < elf_header->e_shnum; i++) {
+        if (elf_header->e_shoff + (int64_t) elf_header->e_shentsize * (i + 1) > file_size)
+            break;
+        const Elf64_Shdr *section_header = (const Elf64_Shdr *) (file + elf_header->e_shoff +
+                                                                 elf_header->e_shentsize * i);
+        if (section_header->sh_type != SHT_SYMTAB || section_header->sh_entsize != sizeof(Elf64_Sym))
+            continue;
+        if (section_header->sh_link >= elf_header->e_shnum ||
+            section_header->sh_offset + section_header->sh_size > (uint64_t) file_size)
+            continue;
+
+        // The linked string table must end with NUL so names can be used in place
+        const Elf64_Shdr *string_table_header = (const Elf64_Shdr *) (file + elf_header->e_shoff +
+                                                                      elf_header->e_shentsize *
+                                                                      section_header->sh_link);
+        if (string_table_header->sh_size == 0 ||
+            string_table_header->sh_offset + string_table_header->sh_size > (uint64_t) file_size)
+            continue;
+        const char *string_table = file + string_table_header->sh_offset;
+        if (string_table[string_table_header->sh_size - 1] != '\0')
+            continue;
 
-        if (i == elf_header.e_phnum - 1) {
-            // This is the last segment, the heap pointer should be initialized
-            int64_t heap_address = RoundUp(program_header.p_vaddr + program_header.p_memsz, PageSizeBitsNum);
-            this->SetHeapPointer(heap_address);
+        const Elf64_Sym *symbols = (const Elf64_Sym *) (file + section_header->sh_offset);
+        for (int si = 0; si < section_header->sh_size / sizeof(Elf64_Sym); si++) {
+            const Elf64_Sym *symbol = &symbols[si];
+            if (ELF64_ST_TYPE(symbol->st_info) != STT_FUNC || symbol->st_shndx == SHN_UNDEF)
+                continue;
+            if (symbol->st_name >= string_table_header->sh_size)
+                continue;
+            this->symbol_table->AddSymbol(symbol->st_value, symbol->st_size, &string_table[symbol->st_name]);
         }
     }
+    TRACE(LOADER_SYMBOLS, this->symbol_table->Size());
+    return true;
 }
@@ -9,8 +9,31 @@
 #define RISC_V_SIMULATOR_ELF_READER_H
 
 #include "utility.h"
+#include <map>
+#include <string>
 
 #define EM_RISCV 0xF3
 
+// Function symbol read from .symtab
+typedef struct FunctionSymbol_ {
+    int64_t address;                // start address of the function
+    int64_t size;                   // size of the function in bytes, may be 0
+    std::string name;               // name of the function
+} FunctionSymbol;
+
+class SymbolTable {
+private:
+    std::map<int64_t, FunctionSymbol> symbols;  // function symbols indexed by start address
+
+public:
+    // Add a function symbol
+    void AddSymbol(int64_t address, int64_t size, const char *name);
+
+    // Find the function that contains given address, return NULL if not found
+    const FunctionSymbol *FindFunction(int64_t address) const;
+
+    // Number of function symbols
+    int64_t Size() const;
+};
 
 #endif //RISC_V_SIMULATOR_ELF_READER_H
@@ -9,6 +9,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/time.h>
 
 #define RISCV_SYSCALL_EXIT 0
 #define RISCV_SYSCALL_PCHAR 1
@@ -23,86 +30,339 @@
 #define RISCV_SYSCALL_RAND 10
 #define RISCV_SYSCALL_MALLOC 11
 #define RISCV_SYSCALL_TIME 12
+#define RISCV_SYSCALL_MEMCPY 13
+#define RISCV_SYSCALL_MEMSET 14
+#define RISCV_SYSCALL_MEMMOVE 15
+#define RISCV_SYSCALL_FREE 16
 
-void Machine::HandleSystemCall(Instruction *instruction, int64_t system_call_number, int64_t system_call_arg) {
+// System calls of RISC-V Linux used by newlib, results are returned in a0
+#define RISCV_SYSCALL_LINUX_OPENAT 56
+#define RISCV_SYSCALL_LINUX_CLOSE 57
+#define RISCV_SYSCALL_LINUX_LSEEK 62
+#define RISCV_SYSCALL_LINUX_READ 63
+#define RISCV_SYSCALL_LINUX_WRITE 64
+#define RISCV_SYSCALL_LINUX_FSTAT 80
+#define RISCV_SYSCALL_LINUX_EXIT 93
+#define RISCV_SYSCALL_LINUX_EXIT_GROUP 94
+#define RISCV_SYSCALL_LINUX_GETTIMEOFDAY 169
+#define RISCV_SYSCALL_LINUX_BRK 214
+
+void Machine::HandleSystemCall(Instruction *instruction, int64_t system_call_number, const int64_t *args) {
     // TODO: System call handler
-    int8_t buffer[2048];
-    int32_t i;
+    int64_t system_call_arg = args[0];
+    int64_t result = 0;
+    RiscvStat stat;
+    int64_t now;
+    std::string text;
+    int64_t span_size;
+    int32_t c;
+    char *span;
     union {
         int8_t value_8;
         int32_t value_32;
         int64_t value_64;
     } temp_value;
+    if (hooks != NULL && hooks->system_call != NULL &&
+        hooks->system_call(hooks->system_call_data, instruction->instr_pc, system_call_number, args))
+        stop_requested = true;
     switch (system_call_number) {
         case RISCV_SYSCALL_EXIT:
-            this->exit_flag = true;
-            printf("\nProcess finished with exit code %d\n", (int32_t) system_call_arg);
+            this->Exit(system_call_arg);
             break;
         case RISCV_SYSCALL_PCHAR:
-            putchar((int8_t) system_call_arg);
+            temp_value.value_8 = (int8_t) system_call_arg;
+            console->Write((const char *) &temp_value.value_8, 1);
             break;
         case RISCV_SYSCALL_PINT:
-            printf("%d", (int32_t) system_call_arg);
+            console->Printf("%d", (int32_t) system_call_arg);
             break;
         case RISCV_SYSCALL_PLONG:
-            printf("%ld", (int64_t) system_call_arg);
+            console->Printf("%ld", (int64_t) system_call_arg);
             break;
         case RISCV_SYSCALL_PSTRING:
-            // Copy string from the main memory of simulator to buffer
-            i = 0;
-            do {
-                this->main_memory->ReadMemory(system_call_arg + i, 1, &temp_value.value_64);
-                buffer[i] = temp_value.value_8;
-            } while (buffer[i++] != '\0');
-
-            printf("%s", buffer);
+            // Write string to console directly from the main memory of simulator, a page at a time
+            for (;;) {
+                span = this->main_memory->GetSpan(system_call_arg, &span_size);
+                char *end = (char *) memchr(span, '\0', span_size);
+                if (end != NULL) {
+                    console->Write(span, end - span);
+                    break;
+                }
+                console->Write(span, span_size);
+                system_call_arg += span_size;
+            }
             break;
         case RISCV_SYSCALL_RCHAR:
-            temp_value.value_32 = getchar();
+            // Prompts printed by the program must be visible before it waits for input
+            console->Flush();
+            temp_value.value_64 = this->LogValue(system_call_number, this->IsReplaying() ? 0 : getc(input));
             this->main_memory->WriteMemory(system_call_arg, 1, temp_value.value_64);
+            this->HostWritten(system_call_arg, 1);
             break;
         case RISCV_SYSCALL_RINT:
-            scanf("%d", &temp_value.value_32);
+            console->Flush();
+            temp_value.value_64 = 0;
+            if (!this->IsReplaying())
+                fscanf(input, "%d", &temp_value.value_32);
+            temp_value.value_64 = this->LogValue(system_call_number, temp_value.value_32);
             this->main_memory->WriteMemory(system_call_arg, 4, temp_value.value_64);
+            this->HostWritten(system_call_arg, 4);
             break;
         case RISCV_SYSCALL_RLONG:
-            scanf("%d", &temp_value.value_64);
+            console->Flush();
+            temp_value.value_64 = 0;
+            if (!this->IsReplaying())
+                fscanf(input, "%ld", &temp_value.value_64);
+            temp_value.value_64 = this->LogValue(system_call_number, temp_value.value_64);
             this->main_memory->WriteMemory(system_call_arg, 8, temp_value.value_64);
+            this->HostWritten(system_call_arg, 8);
             break;
         case RISCV_SYSCALL_RSTRING:
-            // Read string to buffer from stdin
-            scanf("%s", buffer);
-            // Copy string from buffer to the main memory of simulator
-            i = 0;
-            do {
-                this->main_memory->WriteMemory(system_call_arg + i, 1, (int64_t) buffer[i]);
-            } while (buffer[i++] != '\0');
+            console->Flush();
+            // Read a whitespace delimited word from input like scanf("%s"), without limit on its length
+            if (!this->IsReplaying()) {
+                while ((c = getc(input)) != EOF && isspace(c));
+                while (c != EOF && !isspace(c)) {
+                    text += (char) c;
+                    c = getc(input);
+                }
+                if (c != EOF)
+                    ungetc(c, input);
+            }
+            if (syscall_log != NULL)
+                syscall_log->Data(system_call_number, text);
+            // Copy string with its terminating NUL to the main memory of simulator
+            this->main_memory->WriteBlock(system_call_arg, text.c_str(), text.size() + 1);
+            this->HostWritten(system_call_arg, text.size() + 1);
             break;
         case RISCV_SYSCALL_SRAND:
-            srand((uint32_t) system_call_arg);
+            srandom_r((uint32_t) system_call_arg, &random_data);
             break;
         case RISCV_SYSCALL_RAND:
-            instruction->write_back_value = (int64_t) rand();
+            random_r(&random_data, &temp_value.value_32);
+            instruction->write_back_value = this->LogValue(system_call_number, temp_value.value_32);
             instruction->write_reg = true;
             instruction->rd = REG_a7;
             break;
         case RISCV_SYSCALL_MALLOC:
-            instruction->write_back_value = this->heap_pointer;
+            instruction->write_back_value = heap->Allocate(system_call_arg);
             instruction->write_reg = true;
             instruction->rd = REG_a7;
-            for (int i = 0; i < RoundUp(system_call_arg, PageSizeBitsNum) >> PageSizeBitsNum; i++) {
-                this->main_memory->AllocatePage(this->heap_pointer);
-                this->heap_pointer += PageSize;
-            }
+            break;
+        case RISCV_SYSCALL_FREE:
+            // Pages of a freed block may be returned to memory, forget code decoded from them
+            this->HostWritten(system_call_arg, heap->Free(system_call_arg));
             break;
         case RISCV_SYSCALL_TIME:
-            instruction->write_back_value = time(NULL);
+            instruction->write_back_value = this->LogValue(system_call_number, this->CurrentTime() / 1000000);
             instruction->write_reg = true;
             instruction->rd = REG_a7;
             break;
-        default: FATAL("Invalid system call number: %d\n", system_call_number);
+        case RISCV_SYSCALL_MEMCPY:
+        case RISCV_SYSCALL_MEMMOVE:
+            // a0: destination, a1: source, a2: size, both are copied with memmove semantics on host
+            if (this->accel_cache) {
+                this->access_pc = instruction->instr_pc;
+                this->AccessCacheBlock(args[1], args[2], 1);
+                this->AccessCacheBlock(args[0], args[2], 0);
+            }
+            this->main_memory->MoveBlock(args[0], args[1], args[2]);
+            this->HostWritten(args[0], args[2]);
+            break;
+        case RISCV_SYSCALL_MEMSET:
+            // a0: address, a1: value, a2: size
+            if (this->accel_cache) {
+                this->access_pc = instruction->instr_pc;
+                this->AccessCacheBlock(args[0], args[2], 0);
+            }
+            this->main_memory->FillBlock(args[0], (int8_t) args[1], args[2]);
+            this->HostWritten(args[0], args[2]);
+            break;
+        case RISCV_SYSCALL_LINUX_OPENAT:
+            result = this->OpenFile(args[0], args[1], args[2], args[3]);
+            break;
+        case RISCV_SYSCALL_LINUX_CLOSE:
+            result = sandbox->Close(args[0]);
+            break;
+        case RISCV_SYSCALL_LINUX_LSEEK:
+            result = sandbox->Seek(args[0], args[1], args[2]);
+            break;
+        case RISCV_SYSCALL_LINUX_READ:
+            result = this->LogReadFile(system_call_number, args[0], args[1], args[2]);
+            break;
+        case RISCV_SYSCALL_LINUX_WRITE:
+            result = this->WriteFile(args[0], args[1], args[2]);
+            break;
+        case RISCV_SYSCALL_LINUX_FSTAT:
+            // Inode and times of files differ between runs
+            result = this->LogValue(system_call_number, this->IsReplaying() ? 0 : sandbox->Stat(args[0], &stat));
+            if (result == 0) {
+                if (syscall_log != NULL) {
+                    text.assign((const char *) &stat, sizeof(stat));
+                    syscall_log->Data(system_call_number, text);
+                    ASSERT(text.size() == sizeof(stat));
+                    memcpy(&stat, text.data(), sizeof(stat));
+                }
+                this->main_memory->WriteBlock(args[1], &stat, sizeof(stat));
+                this->HostWritten(args[1], sizeof(stat));
+            }
+            break;
+        case RISCV_SYSCALL_LINUX_EXIT:
+        case RISCV_SYSCALL_LINUX_EXIT_GROUP:
+            this->Exit(args[0]);
+            break;
+        case RISCV_SYSCALL_LINUX_GETTIMEOFDAY:
+            now = this->LogValue(system_call_number, this->CurrentTime());
+            if (args[0] != 0) {
+                this->main_memory->WriteMemory(args[0], 8, now / 1000000);
+                this->main_memory->WriteMemory(args[0] + 8, 8, now % 1000000);
+                this->HostWritten(args[0], 16);
+            }
+            break;
+        case RISCV_SYSCALL_LINUX_BRK:
+            result = this->SetBreak(args[0]);
+            break;
+        default: FATAL("Invalid system call number: %ld\n", system_call_number);
+    }
+
+    if (system_call_number >= RISCV_SYSCALL_LINUX_OPENAT) {
+        instruction->write_back_value = result;
+        instruction->write_reg = true;
+        instruction->rd = REG_a0;
     }
 }
 
+void Machine::Exit(int64_t exit_code) {
+    this->exit_flag = true;
+    this->exit_code = exit_code;
+    console->Flush();
+    if (exit_message)
+        printf("\nProcess finished with exit code %d\n", (int32_t) exit_code);
+}
 
+int64_t Machine::WriteFile(int64_t fd, int64_t address, int64_t size) {
+    int host_fd = sandbox->HostFd(fd);
+    if (host_fd < 0)
+        return -EBADF;
+    if (size < 0)
+        return -EINVAL;
 
+    // Program output on stdout goes through console buffer, stderr is written after it
+    if (host_fd == STDOUT_FILENO) {
+        for (int64_t written = 0; written < size;) {
+            int64_t span_size;
+            char *span = this->main_memory->GetSpan(address + written, &span_size);
+            if (span_size > size - written)
+                span_size = size - written;
+            console->Write(span, span_size);
+            written += span_size;
+        }
+        return size;
+    }
+    if (host_fd == STDERR_FILENO)
+        console->Flush();
+
+    int64_t written = 0;
+    while (written < size) {
+        int64_t span_size;
+        char *span = this->main_memory->GetSpan(address + written, &span_size);
+        if (span_size > size - written)
+            span_size = size - written;
+        ssize_t count = write(host_fd, span, span_size);
+        if (count < 0)
+            return written > 0 ? written : -errno;
+        written += count;
+        if (count < span_size)
+            break;
+    }
+    return written;
+}
+
+int64_t Machine::ReadFile(int64_t fd, int64_t address, int64_t size) {
+    int host_fd = sandbox->HostFd(fd);
+    if (host_fd < 0)
+        return -EBADF;
+    if (size < 0)
+        return -EINVAL;
+
+    // Prompts printed by the program must be visible before it waits for input
+    if (fd == STDIN_FILENO)
+        console->Flush();
+
+    int64_t read_size = 0;
+    while (read_size < size) {
+        int64_t span_size;
+        char *span = this->main_memory->GetSpan(address + read_size, &span_size);
+        if (span_size > size - read_size)
+            span_size = size - read_size;
+        ssize_t count = read(host_fd, span, span_size);
+        if (count < 0)
+            return read_size > 0 ? read_size : -errno;
+        this->HostWritten(address + read_size, count);
+        read_size += count;
+        // Short read means end of file or no more input available now
+        if (count < span_size)
+            break;
+    }
+    return read_size;
+}
+
+int64_t Machine::OpenFile(int64_t dirfd, int64_t path_address, int64_t flags, int64_t mode) {
+    int64_t length = this->main_memory->FindByte(path_address, GUEST_PATH_MAX, '\0');
+    if (length < 0)
+        return -ENAMETOOLONG;
+    std::vector<char> path(length + 1);
+    this->main_memory->ReadBlock(path_address, &path[0], length + 1);
+    return sandbox->Open(dirfd, &path[0], flags, mode);
+}
+
+bool Machine::IsReplaying() {
+    return syscall_log != NULL && syscall_log->IsReplaying();
+}
+
+int64_t Machine::LogValue(int64_t number, int64_t value) {
+    if (syscall_log == NULL)
+        return value;
+    return syscall_log->Value(number, value);
+}
+
+int64_t Machine::LogReadFile(int64_t number, int64_t fd, int64_t address, int64_t size) {
+    if (syscall_log == NULL)
+        return this->ReadFile(fd, address, size);
+
+    std::string data;
+    if (!syscall_log->IsReplaying()) {
+        int64_t result = this->ReadFile(fd, address, size);
+        syscall_log->Value(number, result);
+        if (result > 0) {
+            data.resize(result);
+            this->main_memory->ReadBlock(address, &data[0], result);
+        }
+        syscall_log->Data(number, data);
+        return result;
+    }
+
+    int64_t result = syscall_log->Value(number, 0);
+    syscall_log->Data(number, data);
+    if (data.empty())
+        return result;
+    if (fd == STDIN_FILENO)
+        console->Flush();
+    this->main_memory->WriteBlock(address, data.data(), data.size());
+    this->HostWritten(address, data.size());
+    // Keep offset of file where it was in recorded run, so later lseek results are the same
+    int host_fd = sandbox->HostFd(fd);
+    if (host_fd > STDERR_FILENO)
+        lseek(host_fd, data.size(), SEEK_CUR);
+    return result;
+}
+
+int64_t Machine::CurrentTime() {
+    if (clock_frequency > 0) {
+        int64_t cycles = stats->GetCycles();
+        return cycles / clock_frequency * 1000000 + cycles % clock_frequency * 1000000 / clock_frequency;
+    }
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec * 1000000 + now.tv_usec;
+}
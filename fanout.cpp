@@ -0,0 +1,217 @@
+//
+// Name: fanout
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "fanout.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static const char *storage_level_keys[NUM_OF_STORAGE_LEVELS] = {"l1", "l2", "l3", "mem"};
+
+// Reset config to change nothing
+static void ClearConfig(FanoutConfig *config) {
+    for (int level = 0; level < NUM_OF_STORAGE_LEVELS; level++)
+        config->custom_latency[level] = false;
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        config->write_through[level] = -1;
+        config->write_allocate[level] = -1;
+    }
+}
+
+ForkFanout::ForkFanout() {
+    FanoutConfig base;
+    base.name = "base";
+    ClearConfig(&base);
+    configs.push_back(base);
+}
+
+bool ForkFanout::AddConfig(const char *spec) {
+    FanoutConfig config;
+    ClearConfig(&config);
+    const char *colon = strchr(spec, ':');
+    if (colon == NULL || colon == spec)
+        return false;
+    config.name.assign(spec, colon - spec);
+
+    // Latencies not given keep the values of the parent, they are filled when the child starts
+    std::string fields(colon + 1);
+    size_t start = 0;
+    while (start < fields.size()) {
+        size_t end = fields.find(',', start);
+        if (end == std::string::npos)
+            end = fields.size();
+        std::string field = fields.substr(start, end - start);
+        start = end + 1;
+
+        size_t dash = field.find('-'), equal = field.find('=');
+        if (dash == std::string::npos || equal == std::string::npos || dash > equal)
+            return false;
+        std::string level_key = field.substr(0, dash), key = field.substr(dash + 1, equal - dash - 1);
+        std::string value = field.substr(equal + 1);
+        int level = -1;
+        for (int i = 0; i < NUM_OF_STORAGE_LEVELS; i++)
+            if (level_key == storage_level_keys[i])
+                level = i;
+        if (level < 0 || value.empty())
+            return false;
+
+        if (key == "latency" || key == "bus") {
+            char *number_end;
+            long cycles = strtol(value.c_str(), &number_end, 10);
+            if (*number_end != '\0' || cycles < 0)
+                return false;
+            if (!config.custom_latency[level]) {
+                config.custom_latency[level] = true;
+                config.latency[level].hit_latency = -1;
+                config.latency[level].bus_latency = -1;
+            }
+            if (key == "latency")
+                config.latency[level].hit_latency = (int) cycles;
+            else
+                config.latency[level].bus_latency = (int) cycles;
+        } else if (key == "write" && level != STORAGE_LEVEL_MEMORY) {
+            if (value == "back")
+                config.write_through[level] = 0;
+            else if (value == "through")
+                config.write_through[level] = 1;
+            else
+                return false;
+        } else if (key == "allocate" && level != STORAGE_LEVEL_MEMORY) {
+            if (value == "yes")
+                config.write_allocate[level] = 1;
+            else if (value == "no")
+                config.write_allocate[level] = 0;
+            else
+                return false;
+        } else {
+            return false;
+        }
+    }
+    configs.push_back(config);
+    return true;
+}
+
+void ForkFanout::RunChild(Machine *machine, const FanoutConfig &config, int fd) {
+    double start_time = HostTime();
+    // Descriptions of host files are shared after fork, children reading the same file would race on its offset
+    if (!machine->ReopenGuestFiles()) {
+        fprintf(stderr, "Unable to reopen files of child %s\n", config.name.c_str());
+        _exit(1);
+    }
+    for (int level = 0; level < NUM_OF_STORAGE_LEVELS; level++) {
+        if (!config.custom_latency[level])
+            continue;
+        StorageLatency latency;
+        machine->GetStorageLatency(level, latency);
+        if (config.latency[level].hit_latency >= 0)
+            latency.hit_latency = config.latency[level].hit_latency;
+        if (config.latency[level].bus_latency >= 0)
+            latency.bus_latency = config.latency[level].bus_latency;
+        machine->SetStorageLatency(level, latency);
+    }
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++) {
+        if (config.write_through[level] < 0 && config.write_allocate[level] < 0)
+            continue;
+        CacheConfig cache_config;
+        machine->GetCacheConfig(level, cache_config);
+        machine->SetWritePolicy(level,
+                                config.write_through[level] < 0 ? cache_config.write_through
+                                                                : config.write_through[level],
+                                config.write_allocate[level] < 0 ? cache_config.write_allocate
+                                                                 : config.write_allocate[level]);
+    }
+
+    // Children run at the same time, so their program output is dropped
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0)
+        machine->SetConsole(null_fd, DEFAULT_CONSOLE_BUFFER_SIZE, CONSOLE_FLUSH_FULL);
+    machine->SetExitMessage(false);
+    while (!machine->IsExit())
+        machine->OneCycle();
+    machine->FlushConsole();
+
+    FanoutResult result;
+    machine->TakeSnapshot(&result.snapshot);
+    result.exit_code = machine->GetExitCode();
+    result.host_time = HostTime() - start_time;
+    // Result is smaller than PIPE_BUF, so it is written at once
+    ssize_t written = write(fd, &result, sizeof(result));
+    _exit(written == sizeof(result) ? 0 : 1);
+}
+
+void ForkFanout::Run(Machine *machine, FILE *file) {
+    IntervalSnapshot fork_point;
+    machine->TakeSnapshot(&fork_point);
+
+    // Pending output would be written again by every child
+    machine->FlushConsole();
+    fflush(stdout);
+    fflush(stderr);
+
+    std::vector<pid_t> children(configs.size());
+    std::vector<int> pipes(configs.size());
+    for (size_t i = 0; i < configs.size(); i++) {
+        int fds[2];
+        if (pipe(fds) < 0) {
+            FATAL("Unable to create pipe for child %s\n", configs[i].name.c_str());
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            FATAL("Unable to fork child %s\n", configs[i].name.c_str());
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            this->RunChild(machine, configs[i], fds[1]);
+        }
+        close(fds[1]);
+        children[i] = pid;
+        pipes[i] = fds[0];
+    }
+
+    // Children write once when they exit, so reading them in order waits for all of them
+    std::vector<FanoutResult> results(configs.size());
+    std::vector<bool> finished(configs.size());
+    for (size_t i = 0; i < configs.size(); i++) {
+        ssize_t count;
+        do {
+            count = read(pipes[i], &results[i], sizeof(FanoutResult));
+        } while (count < 0 && errno == EINTR);
+        finished[i] = count == sizeof(FanoutResult);
+        close(pipes[i]);
+        int status;
+        waitpid(children[i], &status, 0);
+        finished[i] = finished[i] && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    fprintf(file, "\n****************\n");
+    fprintf(file, "Forked %ld configurations at cycle %ld, instruction %ld\n", (int64_t) configs.size(),
+            fork_point.cycles, fork_point.instructions);
+    fprintf(file, "%-16s %5s %14s %14s %7s %8s %10s %10s %10s %10s %9s\n", "Config", "Exit", "Instructions",
+            "Cycles", "CPI", "vs base", "L1 miss", "L2 miss", "L3 miss", "Mem access", "Host (s)");
+    int64_t base_cycles = finished[0] ? results[0].snapshot.cycles - fork_point.cycles : 0;
+    for (size_t i = 0; i < configs.size(); i++) {
+        if (!finished[i]) {
+            fprintf(file, "%-16s failed\n", configs[i].name.c_str());
+            continue;
+        }
+        // Counters since the fork
+        const IntervalSnapshot &snapshot = results[i].snapshot;
+        int64_t instructions = snapshot.instructions - fork_point.instructions;
+        int64_t cycles = snapshot.cycles - fork_point.cycles;
+        double cpi = instructions == 0 ? 0 : (double) cycles / instructions;
+        double change = base_cycles == 0 ? 0 : 100.0 * (cycles - base_cycles) / base_cycles;
+        fprintf(file, "%-16s %5d %14ld %14ld %7.3lf %+7.2lf%% %10ld %10ld %10ld %10ld %9.3lf\n",
+                configs[i].name.c_str(), (int32_t) results[i].exit_code, instructions, cycles, cpi, change,
+                snapshot.storage[STORAGE_LEVEL_L1].miss_num - fork_point.storage[STORAGE_LEVEL_L1].miss_num,
+                snapshot.storage[STORAGE_LEVEL_L2].miss_num - fork_point.storage[STORAGE_LEVEL_L2].miss_num,
+                snapshot.storage[STORAGE_LEVEL_L3].miss_num - fork_point.storage[STORAGE_LEVEL_L3].miss_num,
+                snapshot.storage[STORAGE_LEVEL_MEMORY].access_counter -
+                fork_point.storage[STORAGE_LEVEL_MEMORY].access_counter, results[i].host_time);
+    }
+}
@@ -0,0 +1,55 @@
+//
+// Name: fanout
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_FANOUT_H
+#define RISC_V_SIMULATOR_FANOUT_H
+
+#include "utility.h"
+#include "storage.h"
+#include "interval_stats.h"
+#include "machine.h"
+#include <string>
+#include <vector>
+
+// Changes a child makes to the storage hierarchy before it runs on
+typedef struct FanoutConfig_ {
+    std::string name;
+    bool custom_latency[NUM_OF_STORAGE_LEVELS];
+    StorageLatency latency[NUM_OF_STORAGE_LEVELS];
+    int write_through[STORAGE_LEVEL_MEMORY];        // -1 to keep, only caches have a write policy
+    int write_allocate[STORAGE_LEVEL_MEMORY];
+} FanoutConfig;
+
+// Sent by a child through its pipe when its program exits
+typedef struct FanoutResult_ {
+    int64_t exit_code;
+    double host_time;                   // seconds the child ran
+    IntervalSnapshot snapshot;          // counters at exit
+} FanoutResult;
+
+// Forks the simulator once per configuration at the current cycle, the children share guest memory with the
+// parent copy-on-write and run to exit concurrently, then their counters are compared
+class ForkFanout {
+private:
+    std::vector<FanoutConfig> configs;  // the first one is the unchanged baseline
+
+    // Apply config to machine, run it until exit and write result to fd, called in child
+    void RunChild(Machine *machine, const FanoutConfig &config, int fd);
+
+public:
+    ForkFanout();
+
+    // Add a configuration "<name>:<key>=<value>,...", keys are <level>-latency, <level>-bus, <cache>-write
+    // (back|through) and <cache>-allocate (yes|no) where level is l1, l2, l3 or mem. Return false if it is invalid
+    bool AddConfig(const char *spec);
+
+    // Fork a child for every configuration from the current state of machine, wait for all of them and print
+    // counters since the fork to file
+    void Run(Machine *machine, FILE *file);
+};
+
+#endif //RISC_V_SIMULATOR_FANOUT_H
@@ -0,0 +1,222 @@
+//
+// Name: heap
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "heap.h"
+#include <cstdio>
+
+HeapAllocator::HeapAllocator(Memory *memory) {
+    this->memory = memory;
+    this->start = 0;
+    this->top = 0;
+    this->in_use = 0;
+    this->peak_in_use = 0;
+    this->mapped_pages = 0;
+    this->peak_mapped_pages = 0;
+    this->allocations = 0;
+    this->frees = 0;
+}
+
+void HeapAllocator::MapPage(int64_t page) {
+    if (memory->IsAllocated(page))
+        return;
+    memory->AllocatePage(page);
+    if (++mapped_pages > peak_mapped_pages)
+        peak_mapped_pages = mapped_pages;
+}
+
+void HeapAllocator::UnmapPage(int64_t page) {
+    if (!memory->IsAllocated(page))
+        return;
+    memory->DeallocatePage(page);
+    mapped_pages--;
+}
+
+int64_t HeapAllocator::AllocatePages(int64_t count) {
+    // First fit among released runs
+    for (std::map<int64_t, int64_t>::iterator it = free_runs.begin(); it != free_runs.end(); it++) {
+        if (it->second < count)
+            continue;
+        int64_t address = it->first, remaining = it->second - count;
+        free_runs.erase(it);
+        if (remaining > 0)
+            free_runs[address + count * PageSize] = remaining;
+        for (int64_t i = 0; i < count; i++)
+            this->MapPage(address + i * PageSize);
+        return address;
+    }
+
+    // Grow break, starting from a released run just below it if there is one
+    int64_t address = RoundUp(top, PageSizeBitsNum);
+    std::map<int64_t, int64_t>::iterator last = free_runs.end();
+    if (!free_runs.empty()) {
+        last--;
+        if (last->first + last->second * PageSize == address)
+            address = last->first;
+        else
+            last = free_runs.end();
+    }
+    int64_t end = address + count * PageSize;
+    if (end > MAX_PROGRAM_BREAK)
+        return 0;
+    if (last != free_runs.end())
+        free_runs.erase(last);
+    for (int64_t page = address; page < end; page += PageSize)
+        this->MapPage(page);
+    top = end;
+    return address;
+}
+
+void HeapAllocator::ReleasePages(int64_t address, int64_t count) {
+    for (int64_t i = 0; i < count; i++)
+        this->UnmapPage(address + i * PageSize);
+
+    // Merge with the runs right after and right before
+    std::map<int64_t, int64_t>::iterator it = free_runs.find(address + count * PageSize);
+    if (it != free_runs.end()) {
+        count += it->second;
+        free_runs.erase(it);
+    }
+    it = free_runs.lower_bound(address);
+    if (it != free_runs.begin()) {
+        it--;
+        if (it->first + it->second * PageSize == address) {
+            address = it->first;
+            count += it->second;
+            free_runs.erase(it);
+        }
+    }
+
+    if (address + count * PageSize == RoundUp(top, PageSizeBitsNum))
+        top = address;
+    else
+        free_runs[address] = count;
+}
+
+int64_t HeapAllocator::HighestInUse() {
+    int64_t highest = start;
+    if (!slabs.empty() && slabs.rbegin()->first + PageSize > highest)
+        highest = slabs.rbegin()->first + PageSize;
+    if (!blocks.empty() && blocks.rbegin()->first + blocks.rbegin()->second * PageSize > highest)
+        highest = blocks.rbegin()->first + blocks.rbegin()->second * PageSize;
+    return highest;
+}
+
+void HeapAllocator::SetStart(int64_t address) {
+    start = address;
+    top = address;
+}
+
+int64_t HeapAllocator::Break() {
+    return top;
+}
+
+int64_t HeapAllocator::SetBreak(int64_t address) {
+    if (address < start || address > MAX_PROGRAM_BREAK || address < this->HighestInUse())
+        return top;
+
+    int64_t old_end = RoundUp(top, PageSizeBitsNum), new_end = RoundUp(address, PageSizeBitsNum);
+    for (int64_t page = old_end; page < new_end; page += PageSize)
+        this->MapPage(page);
+    if (new_end < old_end) {
+        // Released runs above new break are gone with it
+        std::map<int64_t, int64_t>::iterator it = free_runs.lower_bound(new_end);
+        free_runs.erase(it, free_runs.end());
+        if (!free_runs.empty()) {
+            it = free_runs.end();
+            it--;
+            if (it->first + it->second * PageSize > new_end)
+                it->second = (new_end - it->first) / PageSize;
+        }
+        for (int64_t page = new_end; page < old_end; page += PageSize)
+            this->UnmapPage(page);
+    }
+    top = address;
+    return top;
+}
+
+int64_t HeapAllocator::Allocate(int64_t size) {
+    int64_t address;
+    // A negative size from the guest would otherwise select the smallest class, and a huge one overflow page count
+    if (size <= 0 || size > MAX_PROGRAM_BREAK - start)
+        return 0;
+    if (size > (1 << HEAP_MAX_CLASS_BITS)) {
+        int64_t count = RoundUp(size, PageSizeBitsNum) >> PageSizeBitsNum;
+        address = this->AllocatePages(count);
+        if (address == 0)
+            return 0;
+        blocks[address] = count;
+        in_use += count * PageSize;
+    } else {
+        int32_t size_class = 0;
+        while ((1 << (size_class + HEAP_MIN_CLASS_BITS)) < size)
+            size_class++;
+        int64_t chunk_size = 1 << (size_class + HEAP_MIN_CLASS_BITS);
+
+        // Carve a new page when the size class runs out of chunks
+        if (free_chunks[size_class].empty()) {
+            int64_t page = this->AllocatePages(1);
+            if (page == 0)
+                return 0;
+            slabs[page].size_class = size_class;
+            slabs[page].used = 0;
+            for (int64_t chunk = page; chunk < page + PageSize; chunk += chunk_size)
+                free_chunks[size_class].insert(chunk);
+        }
+        address = *free_chunks[size_class].begin();
+        free_chunks[size_class].erase(free_chunks[size_class].begin());
+        slabs[address & ~((int64_t) PageSize - 1)].used++;
+        in_use += chunk_size;
+    }
+
+    allocations++;
+    if (in_use > peak_in_use)
+        peak_in_use = in_use;
+    return address;
+}
+
+int64_t HeapAllocator::Free(int64_t address) {
+    if (address == 0)
+        return 0;
+
+    std::map<int64_t, int64_t>::iterator block = blocks.find(address);
+    if (block != blocks.end()) {
+        int64_t size = block->second * PageSize;
+        this->ReleasePages(address, block->second);
+        blocks.erase(block);
+        in_use -= size;
+        frees++;
+        return size;
+    }
+
+    int64_t page = address & ~((int64_t) PageSize - 1);
+    std::map<int64_t, HeapSlab>::iterator slab = slabs.find(page);
+    if (slab == slabs.end()) {
+        FATAL("Invalid free of address %lx\n", address);
+    }
+    int32_t size_class = slab->second.size_class;
+    int64_t chunk_size = 1 << (size_class + HEAP_MIN_CLASS_BITS);
+    if ((address - page) % chunk_size != 0 || free_chunks[size_class].count(address)) {
+        FATAL("Invalid free of address %lx\n", address);
+    }
+
+    free_chunks[size_class].insert(address);
+    in_use -= chunk_size;
+    frees++;
+    if (--slab->second.used == 0) {
+        // Whole page is free, give it back
+        free_chunks[size_class].erase(free_chunks[size_class].lower_bound(page),
+                                      free_chunks[size_class].lower_bound(page + PageSize));
+        slabs.erase(slab);
+        this->ReleasePages(page, 1);
+    }
+    return chunk_size;
+}
+
+void HeapAllocator::PrintStats() {
+    printf("Heap: %ld allocations, %ld frees, peak %ld bytes in use, peak %ld pages mapped\n",
+           allocations, frees, peak_in_use, peak_mapped_pages);
+}
@@ -0,0 +1,83 @@
+//
+// Name: heap
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_HEAP_H
+#define RISC_V_SIMULATOR_HEAP_H
+
+#include "utility.h"
+#include "mem.h"
+#include <map>
+#include <set>
+
+#define MAX_PROGRAM_BREAK ((int64_t) 1 << 47)  // heap may not grow past it, stack starts at 1 << 48
+#define HEAP_MIN_CLASS_BITS 4                   // smallest chunk is 16 bytes
+#define HEAP_MAX_CLASS_BITS 11                  // chunks up to 2048 bytes, larger blocks take whole pages
+#define NUM_OF_HEAP_CLASSES (HEAP_MAX_CLASS_BITS - HEAP_MIN_CLASS_BITS + 1)
+
+// A page carved into chunks of one size class
+struct HeapSlab {
+    int32_t size_class;             // chunk size is 1 << (size_class + HEAP_MIN_CLASS_BITS)
+    int32_t used;                   // chunks handed out
+};
+
+// Guest heap between end of loaded segments and the program break
+// Small blocks come from per size class slabs, large ones from runs of pages, and pages no longer used
+// are returned to Memory
+class HeapAllocator {
+private:
+    Memory *memory;
+    int64_t start;                                      // lowest program break, end of loaded segments
+    int64_t top;                                        // program break
+    std::set<int64_t> free_chunks[NUM_OF_HEAP_CLASSES]; // free chunks of each size class, lowest first
+    std::map<int64_t, HeapSlab> slabs;                  // slab of each page used by small blocks
+    std::map<int64_t, int64_t> blocks;                  // page count of each large block
+    std::map<int64_t, int64_t> free_runs;               // coalesced runs of released pages below top
+    int64_t in_use;                                     // bytes of chunks and pages handed out
+    int64_t peak_in_use;
+    int64_t mapped_pages;                               // heap pages allocated in Memory
+    int64_t peak_mapped_pages;
+    int64_t allocations;
+    int64_t frees;
+
+    // Allocate page in Memory unless program has touched it already
+    void MapPage(int64_t page);
+
+    // Return page to Memory
+    void UnmapPage(int64_t page);
+
+    // Take count pages from a free run or from above the break
+    int64_t AllocatePages(int64_t count);
+
+    // Give count pages back, coalescing with neighbouring runs and lowering the break if they are on top
+    void ReleasePages(int64_t address, int64_t count);
+
+    // End of highest page handed out by the allocator, break can not be lowered below it
+    int64_t HighestInUse();
+
+public:
+    HeapAllocator(Memory *memory);
+
+    // Heap starts at address, which is the initial program break
+    void SetStart(int64_t address);
+
+    // Current program break
+    int64_t Break();
+
+    // Linux brk: move break to address, return the new break or the current one if address is out of heap
+    int64_t SetBreak(int64_t address);
+
+    // Return address of a block of at least size bytes, 0 if size is not positive or heap can not hold it
+    int64_t Allocate(int64_t size);
+
+    // Free block at address, return its size in bytes, 0 for a NULL address
+    int64_t Free(int64_t address);
+
+    // Print peak heap usage
+    void PrintStats();
+};
+
+#endif //RISC_V_SIMULATOR_HEAP_H
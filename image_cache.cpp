@@ -0,0 +1,214 @@
+//
+// Name: image_cache
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "image_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+ImageCache::ImageCache(const char *directory) : directory(directory) {
+    this->map = NULL;
+    this->map_size = 0;
+    this->header = NULL;
+    this->segments = NULL;
+    this->last_segment = NULL;
+}
+
+ImageCache::~ImageCache() {
+    if (map != NULL)
+        munmap((void *) map, map_size);
+}
+
+std::string ImageCache::Path(uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%16.16lx.rvimg", hash);
+    return directory + name;
+}
+
+uint64_t ImageCache::Hash(const char *data, int64_t size) {
+    return HashBytes(data, size);
+}
+
+bool ImageCache::Open(uint64_t hash, int64_t elf_size) {
+    std::string path = this->Path(hash);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || file_stat.st_size < (off_t) sizeof(ImageHeader)) {
+        close(fd);
+        return false;
+    }
+    const char *file = (const char *) mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED)
+        return false;
+
+    // Image written by another build of simulator or for other contents is not used
+    const ImageHeader *file_header = (const ImageHeader *) file;
+    bool valid = file_header->magic == IMAGE_CACHE_MAGIC && file_header->version == IMAGE_CACHE_VERSION &&
+                 file_header->instruction_size == sizeof(Instruction) && file_header->hash == hash &&
+                 file_header->elf_size == elf_size && file_header->decoder_hash == Instruction::DescriptionHash() &&
+                 file_header->num_segments >= 0 &&
+                 sizeof(ImageHeader) + file_header->num_segments * sizeof(ImageSegment) <= file_stat.st_size;
+    const ImageSegment *file_segments = (const ImageSegment *) (file + sizeof(ImageHeader));
+    for (int64_t i = 0; valid && i < file_header->num_segments; i++) {
+        const ImageSegment &segment = file_segments[i];
+        valid = segment.size >= 0 && segment.data_offset + segment.size <= file_stat.st_size &&
+                (!segment.executable ||
+                 segment.decoded_offset + (segment.size + 1) / 2 * (int64_t) sizeof(Instruction) <= file_stat.st_size);
+    }
+    if (!valid) {
+        munmap((void *) file, file_stat.st_size);
+        return false;
+    }
+
+    if (map != NULL)
+        munmap((void *) map, map_size);
+    map = file;
+    map_size = file_stat.st_size;
+    header = file_header;
+    segments = file_segments;
+    last_segment = NULL;
+    return true;
+}
+
+void ImageCache::Build(uint64_t hash, int64_t elf_size, int64_t entry, int64_t heap_start,
+                       const std::vector<ImageSegment> &segments, Memory *memory) {
+    // Lay out file, segment contents are page aligned
+    std::vector<ImageSegment> table(segments);
+    int64_t offset = RoundUp((int64_t) (sizeof(ImageHeader) + table.size() * sizeof(ImageSegment)), PageSizeBitsNum);
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i].data_offset = offset;
+        offset += RoundUp(table[i].size, PageSizeBitsNum);
+    }
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i].decoded_offset = offset;
+        if (table[i].executable)
+            offset += (table[i].size + 1) / 2 * sizeof(Instruction);
+    }
+    int64_t file_size = offset;
+
+    // Write to a temporary file and rename it, so concurrent runs never see a partial image
+    // Machines of a batch share the process, so the temporary name also has the address of this cache
+    std::string path = this->Path(hash);
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".tmp.%d.%lx", (int) getpid(), (uint64_t) this);
+    std::string temporary_path = path + suffix;
+    int fd = open(temporary_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to create image cache file %s\n", temporary_path.c_str());
+        return;
+    }
+    char *file = NULL;
+    if (ftruncate(fd, file_size) == 0)
+        file = (char *) mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (file == NULL || file == MAP_FAILED) {
+        fprintf(stderr, "Unable to write image cache file %s\n", temporary_path.c_str());
+        unlink(temporary_path.c_str());
+        return;
+    }
+
+    ImageHeader *file_header = (ImageHeader *) file;
+    file_header->magic = IMAGE_CACHE_MAGIC;
+    file_header->version = IMAGE_CACHE_VERSION;
+    file_header->instruction_size = sizeof(Instruction);
+    file_header->hash = hash;
+    file_header->elf_size = elf_size;
+    file_header->decoder_hash = Instruction::DescriptionHash();
+    file_header->entry = entry;
+    file_header->heap_start = heap_start;
+    file_header->num_segments = table.size();
+    memcpy(file + sizeof(ImageHeader), &table[0], table.size() * sizeof(ImageSegment));
+
+    for (size_t i = 0; i < table.size(); i++) {
+        const ImageSegment &segment = table[i];
+        memory->ReadBlock(segment.address, file + segment.data_offset, segment.size);
+        if (!segment.executable)
+            continue;
+
+        // Decode every 2 byte aligned pc the same way as the functional interpreter does
+        Instruction *decoded = (Instruction *) (file + segment.decoded_offset);
+        for (int64_t si = 0; si < (segment.size + 1) / 2; si++) {
+            int64_t pc = segment.address + si * 2;
+            Instruction *instruction = &decoded[si];
+            memset(instruction, 0, sizeof(Instruction));
+            instruction->instr_pc = pc;
+            instruction->trace_id = -1;
+            // Halves out of segment are left to be decoded at run time
+            if (si * 2 + 2 > segment.size)
+                continue;
+            uint16_t half;
+            memcpy(&half, file + segment.data_offset + si * 2, sizeof(half));
+            instruction->binary_code = half;
+            if (Decode_c_opcode(instruction->binary_code) == 0x3) {
+                if (si * 2 + 4 > segment.size)
+                    continue;
+                memcpy(&half, file + segment.data_offset + si * 2 + 2, sizeof(half));
+                instruction->binary_code |= (int32_t) half << 16;
+            }
+            instruction->decoded = instruction->Decode();
+        }
+    }
+
+    munmap(file, file_size);
+    if (rename(temporary_path.c_str(), path.c_str()) < 0) {
+        fprintf(stderr, "Unable to write image cache file %s\n", path.c_str());
+        unlink(temporary_path.c_str());
+    }
+}
+
+int64_t ImageCache::Entry() {
+    return header->entry;
+}
+
+int64_t ImageCache::HeapStart() {
+    return header->heap_start;
+}
+
+void ImageCache::LoadSegments(Memory *memory) {
+    for (int64_t i = 0; i < header->num_segments; i++)
+        memory->WriteBlock(segments[i].address, map + segments[i].data_offset, segments[i].size);
+}
+
+bool ImageCache::Lookup(int64_t pc, Instruction *instruction) {
+    if (map == NULL)
+        return false;
+    if (last_segment == NULL || pc < last_segment->address || pc >= last_segment->address + last_segment->size) {
+        last_segment = NULL;
+        for (int64_t i = 0; i < header->num_segments; i++) {
+            if (segments[i].executable && pc >= segments[i].address && pc < segments[i].address + segments[i].size) {
+                last_segment = &segments[i];
+                break;
+            }
+        }
+        if (last_segment == NULL)
+            return false;
+    }
+
+    const Instruction *image = (const Instruction *) (map + last_segment->decoded_offset) +
+                               ((pc - last_segment->address) >> 1);
+    if (!image->decoded)
+        return false;
+
+    // Code may have been modified since image was built, compressed instructions only compare lower half
+    int32_t binary_code = instruction->binary_code;
+    if (Decode_c_opcode(image->binary_code) == 0x3 ? image->binary_code != binary_code
+                                                    : (uint16_t) image->binary_code != (uint16_t) binary_code)
+        return false;
+
+    int64_t trace_id = instruction->trace_id;
+    *instruction = *image;
+    instruction->binary_code = binary_code;
+    instruction->instr_pc = pc;
+    instruction->trace_id = trace_id;
+    return true;
+}
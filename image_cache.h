@@ -0,0 +1,86 @@
+//
+// Name: image_cache
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_IMAGE_CACHE_H
+#define RISC_V_SIMULATOR_IMAGE_CACHE_H
+
+#include "utility.h"
+#include "instruction.h"
+#include "mem.h"
+#include <string>
+#include <vector>
+
+#define IMAGE_CACHE_MAGIC 0x474d49565352ULL    // "RSVIMG"
+#define IMAGE_CACHE_VERSION 3                  // bump when layout of image or fields of Instruction change
+
+// Header of an image file, followed by segment table, segment contents and decoded instructions
+typedef struct ImageHeader_ {
+    uint64_t magic;
+    int64_t version;
+    int64_t instruction_size;       // sizeof(Instruction) of the simulator which wrote the image
+    uint64_t hash;                  // FNV-1a hash of the ELF file
+    int64_t elf_size;               // bytes of the ELF file, checked with hash so a hash collision alone is not used
+    uint64_t decoder_hash;          // Instruction::DescriptionHash of the simulator which decoded the image
+    int64_t entry;                  // program entry
+    int64_t heap_start;             // end of the highest segment
+    int64_t num_segments;
+} ImageHeader;
+
+// A loaded segment, executable ones have an Instruction for every 2 byte aligned pc
+typedef struct ImageSegment_ {
+    int64_t address;                // virtual address of segment
+    int64_t size;                   // bytes of segment in file, the rest is bss
+    int64_t executable;             // is it decoded?
+    int64_t data_offset;            // offset of contents in image file
+    int64_t decoded_offset;         // offset of decoded instructions in image file
+} ImageSegment;
+
+// Loaded segments and pre-decoded instructions of an executable, kept in a file named by the hash of the ELF
+// Later runs of the same executable map the file instead of decoding again
+class ImageCache {
+private:
+    std::string directory;          // where image files are kept
+    const char *map;                // mapped image file, NULL if not opened
+    int64_t map_size;
+    const ImageHeader *header;
+    const ImageSegment *segments;
+    const ImageSegment *last_segment;   // executable segment found by last lookup
+
+    // Path of image file of given hash
+    std::string Path(uint64_t hash);
+
+public:
+    ImageCache(const char *directory);
+
+    ~ImageCache();
+
+    // FNV-1a hash of data
+    static uint64_t Hash(const char *data, int64_t size);
+
+    // Map image of the ELF file of given hash and size, return false if there is no valid one
+    bool Open(uint64_t hash, int64_t elf_size);
+
+    // Decode executable segments, which are already loaded into memory, and write image file of the ELF file
+    // of given hash and size, only address, size and executable of segments are used
+    void Build(uint64_t hash, int64_t elf_size, int64_t entry, int64_t heap_start,
+               const std::vector<ImageSegment> &segments, Memory *memory);
+
+    // Program entry of opened image
+    int64_t Entry();
+
+    // End of the highest segment of opened image
+    int64_t HeapStart();
+
+    // Copy all segments of opened image into memory
+    void LoadSegments(Memory *memory);
+
+    // Fill decoded fields of instruction at pc if its binary code is unchanged since image was built
+    // binary_code, instr_pc and trace_id of instruction are kept
+    bool Lookup(int64_t pc, Instruction *instruction);
+};
+
+#endif //RISC_V_SIMULATOR_IMAGE_CACHE_H
@@ -6,6 +6,10 @@
 //
 
 #include "instruction.h"
+#include "trace.h"
+#include <cstring>
+#include <atomic>
+#include <mutex>
 
 char op_strings[][8] = {"ADD", "MUL", "SUB", "SLL", "MULH", "SLT", "XOR", "DIV", "SRL", "SRA",
                         "OR", "REM", "AND", "LB", "LH", "LW", "LD", "ADDI", "SLLI", "SLTI",
@@ -13,7 +17,9 @@ char op_strings[][8] = {"ADD", "MUL", "SUB", "SLL", "MULH", "SLT", "XOR", "DIV",
                         "SH", "SW", "SD", "BEQ", "BNE", "BLT", "BGE", "AUIPC", "LUI", "JAL",
                         "LI", "SUBW", "ADDW", "J", "BEQZ", "BNEZ", "LWSP", "LDSP", "SWSP", "SDSP",
                         "MV", "BLTU", "BGEU", "JR", "SLLIW", "SRLIW", "SRAIW", "SLLW", "SRLW",
-                        "SRAW", "LBU", "LHU", "MULW"
+                        "SRAW", "LBU", "LHU", "MULW", "CSRRW", "CSRRS", "CSRRC", "CSRRWI", "CSRRSI",
+                        "CSRRCI", "SLTU", "SLTIU", "MULHSU", "MULHU", "DIVU", "REMU", "DIVW", "DIVUW", "REMW",
+                        "REMUW", "LWU"
 
 };
 
@@ -23,6 +29,111 @@ char reg_strings[32][8] = {"zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
                            "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
 };
 
+// Decoded fields of every 16 bit compressed instruction
+typedef struct CompressedFields_ {
+    int32_t imm;
+    int8_t opcode;
+    int8_t funct3;
+    int8_t rs1, rs2, rd;
+    int8_t op_type;
+    int8_t instr_type;
+    bool write_reg;
+    bool valid;                     // false if the code is not a valid compressed instruction
+} CompressedFields;
+
+static CompressedFields compressed_table[NUM_OF_COMPRESSED_CODES];
+static std::once_flag decode_tables_once;
+static std::atomic<bool> decode_tables_built(false);    // set only after every table is filled
+
+// One entry of the ISA description, a code is this instruction if (code & mask) == match
+typedef struct InstructionDescription_ {
+    int8_t op_type;
+    int8_t format;
+    uint32_t mask;
+    uint32_t match;
+} InstructionDescription;
+
+static const InstructionDescription descriptions[] = {
+#define INSTRUCTION(op_type, format, mask, match) {op_type, format, mask, match},
+#define RESERVED(mask, match) {-1, FORMAT_RESERVED, mask, match},
+#include "instruction.def"
+#undef INSTRUCTION
+#undef RESERVED
+};
+
+#define NUM_OF_DESCRIPTIONS ((int32_t) (sizeof(descriptions) / sizeof(descriptions[0])))
+
+// Indexes into descriptions of every bucket in description order, terminated by -1
+static int16_t decode_index[NUM_OF_DECODE_BUCKETS][DECODE_BUCKET_SIZE + 1];
+
+// Bucket of a binary code in the decode index
+static inline int32_t DecodeBucket(uint32_t code) {
+    if ((code & 0x3) == 0x3)
+        return (((code >> 2) & 0x1F) << 3) | ((code >> 12) & 0x7);
+    return 256 + (((code & 0x3) << 3) | ((code >> 13) & 0x7));
+}
+
+void Instruction::BuildDecodeTables() {
+    // Machines may be created on several threads, only the first call fills the tables and the others wait for it
+    std::call_once(decode_tables_once, Instruction::FillDecodeTables);
+}
+
+void Instruction::FillDecodeTables() {
+    // Put each description into every bucket whose opcode and funct3 bits it can match
+    for (int32_t bucket = 0; bucket < NUM_OF_DECODE_BUCKETS; bucket++) {
+        uint32_t code, bucket_bits;
+        if (bucket < 256) {
+            code = 0x3 | ((bucket >> 3) << 2) | ((bucket & 0x7) << 12);
+            bucket_bits = 0x707F;
+        } else {
+            code = ((bucket - 256) >> 3) | (((bucket - 256) & 0x7) << 13);
+            bucket_bits = 0xE003;
+        }
+        int32_t size = 0;
+        for (int32_t i = 0; i < NUM_OF_DESCRIPTIONS; i++) {
+            if (((code ^ descriptions[i].match) & descriptions[i].mask & bucket_bits) != 0)
+                continue;
+            ASSERT(size < DECODE_BUCKET_SIZE);
+            decode_index[bucket][size++] = (int16_t) i;
+        }
+        decode_index[bucket][size] = -1;
+    }
+
+    // Expand every compressed code once, so that decoding one is a single lookup
+    for (int32_t code = 0; code < NUM_OF_COMPRESSED_CODES; code++) {
+        CompressedFields &fields = compressed_table[code];
+        Instruction instruction;
+        memset(&instruction, 0, sizeof(instruction));
+        instruction.binary_code = code;
+        // Codes with low bits 11 are the lower halves of normal instructions
+        fields.valid = Decode_c_opcode(code) != 0x3 && instruction.DecodeByDescription();
+        fields.imm = instruction.imm;
+        fields.opcode = instruction.opcode;
+        fields.funct3 = instruction.funct3;
+        fields.rs1 = instruction.rs1;
+        fields.rs2 = instruction.rs2;
+        fields.rd = instruction.rd;
+        fields.op_type = instruction.op_type;
+        fields.instr_type = instruction.instr_type;
+        fields.write_reg = instruction.write_reg;
+    }
+    decode_tables_built.store(true, std::memory_order_release);
+}
+
+uint64_t Instruction::DescriptionHash() {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (int32_t i = 0; i < NUM_OF_DESCRIPTIONS; i++) {
+        const InstructionDescription &description = descriptions[i];
+        hash = HashBytes(&description.op_type, sizeof(description.op_type), hash);
+        hash = HashBytes(&description.format, sizeof(description.format), hash);
+        hash = HashBytes(&description.mask, sizeof(description.mask), hash);
+        hash = HashBytes(&description.match, sizeof(description.match), hash);
+        if (description.op_type >= 0)
+            hash = HashBytes(op_strings[description.op_type], sizeof(op_strings[0]), hash);
+    }
+    return hash;
+}
+
 inline void Instruction::ImmSignExtend(int num_of_bits) {
     int32_t sign = this->imm & (1 << (num_of_bits - 1));
     sign |= sign << 1;
@@ -91,617 +202,248 @@ inline void Instruction::DecodeUJInstruction() {
     this->ImmSignExtend(21);
 }
 
+
 bool Instruction::Decode() {
-    bool return_value = true;
+    if (!decode_tables_built.load(std::memory_order_acquire))
+        Instruction::BuildDecodeTables();
     // Test if instruction is compressed type or not
     if (Decode_c_opcode(this->binary_code) == 3) {
         // This is not a compressed instruction
-        this->opcode = Decode_opcode(this->binary_code);
-        switch (this->opcode) {
-            case 0x33:
-                this->DecodeRInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_ADD;
-                                break;
-                            case 0x01:
-                                this->op_type = OP_MUL;
-                                break;
-                            case 0x20:
-                                this->op_type = OP_SUB;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x1:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_SLL;
-                                break;
-                            case 0x01:
-                                this->op_type = OP_MULH;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x2:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_SLT;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x4:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_XOR;
-                                break;
-                            case 0x01:
-                                this->op_type = OP_DIV;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x5:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_SRL;
-                                break;
-                            case 0X20:
-                                this->op_type = OP_SRA;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x6:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_OR;
-                                break;
-                            case 0x01:
-                                this->op_type = OP_REM;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x7:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_AND;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x3B:
-                this->DecodeRInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        if (this->funct7 == 0x00) {
-                            this->op_type = OP_ADDW;
-                        } else if (this->funct7 == 0x01) {
-                            this->op_type = OP_MULW;
-                        } else if (this->funct7 == 0x20) {
-                            this->op_type = OP_SUBW;
-                        } else {
-                            DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                  this->opcode, this->funct3, this->funct7);
-                            return_value = false;
-                        }
-                        break;
-                    case 0x1:
-                        if (this->funct7 == 0x00) {
-                            this->op_type = OP_SLLW;
-                        } else {
-                            DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                  this->opcode, this->funct3, this->funct7);
-                            return_value = false;
-                        }
-                        break;
-                    case 0x5:
-                        if (this->funct7 == 0x00) {
-                            this->op_type = OP_SRLW;
-                        } else if (this->funct7 == 0x20) {
-                            this->op_type = OP_SRAW;
-                        } else {
-                            DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                  this->opcode, this->funct3, this->funct7);
-                            return_value = false;
-                        }
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x03:
-                this->DecodeIInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        this->op_type = OP_LB;
-                        break;
-                    case 0x1:
-                        this->op_type = OP_LH;
-                        break;
-                    case 0x2:
-                        this->op_type = OP_LW;
-                        break;
-                    case 0x3:
-                        this->op_type = OP_LD;
-                        break;
-                    case 0x4:
-                        this->op_type = OP_LBU;
-                        break;
-                    case 0x5:
-                        this->op_type = OP_LHU;
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x13:
-                this->DecodeIInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        this->op_type = OP_ADDI;
-                        break;
-                    case 0x1:
-                        if (this->funct7 == 0x00)
-                            this->op_type = OP_SLLI;
-                        else {
-                            DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                  this->opcode, this->funct3, this->funct7);
-                            return_value = false;
-                        }
-                        break;
-                    case 0x2:
-                        this->op_type = OP_SLTI;
-                        break;
-                    case 0x4:
-                        this->op_type = OP_XORI;
-                        break;
-                    case 0x5:
-                        switch (this->funct7) {
-                            case 0x00:
-                                this->op_type = OP_SRLI;
-                                break;
-                            case 0x01:
-                                this->op_type = OP_SRAI;
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                      this->opcode, this->funct3, this->funct7);
-                                return_value = false;
-                        }
-                        break;
-                    case 0x6:
-                        this->op_type = OP_ORI;
-                        break;
-                    case 0x7:
-                        this->op_type = OP_ANDI;
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x1B:
-                this->DecodeIInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        this->op_type = OP_ADDIW;
-                        break;
-                    case 0x1:
-                        this->op_type = OP_SLLIW;
-                        break;
-                    case 0x5:
-                        if (this->funct7 == 0x00) {
-                            this->op_type = OP_SRLIW;
-                        } else if (this->funct7 == 0x20) {
-                            this->op_type = OP_SRAIW;
-                        } else {
-                            DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                                  this->opcode, this->funct3, this->funct7);
-                            return_value = false;
-                        }
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x67:
-                this->DecodeIInstruction();
-                if (this->funct3 == 0x0)
-                    this->op_type = OP_JALR;
-                else {
-                    DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                    return_value = false;
-                }
-                break;
-            case 0x73:
-                this->DecodeIInstruction();
-                if (this->funct3 == 0x0 && this->funct7 == 0x00)
-                    this->op_type = OP_ECALL;
-                else {
-                    DEBUG("OP Code %x, Funct3 %x, Funct7 %x not implemented\n",
-                          this->opcode, this->funct3, this->funct7);
-                    return_value = false;
-                }
-                break;
-            case 0x23:
-                this->DecodeSInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        this->op_type = OP_SB;
-                        break;
-                    case 0x1:
-                        this->op_type = OP_SH;
-                        break;
-                    case 0x2:
-                        this->op_type = OP_SW;
-                        break;
-                    case 0x3:
-                        this->op_type = OP_SD;
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x63:
-                this->DecodeSBInstruction();
-                switch (this->funct3) {
-                    case 0x0:
-                        this->op_type = OP_BEQ;
-                        break;
-                    case 0x1:
-                        this->op_type = OP_BNE;
-                        break;
-                    case 0x4:
-                        this->op_type = OP_BLT;
-                        break;
-                    case 0x5:
-                        this->op_type = OP_BGE;
-                        break;
-                    case 0x6:
-                        this->op_type = OP_BLTU;
-                        break;
-                    case 0x7:
-                        this->op_type = OP_BGEU;
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x17:
-                this->DecodeUInstruction();
-                this->op_type = OP_AUIPC;
-                break;
-            case 0x37:
-                this->DecodeUInstruction();
-                this->op_type = OP_LUI;
-                break;
-            case 0x6F:
-                this->DecodeUJInstruction();
-                this->op_type = OP_JAL;
-                break;
-            default:
-                DEBUG("OP Code %x not implemented\n", this->opcode);
-                return_value = false;
-        }
+        bool return_value = this->DecodeByDescription();
+        if (!return_value)
+            TRACE(DECODE_NOT_IMPLEMENTED, (uint32_t) this->binary_code);
+        return return_value;
+    }
+    // Compressed instruction, all fields are looked up from the expansion table
+    const CompressedFields &fields = compressed_table[(uint16_t) this->binary_code];
+    this->opcode = fields.opcode;
+    this->funct3 = fields.funct3;
+    this->funct7 = 0;
+    this->rs1 = fields.rs1;
+    this->rs2 = fields.rs2;
+    this->rd = fields.rd;
+    this->imm = fields.imm;
+    this->op_type = fields.op_type;
+    this->instr_type = fields.instr_type;
+    this->write_reg = fields.write_reg;
+    this->decoded = true;
+    if (!fields.valid)
+        TRACE(DECODE_COMPRESSED_NOT_IMPLEMENTED, (uint16_t) this->binary_code);
+    return fields.valid;
+}
+
+bool Instruction::DecodeByDescription() {
+    uint32_t code = (uint32_t) this->binary_code;
+    this->imm = 0;
+    this->funct7 = 0;
+    this->rs1 = this->rs2 = this->rd = 0;
+    if (Decode_c_opcode(code) == 3) {
+        this->opcode = Decode_opcode(code);
+        this->funct3 = 0;
     } else {
-        // This is a compressed instruction
-        // Since compressed instructions are not uniform (compared to normal instructions)
-        // We don't use uniform decode functions for each CXX type
-        this->opcode = Decode_c_opcode(this->binary_code);
-        this->funct3 = Decode_c_funct3(this->binary_code);
-        switch (this->opcode) {
-            case 0x0:
-                switch (this->funct3) {
-                    case 0x0:
-                        this->instr_type = INSTR_CIW;
-                        this->rd = Decode_cc_rd(this->binary_code);
-                        this->rs1 = REG_sp;
-                        this->op_type = OP_ADDI; // ADDI4SPN
-                        this->imm = Decode_imm(this->binary_code, 6, 1, 2) + Decode_imm(this->binary_code, 5, 1, 3) +
-                                    Decode_imm(this->binary_code, 11, 2, 4) + Decode_imm(this->binary_code, 7, 4, 6);
-                        break;
-                    case 0x2:
-                        this->instr_type = INSTR_CL;
-                        this->rs1 = Decode_cc_rs1(this->binary_code);
-                        this->rd = Decode_cc_rd(this->binary_code);
-                        this->op_type = OP_LW;
-                        this->imm = Decode_imm(this->binary_code, 6, 1, 2) + Decode_imm(this->binary_code, 10, 3, 3) +
-                                    Decode_imm(this->binary_code, 5, 1, 6);
-                        break;
-                    case 0x3:
-                        this->instr_type = INSTR_CL;
-                        this->rs1 = Decode_cc_rs1(this->binary_code);
-                        this->rd = Decode_cc_rd(this->binary_code);
-                        this->op_type = OP_LD;
-                        this->imm = Decode_imm(this->binary_code, 10, 3, 3) + Decode_imm(this->binary_code, 5, 2, 6);
-                        break;
-                    case 0x6:
-                        this->instr_type = INSTR_CS;
-                        this->rs1 = Decode_cc_rs1(this->binary_code);
-                        this->rs2 = Decode_cc_rd(this->binary_code);
-                        this->op_type = OP_SW;
-                        this->imm = Decode_imm(this->binary_code, 6, 1, 2) + Decode_imm(this->binary_code, 10, 3, 3) +
-                                    Decode_imm(this->binary_code, 5, 1, 6);
-                        break;
-                    case 0x7:
-                        this->instr_type = INSTR_CS;
-                        this->rs1 = Decode_cc_rs1(this->binary_code);
-                        this->rs2 = Decode_cc_rd(this->binary_code);
-                        this->op_type = OP_SD;
-                        this->imm = Decode_imm(this->binary_code, 10, 3, 3) + Decode_imm(this->binary_code, 5, 2, 6);
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x1:
-                switch (this->funct3) {
-                    case 0x0:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->rs1 = Decode_c_rs1(this->binary_code);
-                        this->op_type = OP_ADDI;
-                        this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
-                        this->ImmSignExtend(6);
-                        break;
-                    case 0x1:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->rs1 = Decode_c_rs1(this->binary_code);
-                        this->op_type = OP_ADDIW;
-                        this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
-                        this->ImmSignExtend(6);
-                        break;
-                    case 0x2:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->op_type = OP_LI;
-                        this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
-                        this->ImmSignExtend(6);
-                        break;
-                    case 0x3:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        if (this->rd == 2) {
-                            this->op_type = OP_ADDI; // ADDI16SP
-                            this->rs1 = REG_sp;
-                            this->imm =
-                                    Decode_imm(this->binary_code, 6, 1, 4) + Decode_imm(this->binary_code, 2, 1, 5) +
-                                    Decode_imm(this->binary_code, 5, 1, 6) + Decode_imm(this->binary_code, 3, 2, 7) +
-                                    Decode_imm(this->binary_code, 12, 1, 9);
-                            this->ImmSignExtend(10);
-                        } else {
-                            this->op_type = OP_LUI;
-                            this->imm =
-                                    Decode_imm(this->binary_code, 2, 5, 12) + Decode_imm(this->binary_code, 12, 1, 17);
-                            this->ImmSignExtend(18);
-                        }
-                        break;
-                    case 0x4:
-                        switch (Decode_imm(this->binary_code, 10, 2, 0)) {
-                            case 0x0:
-                                this->instr_type = INSTR_CB;
-                                this->rs1 = Decode_cc_rs1(this->binary_code);
-                                this->rd = Decode_cc_rs1(this->binary_code);
-                                this->op_type = OP_SRLI;
-                                this->imm = Decode_imm(this->binary_code, 2, 5, 0) +
-                                            Decode_imm(this->binary_code, 12, 1, 5);
-                                break;
-                            case 0x1:
-                                this->instr_type = INSTR_CB;
-                                this->rs1 = Decode_cc_rs1(this->binary_code);
-                                this->rd = Decode_cc_rs1(this->binary_code);
-                                this->op_type = OP_SRAI;
-                                this->imm = Decode_imm(this->binary_code, 2, 5, 0) +
-                                            Decode_imm(this->binary_code, 12, 1, 5);
-                                break;
-                            case 0x2:
-                                this->instr_type = INSTR_CB;
-                                this->rs1 = Decode_cc_rs1(this->binary_code);
-                                this->rd = Decode_cc_rs1(this->binary_code);
-                                this->op_type = OP_ANDI;
-                                this->imm = Decode_imm(this->binary_code, 2, 5, 0) +
-                                            Decode_imm(this->binary_code, 12, 1, 5);
-                                this->ImmSignExtend(6);
-                                break;
-                            case 0x3:
-                                this->instr_type = INSTR_CS;
-                                this->rd = Decode_cc_rs1(this->binary_code);
-                                this->rs1 = Decode_cc_rs1(this->binary_code);
-                                this->rs2 = Decode_cc_rd(this->binary_code);
-                                switch (Decode_imm(this->binary_code, 12, 1, 0)) {
-                                    case 0x0:
-                                        switch (Decode_imm(this->binary_code, 5, 2, 0)) {
-                                            case 0x0:
-                                                this->op_type = OP_SUB;
-                                                break;
-                                            case 0x1:
-                                                this->op_type = OP_XOR;
-                                                break;
-                                            case 0x2:
-                                                this->op_type = OP_OR;
-                                                break;
-                                            case 0x3:
-                                                this->op_type = OP_AND;
-                                                break;
-                                            default:
-                                                DEBUG("OP Code %x, Funct6 %x, Funct %x not implemented\n",
-                                                      Decode_imm(this->binary_code, 10, 6, 0),
-                                                      Decode_imm(this->binary_code, 5, 2, 0));
-                                                return_value = false;
-                                        }
-                                        break;
-                                    case 0x1:
-                                        switch (Decode_imm(this->binary_code, 5, 2, 0)) {
-                                            case 0x0:
-                                                this->op_type = OP_SUBW;
-                                                break;
-                                            case 0x1:
-                                                this->op_type = OP_ADDW;
-                                                break;
-                                            default:
-                                                DEBUG("OP Code %x, Funct6 %x, Funct %x not implemented\n",
-                                                      Decode_imm(this->binary_code, 10, 6, 0),
-                                                      Decode_imm(this->binary_code, 5, 2, 0));
-                                                return_value = false;
-                                        }
-                                        break;
-                                    default:
-                                        DEBUG("OP Code %x, Funct6 %x not implemented\n",
-                                              Decode_imm(this->binary_code, 10, 6, 0));
-                                        return_value = false;
-                                }
-                                break;
-                            default:
-                                DEBUG("OP Code %x, Funct3 %x, Funct2 %x not implemented\n",
-                                      this->opcode, this->funct3, Decode_imm(this->binary_code, 10, 2, 0));
-                                return_value = false;
-                        }
-                        break;
-                    case 0x5:
-                        this->instr_type = INSTR_CB;
-                        this->op_type = OP_J;
-                        this->imm = Decode_imm(this->binary_code, 3, 3, 1) + Decode_imm(this->binary_code, 11, 1, 4) +
-                                    Decode_imm(this->binary_code, 2, 1, 5) + Decode_imm(this->binary_code, 7, 1, 6) +
-                                    Decode_imm(this->binary_code, 6, 1, 7) + Decode_imm(this->binary_code, 9, 2, 8) +
-                                    Decode_imm(this->binary_code, 8, 1, 10) + Decode_imm(this->binary_code, 12, 1, 11);
-                        this->ImmSignExtend(11);
-                        break;
-                    case 0x6:
-                        this->instr_type = INSTR_CB;
-                        this->rs1 = Decode_cc_rs1(this->binary_code);
-                        this->op_type = OP_BEQZ;
-                        this->imm = Decode_imm(this->binary_code, 3, 2, 1) + Decode_imm(this->binary_code, 10, 2, 3) +
-                                    Decode_imm(this->binary_code, 2, 1, 5) + Decode_imm(this->binary_code, 5, 2, 6) +
-                                    Decode_imm(this->binary_code, 12, 1, 8);
-                        break;
-                    case 0x7:
-                        this->instr_type = INSTR_CB;
-                        this->rs1 = Decode_cc_rs1(this->binary_code);
-                        this->op_type = OP_BNEZ;
-                        this->imm = Decode_imm(this->binary_code, 3, 2, 1) + Decode_imm(this->binary_code, 10, 2, 3) +
-                                    Decode_imm(this->binary_code, 2, 1, 5) + Decode_imm(this->binary_code, 5, 2, 6) +
-                                    Decode_imm(this->binary_code, 12, 1, 8);
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
-                break;
-            case 0x2:
-                switch (this->funct3) {
-                    case 0x0:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->rs1 = Decode_c_rs1(this->binary_code);
-                        this->op_type = OP_SLLI;
-                        this->imm = Decode_imm(this->binary_code, 2, 5, 0) +
-                                    Decode_imm(this->binary_code, 12, 1, 5);
-                        break;
-                    case 0x2:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->op_type = OP_LWSP;
-                        this->imm = Decode_imm(this->binary_code, 4, 3, 2) +
-                                    Decode_imm(this->binary_code, 12, 1, 5) +
-                                    Decode_imm(this->binary_code, 2, 2, 6);
-                        break;
-                    case 0x3:
-                        this->instr_type = INSTR_CI;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->op_type = OP_LDSP;
-                        this->imm = Decode_imm(this->binary_code, 5, 2, 3) +
-                                    Decode_imm(this->binary_code, 12, 1, 5) +
-                                    Decode_imm(this->binary_code, 2, 3, 6);
-                        break;
-                    case 0x4:
-                        this->instr_type = INSTR_CB;
-                        this->rd = Decode_c_rd(this->binary_code);
-                        this->rs1 = Decode_c_rs1(this->binary_code);
-                        this->rs2 = Decode_c_rs2(this->binary_code);
-                        if (Decode_imm(this->binary_code, 12, 1, 0) == 0) {
-                            if (this->rs2 == 0) {
-                                this->instr_type = INSTR_CR;
-                                this->op_type = OP_JR;
-                            } else
-                                this->op_type = OP_MV;
-                        } else if (Decode_imm(this->binary_code, 12, 1, 0) == 1) {
-                            if (this->rs2 == 0) {
-                                this->instr_type = INSTR_CR;
-                                this->op_type = OP_JALR;
-                                this->rd = 1;
-                            } else
-                                this->op_type = OP_ADD;
-                        } else {
-                            DEBUG("OP Code %x, Funct4 %x not implemented\n", Decode_imm(this->binary_code, 10, 4, 0));
-                            return_value = false;
-                        }
-                        break;
-                    case 0x6:
-                        this->instr_type = INSTR_CSS;
-                        this->rs2 = Decode_c_rs2(this->binary_code);
-                        this->op_type = OP_SWSP;
-                        this->imm = Decode_imm(this->binary_code, 9, 4, 2) + Decode_imm(this->binary_code, 7, 2, 6);
-                        break;
-                    case 0x7:
-                        this->instr_type = INSTR_CSS;
-                        this->rs2 = Decode_c_rs2(this->binary_code);
-                        this->op_type = OP_SDSP;
-                        this->imm = Decode_imm(this->binary_code, 10, 3, 3) + Decode_imm(this->binary_code, 7, 3, 6);
-                        break;
-                    default:
-                        DEBUG("OP Code %x, Funct3 %x not implemented\n", this->opcode, this->funct3);
-                        return_value = false;
-                }
+        code &= 0xFFFF;
+        this->opcode = Decode_c_opcode(code);
+        this->funct3 = Decode_c_funct3(code);
+    }
+    this->decoded = true;
+    for (const int16_t *entry = decode_index[DecodeBucket(code)]; *entry >= 0; entry++) {
+        const InstructionDescription &description = descriptions[*entry];
+        if ((code & description.mask) == description.match) {
+            if (description.format == FORMAT_RESERVED)
                 break;
-            default:
-                DEBUG("OP Code %x not implemented\n", this->opcode);
-                return_value = false;
+            this->op_type = description.op_type;
+            this->DecodeFields(description.format);
+            this->SetWriteReg();
+            return true;
         }
     }
+    this->write_reg = false;
+    return false;
+}
+
+void Instruction::DecodeFields(int8_t format) {
+    // Since compressed instructions are not uniform (compared to normal instructions)
+    // Most compressed formats are decoded one by one
+    switch (format) {
+        case FORMAT_R:
+            this->DecodeRInstruction();
+            break;
+        case FORMAT_I:
+            this->DecodeIInstruction();
+            break;
+        case FORMAT_I_SHAMT:
+            this->DecodeIInstruction();
+            this->imm &= 0x3F;
+            break;
+        case FORMAT_I_SHAMTW:
+            this->DecodeIInstruction();
+            this->imm &= 0x1F;
+            break;
+        case FORMAT_S:
+            this->DecodeSInstruction();
+            break;
+        case FORMAT_SB:
+            this->DecodeSBInstruction();
+            break;
+        case FORMAT_U:
+            this->DecodeUInstruction();
+            break;
+        case FORMAT_UJ:
+            this->DecodeUJInstruction();
+            break;
+        case FORMAT_C_ADDI4SPN:
+            this->instr_type = INSTR_CIW;
+            this->rd = Decode_cc_rd(this->binary_code);
+            this->rs1 = REG_sp;
+            this->imm = Decode_imm(this->binary_code, 6, 1, 2) + Decode_imm(this->binary_code, 5, 1, 3) +
+                        Decode_imm(this->binary_code, 11, 2, 4) + Decode_imm(this->binary_code, 7, 4, 6);
+            break;
+        case FORMAT_C_LW:
+            this->instr_type = INSTR_CL;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rd = Decode_cc_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 6, 1, 2) + Decode_imm(this->binary_code, 10, 3, 3) +
+                        Decode_imm(this->binary_code, 5, 1, 6);
+            break;
+        case FORMAT_C_LD:
+            this->instr_type = INSTR_CL;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rd = Decode_cc_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 10, 3, 3) + Decode_imm(this->binary_code, 5, 2, 6);
+            break;
+        case FORMAT_C_SW:
+            this->instr_type = INSTR_CS;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rs2 = Decode_cc_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 6, 1, 2) + Decode_imm(this->binary_code, 10, 3, 3) +
+                        Decode_imm(this->binary_code, 5, 1, 6);
+            break;
+        case FORMAT_C_SD:
+            this->instr_type = INSTR_CS;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rs2 = Decode_cc_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 10, 3, 3) + Decode_imm(this->binary_code, 5, 2, 6);
+            break;
+        case FORMAT_C_ADDI:
+            this->instr_type = INSTR_CI;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->rs1 = Decode_c_rs1(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
+            this->ImmSignExtend(6);
+            break;
+        case FORMAT_C_LI:
+            this->instr_type = INSTR_CI;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
+            this->ImmSignExtend(6);
+            break;
+        case FORMAT_C_ADDI16SP:
+            this->instr_type = INSTR_CI;
+            this->rd = REG_sp;
+            this->rs1 = REG_sp;
+            this->imm = Decode_imm(this->binary_code, 6, 1, 4) + Decode_imm(this->binary_code, 2, 1, 5) +
+                        Decode_imm(this->binary_code, 5, 1, 6) + Decode_imm(this->binary_code, 3, 2, 7) +
+                        Decode_imm(this->binary_code, 12, 1, 9);
+            this->ImmSignExtend(10);
+            break;
+        case FORMAT_C_LUI:
+            this->instr_type = INSTR_CI;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 2, 5, 12) + Decode_imm(this->binary_code, 12, 1, 17);
+            this->ImmSignExtend(18);
+            break;
+        case FORMAT_C_SHIFT:
+            this->instr_type = INSTR_CB;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rd = Decode_cc_rs1(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
+            break;
+        case FORMAT_C_ANDI:
+            this->instr_type = INSTR_CB;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rd = Decode_cc_rs1(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
+            this->ImmSignExtend(6);
+            break;
+        case FORMAT_C_ARITH:
+            this->instr_type = INSTR_CS;
+            this->rd = Decode_cc_rs1(this->binary_code);
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->rs2 = Decode_cc_rd(this->binary_code);
+            break;
+        case FORMAT_C_J:
+            this->instr_type = INSTR_CB;
+            this->imm = Decode_imm(this->binary_code, 3, 3, 1) + Decode_imm(this->binary_code, 11, 1, 4) +
+                        Decode_imm(this->binary_code, 2, 1, 5) + Decode_imm(this->binary_code, 7, 1, 6) +
+                        Decode_imm(this->binary_code, 6, 1, 7) + Decode_imm(this->binary_code, 9, 2, 8) +
+                        Decode_imm(this->binary_code, 8, 1, 10) + Decode_imm(this->binary_code, 12, 1, 11);
+            this->ImmSignExtend(12);
+            break;
+        case FORMAT_C_BRANCH:
+            this->instr_type = INSTR_CB;
+            this->rs1 = Decode_cc_rs1(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 3, 2, 1) + Decode_imm(this->binary_code, 10, 2, 3) +
+                        Decode_imm(this->binary_code, 2, 1, 5) + Decode_imm(this->binary_code, 5, 2, 6) +
+                        Decode_imm(this->binary_code, 12, 1, 8);
+            this->ImmSignExtend(9);
+            break;
+        case FORMAT_C_SLLI:
+            this->instr_type = INSTR_CI;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->rs1 = Decode_c_rs1(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 2, 5, 0) + Decode_imm(this->binary_code, 12, 1, 5);
+            break;
+        case FORMAT_C_LWSP:
+            this->instr_type = INSTR_CI;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 4, 3, 2) + Decode_imm(this->binary_code, 12, 1, 5) +
+                        Decode_imm(this->binary_code, 2, 2, 6);
+            break;
+        case FORMAT_C_LDSP:
+            this->instr_type = INSTR_CI;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 5, 2, 3) + Decode_imm(this->binary_code, 12, 1, 5) +
+                        Decode_imm(this->binary_code, 2, 3, 6);
+            break;
+        case FORMAT_C_JR:
+            this->instr_type = INSTR_CR;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->rs1 = Decode_c_rs1(this->binary_code);
+            break;
+        case FORMAT_C_JALR:
+            this->instr_type = INSTR_CR;
+            this->rd = REG_ra;
+            this->rs1 = Decode_c_rs1(this->binary_code);
+            break;
+        case FORMAT_C_MV:
+        case FORMAT_C_ADD:
+            this->instr_type = INSTR_CB;
+            this->rd = Decode_c_rd(this->binary_code);
+            this->rs1 = Decode_c_rs1(this->binary_code);
+            this->rs2 = Decode_c_rs2(this->binary_code);
+            break;
+        case FORMAT_C_SWSP:
+            this->instr_type = INSTR_CSS;
+            this->rs2 = Decode_c_rs2(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 9, 4, 2) + Decode_imm(this->binary_code, 7, 2, 6);
+            break;
+        case FORMAT_C_SDSP:
+            this->instr_type = INSTR_CSS;
+            this->rs2 = Decode_c_rs2(this->binary_code);
+            this->imm = Decode_imm(this->binary_code, 10, 3, 3) + Decode_imm(this->binary_code, 7, 3, 6);
+            break;
+        default: FATAL("Invalid instruction format %d\n", format);
+    }
+}
+
+
+void Instruction::SetWriteReg() {
     switch (this->op_type) {
         case OP_ADD:
         case OP_MUL:
         case OP_SUB:
         case OP_SLL:
+        case OP_MULH:
         case OP_SLT:
         case OP_XOR:
         case OP_DIV:
@@ -742,22 +484,47 @@ bool Instruction::Decode() {
         case OP_LBU:
         case OP_LHU:
         case OP_JALR:
+        case OP_CSRRW:
+        case OP_CSRRS:
+        case OP_CSRRC:
+        case OP_CSRRWI:
+        case OP_CSRRSI:
+        case OP_CSRRCI:
+        case OP_SLTU:
+        case OP_SLTIU:
+        case OP_MULHSU:
+        case OP_MULHU:
+        case OP_DIVU:
+        case OP_REMU:
+        case OP_DIVW:
+        case OP_DIVUW:
+        case OP_REMW:
+        case OP_REMUW:
+        case OP_LWU:
             this->write_reg = true;
             break;
         default:
             this->write_reg = false;
             break;
     }
-    decoded = true;
-    return return_value;
 }
 
 void Instruction::Print() {
-    printf("PC=%16.16lx  ", instr_pc);
+    this->Print(stdout);
+}
+
+void Instruction::Print(FILE *file) {
+    char text[64];
+    this->Disassemble(text, sizeof(text));
+    fprintf(file, "PC=%16.16lx  %s\n", instr_pc, text);
+}
+
+void Instruction::Disassemble(char *buffer, int32_t size) {
     if (this->decoded) {
         switch (this->instr_type) {
             case INSTR_R:
-                printf("%8s %s, %s, %s\n", op_strings[op_type], reg_strings[rd], reg_strings[rs1], reg_strings[rs2]);
+                snprintf(buffer, size, "%8s %s, %s, %s", op_strings[op_type], reg_strings[rd], reg_strings[rs1],
+                         reg_strings[rs2]);
                 break;
             case INSTR_I:
                 switch (this->op_type) {
@@ -765,28 +532,45 @@ void Instruction::Print() {
                     case OP_LH:
                     case OP_LW:
                     case OP_LD:
-                        printf("%8s %s, %d(%s)\n", op_strings[op_type], reg_strings[rd], imm, reg_strings[rs1]);
+                    case OP_LBU:
+                    case OP_LHU:
+                    case OP_LWU:
+                        snprintf(buffer, size, "%8s %s, %d(%s)", op_strings[op_type], reg_strings[rd], imm,
+                                 reg_strings[rs1]);
                         break;
                     case OP_ECALL:
-                        printf("ecall\n");
+                        snprintf(buffer, size, "ecall");
+                        break;
+                    case OP_CSRRW:
+                    case OP_CSRRS:
+                    case OP_CSRRC:
+                        snprintf(buffer, size, "%8s %s, 0x%3.3x, %s", op_strings[op_type], reg_strings[rd],
+                                 Decode_csr(binary_code), reg_strings[rs1]);
+                        break;
+                    case OP_CSRRWI:
+                    case OP_CSRRSI:
+                    case OP_CSRRCI:
+                        snprintf(buffer, size, "%8s %s, 0x%3.3x, %d", op_strings[op_type], reg_strings[rd],
+                                 Decode_csr(binary_code), rs1);
                         break;
                     default:
-                        printf("%8s %s, %s, %d\n", op_strings[op_type], reg_strings[rd], reg_strings[rs1], imm);
+                        snprintf(buffer, size, "%8s %s, %s, %d", op_strings[op_type], reg_strings[rd],
+                                 reg_strings[rs1], imm);
                         break;
                 }
                 break;
             case INSTR_S:
-                printf("%8s %s, %d(%s)\n", op_strings[op_type], reg_strings[rs2], imm, reg_strings[rs1]);
+                snprintf(buffer, size, "%8s %s, %d(%s)", op_strings[op_type], reg_strings[rs2], imm, reg_strings[rs1]);
                 break;
             case INSTR_SB:
-                printf("%8s %s, %s, %d\n", op_strings[op_type], reg_strings[rs1], reg_strings[rs2], imm);
+                snprintf(buffer, size, "%8s %s, %s, %d", op_strings[op_type], reg_strings[rs1], reg_strings[rs2], imm);
                 break;
             case INSTR_U:
             case INSTR_UJ:
-                printf("%8s %s, %d\n", op_strings[op_type], reg_strings[rd], imm);
+                snprintf(buffer, size, "%8s %s, %d", op_strings[op_type], reg_strings[rd], imm);
                 break;
             case INSTR_CR:
-                printf("%8s %s\n", op_strings[op_type], reg_strings[rs1]);
+                snprintf(buffer, size, "%8s %s", op_strings[op_type], reg_strings[rs1]);
                 break;
             case INSTR_CI:
                 switch (this->op_type) {
@@ -794,62 +578,66 @@ void Instruction::Print() {
                     case OP_LUI:
                     case OP_LWSP:
                     case OP_LDSP:
-                        printf("%8s %s, %d\n", op_strings[op_type], reg_strings[rd], imm);
+                        snprintf(buffer, size, "%8s %s, %d", op_strings[op_type], reg_strings[rd], imm);
                         break;
                     default:
-                        printf("%8s %s, %s, %d\n", op_strings[op_type], reg_strings[rd], reg_strings[rd], imm);
+                        snprintf(buffer, size, "%8s %s, %s, %d", op_strings[op_type], reg_strings[rd],
+                                 reg_strings[rd], imm);
                         break;
                 }
                 break;
             case INSTR_CSS:
-                printf("%8s %s, %d\n", op_strings[op_type], reg_strings[rs2], imm);
+                snprintf(buffer, size, "%8s %s, %d", op_strings[op_type], reg_strings[rs2], imm);
                 break;
             case INSTR_CL:
-                printf("%8s %s, %d(%s)\n", op_strings[op_type], reg_strings[rd], imm, reg_strings[rs1]);
+                snprintf(buffer, size, "%8s %s, %d(%s)", op_strings[op_type], reg_strings[rd], imm, reg_strings[rs1]);
                 break;
             case INSTR_CS:
                 switch (this->op_type) {
                     case OP_SW:
                     case OP_SD:
-                        printf("%8s %s, %d(%s)\n", op_strings[op_type], reg_strings[rs2], imm, reg_strings[rs1]);
+                        snprintf(buffer, size, "%8s %s, %d(%s)", op_strings[op_type], reg_strings[rs2], imm,
+                                 reg_strings[rs1]);
                         break;
                     default:
-                        printf("%8s %s, %s, %s\n", op_strings[op_type], reg_strings[rd], reg_strings[rd],
-                               reg_strings[rs2]);
+                        snprintf(buffer, size, "%8s %s, %s, %s", op_strings[op_type], reg_strings[rd], reg_strings[rd],
+                                 reg_strings[rs2]);
                 }
                 break;
             case INSTR_CB:
                 switch (this->op_type) {
                     case OP_J:
-                        printf("%8s %d\n", op_strings[op_type], imm);
+                        snprintf(buffer, size, "%8s %d", op_strings[op_type], imm);
                         break;
                     case OP_MV:
-                        printf("%8s %s, %s\n", op_strings[op_type], reg_strings[rd], reg_strings[rs2]);
+                        snprintf(buffer, size, "%8s %s, %s", op_strings[op_type], reg_strings[rd], reg_strings[rs2]);
                         break;
                     case OP_ADD:
-                        printf("%8s %s, %s, %s\n", op_strings[op_type], reg_strings[rd], reg_strings[rs1],
-                               reg_strings[rs2]);
+                        snprintf(buffer, size, "%8s %s, %s, %s", op_strings[op_type], reg_strings[rd], reg_strings[rs1],
+                                 reg_strings[rs2]);
                         break;
                     case OP_SRLI:
                     case OP_SRAI:
                     case OP_ANDI:
-                        printf("%8s %s, %s, %d\n", op_strings[op_type], reg_strings[rd], reg_strings[rd], imm);
+                        snprintf(buffer, size, "%8s %s, %s, %d", op_strings[op_type], reg_strings[rd],
+                                 reg_strings[rd], imm);
                         break;
                     default:
-                        printf("%8s %s, %d\n", op_strings[op_type], reg_strings[rs1], imm);
+                        snprintf(buffer, size, "%8s %s, %d", op_strings[op_type], reg_strings[rs1], imm);
                 }
                 break;
             case INSTR_CIW:
                 if (this->op_type == OP_ADDI) {
-                    printf("%8s %s, %s, %d\n", op_strings[op_type], reg_strings[rd], reg_strings[rs1], imm);
+                    snprintf(buffer, size, "%8s %s, %s, %d", op_strings[op_type], reg_strings[rd], reg_strings[rs1],
+                             imm);
                     break;
                 }
             default: FATAL("Invalid op type %d\n", this->op_type);
         }
     } else {
         if (Decode_imm(binary_code, 0, 2, 0) == 0x3)
-            printf("%8.8x\n", binary_code);
+            snprintf(buffer, size, "%8.8x", binary_code);
         else
-            printf("%8.4x\n", (int16_t) binary_code);
+            snprintf(buffer, size, "%8.4x", (int16_t) binary_code);
     }
 }
@@ -107,6 +107,24 @@
 #define OP_LBU 59
 #define OP_LHU 60
 #define OP_MULW 61
+#define OP_CSRRW 62
+#define OP_CSRRS 63
+#define OP_CSRRC 64
+#define OP_CSRRWI 65
+#define OP_CSRRSI 66
+#define OP_CSRRCI 67
+#define OP_SLTU 68
+#define OP_SLTIU 69
+#define OP_MULHSU 70
+#define OP_MULHU 71
+#define OP_DIVU 72
+#define OP_REMU 73
+#define OP_DIVW 74
+#define OP_DIVUW 75
+#define OP_REMW 76
+#define OP_REMUW 77
+#define OP_LWU 78
+#define NUM_OF_OP_TYPES 79
 
 // Instr type macro definitions
 #define INSTR_R 0
@@ -124,6 +142,40 @@
 #define INSTR_CB 12
 #define INSTR_CJ 13
 
+// Operand format macro definitions, tell how fields are extracted from an instruction in instruction.def
+#define FORMAT_R 0
+#define FORMAT_I 1
+#define FORMAT_I_SHAMT 2            // I type with 6 bit shift amount
+#define FORMAT_I_SHAMTW 3           // I type with 5 bit shift amount
+#define FORMAT_S 4
+#define FORMAT_SB 5
+#define FORMAT_U 6
+#define FORMAT_UJ 7
+#define FORMAT_C_ADDI4SPN 8
+#define FORMAT_C_LW 9
+#define FORMAT_C_LD 10
+#define FORMAT_C_SW 11
+#define FORMAT_C_SD 12
+#define FORMAT_C_ADDI 13
+#define FORMAT_C_LI 14
+#define FORMAT_C_ADDI16SP 15
+#define FORMAT_C_LUI 16
+#define FORMAT_C_SHIFT 17
+#define FORMAT_C_ANDI 18
+#define FORMAT_C_ARITH 19
+#define FORMAT_C_J 20
+#define FORMAT_C_BRANCH 21
+#define FORMAT_C_SLLI 22
+#define FORMAT_C_LWSP 23
+#define FORMAT_C_LDSP 24
+#define FORMAT_C_JR 25
+#define FORMAT_C_MV 26
+#define FORMAT_C_JALR 27
+#define FORMAT_C_ADD 28
+#define FORMAT_C_SWSP 29
+#define FORMAT_C_SDSP 30
+#define FORMAT_RESERVED 31          // reserved encoding, it does not decode
+
 // Macros for decode
 #define Decode_opcode(instr_code) ((int8_t) (instr_code & 0b1111111))
 #define Decode_rd(instr_code) ((int8_t) ((instr_code >> 7) & 0b11111))
@@ -131,6 +183,7 @@
 #define Decode_rs2(instr_code) ((int8_t) ((instr_code >> 20) & 0b11111))
 #define Decode_funct3(instr_code) ((int8_t) ((instr_code >> 12) & 0b111))
 #define Decode_funct7(instr_code) ((int8_t) ((instr_code >> 25) & 0b1111111))
+#define Decode_csr(instr_code) ((int32_t) ((instr_code >> 20) & 0xFFF))
 #define Decode_imm(instr_code, index_in_instr, num_of_bits, index_in_imm) \
         (((instr_code >> index_in_instr) & ((1 << num_of_bits) - 1)) << index_in_imm)
 
@@ -143,6 +196,75 @@
 #define Decode_cc_rd(instr_code) ((int8_t) (((instr_code >> 2) & 0b111) + 8))
 #define Decode_cc_rs1(instr_code) ((int8_t) (((instr_code >> 7) & 0b111) + 8))
 
+#define NUM_OF_COMPRESSED_CODES (1 << 16)
+
+// Decode index: 32 bit instructions are bucketed by opcode[6:2] and funct3,
+// compressed instructions by quadrant and funct3, each bucket lists candidate entries of instruction.def
+#define NUM_OF_DECODE_BUCKETS (256 + 24)
+#define DECODE_BUCKET_SIZE 16
+
+// Arithmetic with RISC-V semantics, division never traps
+inline int64_t RiscvDiv(int64_t a, int64_t b) {
+    if (b == 0)
+        return -1;
+    if (b == -1)                    // negate without overflow, the most negative value stays itself
+        return (int64_t) (0 - (uint64_t) a);
+    return a / b;
+}
+
+inline int64_t RiscvRem(int64_t a, int64_t b) {
+    if (b == 0)
+        return a;
+    if (b == -1)
+        return 0;
+    return a % b;
+}
+
+inline int64_t RiscvDivU(uint64_t a, uint64_t b) {
+    return b == 0 ? -1 : (int64_t) (a / b);
+}
+
+inline int64_t RiscvRemU(uint64_t a, uint64_t b) {
+    return b == 0 ? (int64_t) a : (int64_t) (a % b);
+}
+
+inline int64_t RiscvDivW(int32_t a, int32_t b) {
+    if (b == 0)
+        return -1;
+    if (b == -1)
+        return (int32_t) (0 - (uint32_t) a);
+    return a / b;
+}
+
+inline int64_t RiscvRemW(int32_t a, int32_t b) {
+    if (b == 0)
+        return a;
+    if (b == -1)
+        return 0;
+    return a % b;
+}
+
+inline int64_t RiscvDivUW(uint32_t a, uint32_t b) {
+    return (int64_t) (int32_t) (b == 0 ? 0xFFFFFFFF : a / b);
+}
+
+inline int64_t RiscvRemUW(uint32_t a, uint32_t b) {
+    return (int64_t) (int32_t) (b == 0 ? a : a % b);
+}
+
+// High 64 bits of the 128 bit product
+inline int64_t RiscvMulH(int64_t a, int64_t b) {
+    return (int64_t) (((__int128) a * (__int128) b) >> 64);
+}
+
+inline int64_t RiscvMulHU(uint64_t a, uint64_t b) {
+    return (int64_t) (((unsigned __int128) a * (unsigned __int128) b) >> 64);
+}
+
+inline int64_t RiscvMulHSU(int64_t a, uint64_t b) {
+    return (int64_t) (((__int128) a * (__int128) b) >> 64);
+}
+
 class Instruction {
 private:
     // Private decode functions for different instr formats
@@ -161,6 +283,18 @@ private:
     // Extend sign of imm
     void ImmSignExtend(int num_of_bits);
 
+    // Find the entry of instruction.def which matches binary code and extract its fields
+    bool DecodeByDescription();
+
+    // Extract operand fields of given format from binary code
+    void DecodeFields(int8_t format);
+
+    // Set write_reg according to op_type
+    void SetWriteReg();
+
+    // Fill decode index and compressed expansion table, run once by BuildDecodeTables
+    static void FillDecodeTables();
+
 public:
     int32_t binary_code;            // binary code of the instruction
     int32_t imm;                    // immediate decoded from binary code
@@ -176,12 +310,27 @@ public:
     bool write_reg;                 // do the instruction need to write registers?
     int64_t instr_pc;               // pc of this instruction
     int64_t write_back_value;       // value to be write back
+    int64_t trace_id;               // id in pipeline trace, -1 if not traced
 
-    // Decode the instruction
+    // Decode the instruction, compressed instructions are looked up from the expansion table
     bool Decode();
 
+    // Build the decode index from instruction.def and expand all compressed instructions
+    // Safe to call from any thread and any number of times, the tables are filled only once
+    static void BuildDecodeTables();
+
+    // Hash of op type, format, mask, match and name of every entry of instruction.def
+    // Decodes saved by another build are only valid if it is the same
+    static uint64_t DescriptionHash();
+
     // Print the semantic meaning of the instruction
     void Print();
+
+    // Print the semantic meaning of the instruction to given file
+    void Print(FILE *file);
+
+    // Write the semantic meaning of the instruction to buffer, without pc
+    void Disassemble(char *buffer, int32_t size);
 };
 
 #endif //RISC_V_SIMULATOR_INSTRUCTION_H
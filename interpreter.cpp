@@ -0,0 +1,669 @@
+//
+// Name: interpreter
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "interpreter.h"
+#include "machine.h"
+#include "stats.h"
+#include "jit.h"
+#include <cstring>
+
+DecodeCache::DecodeCache(void *decode_handler) {
+    this->decode_handler = decode_handler;
+    this->low_address = 0;
+    this->high_address = 0;
+}
+
+DecodeCache::~DecodeCache() {
+    for (std::map<int64_t, DecodedPage *>::iterator it = pages.begin(); it != pages.end(); it++)
+        delete it->second;
+}
+
+void DecodeCache::ResetPage(DecodedPage *page) {
+    for (int i = 0; i < SLOTS_PER_DECODED_PAGE; i++) {
+        page->slots[i].handler = decode_handler;
+        page->slots[i].native = NULL;
+        page->slots[i].heat = 0;
+    }
+}
+
+DecodedPage *DecodeCache::GetPage(int64_t address) {
+    int64_t start_address = address & ~((int64_t) PageSize - 1);
+    std::map<int64_t, DecodedPage *>::iterator it = pages.find(start_address);
+    if (it != pages.end())
+        return it->second;
+
+    DecodedPage *page = new DecodedPage;
+    page->start_address = start_address;
+    this->ResetPage(page);
+    if (pages.empty() || start_address < low_address)
+        low_address = start_address;
+    if (pages.empty() || start_address + PageSize > high_address)
+        high_address = start_address + PageSize;
+    pages.insert(std::make_pair(start_address, page));
+    return page;
+}
+
+void DecodeCache::InvalidatePage(int64_t address) {
+    std::map<int64_t, DecodedPage *>::iterator it = pages.find(address & ~((int64_t) PageSize - 1));
+    if (it != pages.end())
+        this->ResetPage(it->second);
+}
+
+void DecodeCache::ClearNative() {
+    for (std::map<int64_t, DecodedPage *>::iterator it = pages.begin(); it != pages.end(); it++) {
+        for (int i = 0; i < SLOTS_PER_DECODED_PAGE; i++) {
+            it->second->slots[i].native = NULL;
+            it->second->slots[i].heat = 0;
+        }
+    }
+}
+
+char fusion_strings[NUM_OF_FUSIONS][16] = {"lui+addi", "lui+addiw", "auipc+addi", "auipc+jalr", "auipc+ld",
+                                           "compare+branch", "li+branch"};
+
+// Read and decode the instruction at pc into slot, handler of the slot is not changed
+// Decoded fields are copied from pre-decoded image if there is one
+static bool DecodeSlot(Memory *memory, ImageCache *image_cache, int64_t pc, DecodedInstruction *slot) {
+    int64_t value;
+    Instruction *instruction = &slot->instruction;
+    memset(instruction, 0, sizeof(Instruction));
+    memory->ReadMemory(pc, sizeof(int16_t), &value);
+    instruction->binary_code = (int32_t) (uint16_t) value;
+    slot->length = 2;
+    if (Decode_c_opcode(instruction->binary_code) == 0x3) {
+        // Upper half may be in next page
+        memory->ReadMemory(pc + 2, sizeof(int16_t), &value);
+        instruction->binary_code |= (int32_t) value << 16;
+        slot->length = 4;
+    }
+    instruction->instr_pc = pc;
+    instruction->trace_id = -1;
+    if (image_cache != NULL && image_cache->Lookup(pc, instruction))
+        return true;
+    return instruction->Decode();
+}
+
+// Find the fusion of an instruction pair, return -1 if they can not be fused
+static int32_t FindFusion(Instruction *first, Instruction *second) {
+    // The second instruction consumes the result of the first one
+    bool dependent = second->rs1 == first->rd || (IsBranch(second->op_type) && second->rs2 == first->rd);
+    if (!dependent || first->rd == REG_zero)
+        return -1;
+
+    switch (first->op_type) {
+        case OP_LUI:
+            if (second->op_type == OP_ADDI)
+                return FUSION_LUI_ADDI;
+            if (second->op_type == OP_ADDIW)
+                return FUSION_LUI_ADDIW;
+            break;
+        case OP_AUIPC:
+            if (second->op_type == OP_ADDI)
+                return FUSION_AUIPC_ADDI;
+            if (second->op_type == OP_JALR && second->instr_type != INSTR_CR)
+                return FUSION_AUIPC_JALR;
+            if (second->op_type == OP_LD)
+                return FUSION_AUIPC_LD;
+            break;
+        case OP_SLT:
+        case OP_SLTI:
+            if (IsBranch(second->op_type))
+                return FUSION_COMPARE_BRANCH;
+            break;
+        case OP_LI:
+            if (IsBranch(second->op_type))
+                return FUSION_LI_BRANCH;
+            break;
+        case OP_ADDI:
+            if (first->rs1 == REG_zero && IsBranch(second->op_type))
+                return FUSION_LI_BRANCH;
+            break;
+        default:
+            break;
+    }
+    return -1;
+}
+
+// Helper macros of Machine::RunFunctional, I is the instruction being executed
+#define I (entry->instruction)
+
+#define WRITE_RD(value)                                                                           \
+    {                                                                                             \
+        registers[I.rd] = (value);                                                                \
+        registers[REG_zero] = 0;                                                                  \
+    }                                                                                             \
+
+// Every handler ends with its own indirect jump, so the host predicts each of them separately
+#define DISPATCH()                                                                                \
+    {                                                                                             \
+        executed++;                                                                               \
+        if ((uint64_t) (pc - page->start_address) >= PageSize)                                    \
+            page = decode_cache->GetPage(pc);                                                     \
+        entry = &page->slots[(pc - page->start_address) >> 1];                                    \
+        goto *entry->handler;                                                                     \
+    }                                                                                             \
+
+#define NEXT()                                                                                    \
+    {                                                                                             \
+        pc += entry->length;                                                                      \
+        DISPATCH();                                                                               \
+    }                                                                                             \
+
+// Blocks start at jump targets, so only jumps look for translated code
+#define JUMP(target)                                                                              \
+    {                                                                                             \
+        pc = (target);                                                                            \
+        if (jit != NULL)                                                                          \
+            goto enter_block;                                                                     \
+        DISPATCH();                                                                               \
+    }                                                                                             \
+
+#define BRANCH(condition)                                                                         \
+    {                                                                                             \
+        if (condition)                                                                            \
+            JUMP(pc + I.imm);                                                                     \
+        NEXT();                                                                                   \
+    }                                                                                             \
+
+#define LOAD(address, size)                                                                       \
+    {                                                                                             \
+        main_memory->ReadMemory((address), (size), &value);                                       \
+    }                                                                                             \
+
+#define STORE(address, size)                                                                      \
+    {                                                                                             \
+        int64_t store_address = (address);                                                        \
+        main_memory->WriteMemory(store_address, (size), registers[I.rs2]);                        \
+        decode_cache->Invalidate(store_address, (size));                                          \
+        if (jit != NULL)                                                                          \
+            jit->CodeWritten(store_address, (size));                                              \
+        NEXT();                                                                                   \
+    }                                                                                             \
+
+// Second instruction of a fused pair is in the next slot
+#define SECOND (entry[entry->length >> 1])
+#define S (SECOND.instruction)
+
+#define WRITE_RD2(value)                                                                          \
+    {                                                                                             \
+        registers[S.rd] = (value);                                                                \
+        registers[REG_zero] = 0;                                                                  \
+    }                                                                                             \
+
+#define FUSED_NEXT(counter)                                                                       \
+    {                                                                                             \
+        counter++;                                                                                \
+        executed++;                                                                               \
+        pc += entry->length + SECOND.length;                                                      \
+        DISPATCH();                                                                               \
+    }                                                                                             \
+
+#define FUSED_BRANCH(counter)                                                                     \
+    {                                                                                             \
+        counter++;                                                                                \
+        executed++;                                                                               \
+        pc += entry->length;                                                                      \
+        if (BranchTaken(&S, registers))                                                           \
+            JUMP(pc + S.imm);                                                                     \
+        pc += SECOND.length;                                                                      \
+        DISPATCH();                                                                               \
+    }                                                                                             \
+
+// Executed instructions are added to stats before they may be read, one instruction takes one cycle
+#define SYNC_STATS()                                                                              \
+    {                                                                                             \
+        stats->AddInstructions(executed - synced);                                                \
+        stats->AddCycle(executed - synced);                                                       \
+        synced = executed;                                                                        \
+    }                                                                                             \
+
+void Machine::RunFunctional(bool use_jit) {
+    // Handler of each op type, ops which are decoded but not implemented go to op_invalid
+    void *handlers[NUM_OF_OP_TYPES];
+    for (int i = 0; i < NUM_OF_OP_TYPES; i++)
+        handlers[i] = &&op_invalid;
+    handlers[OP_ADD] = &&op_add;
+    handlers[OP_MUL] = &&op_mul;
+    handlers[OP_SUB] = &&op_sub;
+    handlers[OP_SLL] = &&op_sll;
+    handlers[OP_MULH] = &&op_mulh;
+    handlers[OP_SLT] = &&op_slt;
+    handlers[OP_XOR] = &&op_xor;
+    handlers[OP_DIV] = &&op_div;
+    handlers[OP_SRL] = &&op_srl;
+    handlers[OP_SRA] = &&op_sra;
+    handlers[OP_OR] = &&op_or;
+    handlers[OP_REM] = &&op_rem;
+    handlers[OP_AND] = &&op_and;
+    handlers[OP_LB] = &&op_lb;
+    handlers[OP_LH] = &&op_lh;
+    handlers[OP_LW] = &&op_lw;
+    handlers[OP_LD] = &&op_ld;
+    handlers[OP_ADDI] = &&op_addi;
+    handlers[OP_SLLI] = &&op_slli;
+    handlers[OP_SLTI] = &&op_slti;
+    handlers[OP_XORI] = &&op_xori;
+    handlers[OP_SRLI] = &&op_srli;
+    handlers[OP_SRAI] = &&op_srai;
+    handlers[OP_ORI] = &&op_ori;
+    handlers[OP_ANDI] = &&op_andi;
+    handlers[OP_ADDIW] = &&op_addiw;
+    handlers[OP_JALR] = &&op_jalr;
+    handlers[OP_ECALL] = &&op_ecall;
+    handlers[OP_SB] = &&op_sb;
+    handlers[OP_SH] = &&op_sh;
+    handlers[OP_SW] = &&op_sw;
+    handlers[OP_SD] = &&op_sd;
+    handlers[OP_BEQ] = &&op_beq;
+    handlers[OP_BNE] = &&op_bne;
+    handlers[OP_BLT] = &&op_blt;
+    handlers[OP_BGE] = &&op_bge;
+    handlers[OP_AUIPC] = &&op_auipc;
+    handlers[OP_LUI] = &&op_lui;
+    handlers[OP_JAL] = &&op_jal;
+    handlers[OP_LI] = &&op_li;
+    handlers[OP_SUBW] = &&op_subw;
+    handlers[OP_ADDW] = &&op_addw;
+    handlers[OP_J] = &&op_j;
+    handlers[OP_BEQZ] = &&op_beqz;
+    handlers[OP_BNEZ] = &&op_bnez;
+    handlers[OP_LWSP] = &&op_lwsp;
+    handlers[OP_LDSP] = &&op_ldsp;
+    handlers[OP_SWSP] = &&op_swsp;
+    handlers[OP_SDSP] = &&op_sdsp;
+    handlers[OP_MV] = &&op_mv;
+    handlers[OP_BLTU] = &&op_bltu;
+    handlers[OP_BGEU] = &&op_bgeu;
+    handlers[OP_JR] = &&op_jr;
+    handlers[OP_SLLIW] = &&op_slliw;
+    handlers[OP_SRLIW] = &&op_srliw;
+    handlers[OP_SRAIW] = &&op_sraiw;
+    handlers[OP_SLLW] = &&op_sllw;
+    handlers[OP_SRLW] = &&op_srlw;
+    handlers[OP_SRAW] = &&op_sraw;
+    handlers[OP_LBU] = &&op_lbu;
+    handlers[OP_LHU] = &&op_lhu;
+    handlers[OP_MULW] = &&op_mulw;
+    handlers[OP_CSRRW] = &&op_csr;
+    handlers[OP_CSRRS] = &&op_csr;
+    handlers[OP_CSRRC] = &&op_csr;
+    handlers[OP_CSRRWI] = &&op_csr;
+    handlers[OP_CSRRSI] = &&op_csr;
+    handlers[OP_CSRRCI] = &&op_csr;
+    handlers[OP_SLTU] = &&op_sltu;
+    handlers[OP_SLTIU] = &&op_sltiu;
+    handlers[OP_MULHSU] = &&op_mulhsu;
+    handlers[OP_MULHU] = &&op_mulhu;
+    handlers[OP_DIVU] = &&op_divu;
+    handlers[OP_REMU] = &&op_remu;
+    handlers[OP_DIVW] = &&op_divw;
+    handlers[OP_DIVUW] = &&op_divuw;
+    handlers[OP_REMW] = &&op_remw;
+    handlers[OP_REMUW] = &&op_remuw;
+    handlers[OP_LWU] = &&op_lwu;
+
+    void *fusion_handlers[NUM_OF_FUSIONS];
+    fusion_handlers[FUSION_LUI_ADDI] = &&fuse_lui_addi;
+    fusion_handlers[FUSION_LUI_ADDIW] = &&fuse_lui_addiw;
+    fusion_handlers[FUSION_AUIPC_ADDI] = &&fuse_auipc_addi;
+    fusion_handlers[FUSION_AUIPC_JALR] = &&fuse_auipc_jalr;
+    fusion_handlers[FUSION_AUIPC_LD] = &&fuse_auipc_ld;
+    fusion_handlers[FUSION_COMPARE_BRANCH] = &&fuse_compare_branch;
+    fusion_handlers[FUSION_LI_BRANCH] = &&fuse_li_branch;
+
+    if (decode_cache == NULL)
+        decode_cache = new DecodeCache(&&decode);
+    // Translated blocks run without the estimator seeing their instructions
+    ASSERT(!use_jit || cpi_estimator == NULL);
+    if (use_jit && jit == NULL)
+        jit = new JIT(main_memory, decode_cache);
+
+    ASSERT(!this->exit_flag);
+    int64_t pc = this->reg_pc;
+    int64_t executed = 0, synced = 0;
+    int64_t value;
+    DecodedPage *page = decode_cache->GetPage(pc);
+    DecodedInstruction *entry;
+    if (jit != NULL)
+        goto enter_block;
+    DISPATCH();
+
+    enter_block:
+    {
+        // Run translated code from pc as long as there is any, translate hot blocks
+        if (jit->NeedFlush())
+            jit->Flush();
+        if ((uint64_t) (pc - page->start_address) >= PageSize)
+            page = decode_cache->GetPage(pc);
+        entry = &page->slots[(pc - page->start_address) >> 1];
+        if (entry->native == NULL && entry->heat >= 0 && ++entry->heat >= JIT_HOT_THRESHOLD)
+            jit->Translate(pc, entry);
+        if (entry->native != NULL) {
+            pc = jit->Run(registers, entry->native);
+            executed += jit->TakeExecuted();
+            goto enter_block;
+        }
+        executed++;
+        goto *entry->handler;
+    }
+
+    decode:
+    {
+        // First execution of the slot, decode it and patch its handler
+        if (!DecodeSlot(main_memory, image_cache, pc, entry)) {
+            this->reg_pc = pc;
+            SYNC_STATS();
+            this->DumpState();
+            FATAL("Decode error, machine state dumped\n");
+        }
+        entry->handler = handlers[entry->instruction.op_type];
+
+        // Estimator observes every instruction on its own, so it gets the slot and pairs are not fused
+        if (cpi_estimator != NULL) {
+            entry->handler = &&observe;
+            goto observe;
+        }
+
+        // Fuse with next instruction if it is in the same page, next slot keeps its own handler for jumps into it
+        if (pc - page->start_address + entry->length < PageSize &&
+            DecodeSlot(main_memory, image_cache, pc + entry->length, &SECOND)) {
+            int32_t fusion = FindFusion(&entry->instruction, &S);
+            if (fusion >= 0) {
+                entry->handler = fusion_handlers[fusion];
+                fusion_sites[fusion]++;
+            }
+        }
+        goto *entry->handler;
+    }
+
+    observe:
+    cpi_estimator->Observe(&I, pc, entry->length, registers);
+    goto *handlers[I.op_type];
+
+    // Fused pairs run both instructions in one handler
+    fuse_lui_addi:
+    WRITE_RD(I.imm);
+    WRITE_RD2(registers[S.rs1] + S.imm);
+    FUSED_NEXT(fusion_counts[FUSION_LUI_ADDI]);
+    fuse_lui_addiw:
+    WRITE_RD(I.imm);
+    WRITE_RD2((int64_t) ((int32_t) (registers[S.rs1] + S.imm)));
+    FUSED_NEXT(fusion_counts[FUSION_LUI_ADDIW]);
+    fuse_auipc_addi:
+    WRITE_RD(pc + I.imm);
+    WRITE_RD2(registers[S.rs1] + S.imm);
+    FUSED_NEXT(fusion_counts[FUSION_AUIPC_ADDI]);
+    fuse_auipc_jalr:
+    WRITE_RD(pc + I.imm);
+    value = ((registers[S.rs1] + S.imm) >> 1) << 1;
+    WRITE_RD2(pc + entry->length + 4);
+    fusion_counts[FUSION_AUIPC_JALR]++;
+    executed++;
+    JUMP(value);
+    fuse_auipc_ld:
+    WRITE_RD(pc + I.imm);
+    LOAD(registers[S.rs1] + S.imm, 8);
+    WRITE_RD2(value);
+    FUSED_NEXT(fusion_counts[FUSION_AUIPC_LD]);
+    fuse_compare_branch:
+    if (I.op_type == OP_SLT)
+        WRITE_RD(registers[I.rs1] < registers[I.rs2] ? 1 : 0)
+    else
+        WRITE_RD(registers[I.rs1] < I.imm ? 1 : 0)
+    FUSED_BRANCH(fusion_counts[FUSION_COMPARE_BRANCH]);
+    fuse_li_branch:
+    WRITE_RD(I.op_type == OP_LI ? (int64_t) I.imm : registers[I.rs1] + I.imm);
+    FUSED_BRANCH(fusion_counts[FUSION_LI_BRANCH]);
+
+    op_add:
+    WRITE_RD(registers[I.rs1] + registers[I.rs2]);
+    NEXT();
+    op_mul:
+    WRITE_RD(registers[I.rs1] * registers[I.rs2]);
+    NEXT();
+    op_sub:
+    WRITE_RD(registers[I.rs1] - registers[I.rs2]);
+    NEXT();
+    op_sll:
+    WRITE_RD(registers[I.rs1] << (registers[I.rs2] & 0b111111));
+    NEXT();
+    op_mulh:
+    WRITE_RD(RiscvMulH(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_slt:
+    WRITE_RD(registers[I.rs1] < registers[I.rs2] ? 1 : 0);
+    NEXT();
+    op_xor:
+    WRITE_RD(registers[I.rs1] ^ registers[I.rs2]);
+    NEXT();
+    op_div:
+    WRITE_RD(RiscvDiv(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_srl:
+    WRITE_RD(((uint64_t) registers[I.rs1]) >> (registers[I.rs2] & 0b111111));
+    NEXT();
+    op_sra:
+    WRITE_RD(((int64_t) registers[I.rs1]) >> (registers[I.rs2] & 0b111111));
+    NEXT();
+    op_or:
+    WRITE_RD(registers[I.rs1] | registers[I.rs2]);
+    NEXT();
+    op_rem:
+    WRITE_RD(RiscvRem(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_and:
+    WRITE_RD(registers[I.rs1] & registers[I.rs2]);
+    NEXT();
+    op_lb:
+    LOAD(registers[I.rs1] + I.imm, 1);
+    WRITE_RD(value);
+    NEXT();
+    op_lh:
+    LOAD(registers[I.rs1] + I.imm, 2);
+    WRITE_RD(value);
+    NEXT();
+    op_lw:
+    LOAD(registers[I.rs1] + I.imm, 4);
+    WRITE_RD(value);
+    NEXT();
+    op_ld:
+    LOAD(registers[I.rs1] + I.imm, 8);
+    WRITE_RD(value);
+    NEXT();
+    op_addi:
+    WRITE_RD(registers[I.rs1] + I.imm);
+    NEXT();
+    op_slli:
+    WRITE_RD(registers[I.rs1] << (I.imm & 0b111111));
+    NEXT();
+    op_slti:
+    WRITE_RD(registers[I.rs1] < I.imm ? 1 : 0);
+    NEXT();
+    op_xori:
+    WRITE_RD(registers[I.rs1] ^ I.imm);
+    NEXT();
+    op_srli:
+    WRITE_RD(((uint64_t) registers[I.rs1]) >> (I.imm & 0b111111));
+    NEXT();
+    op_srai:
+    WRITE_RD(((int64_t) registers[I.rs1]) >> (I.imm & 0b111111));
+    NEXT();
+    op_ori:
+    WRITE_RD(registers[I.rs1] | I.imm);
+    NEXT();
+    op_andi:
+    WRITE_RD(registers[I.rs1] & I.imm);
+    NEXT();
+    op_addiw:
+    WRITE_RD((int64_t) ((int32_t) (registers[I.rs1] + I.imm)));
+    NEXT();
+    op_jalr:
+    if (I.instr_type == INSTR_CR) {
+        value = registers[I.rs1];
+        WRITE_RD(pc + 2);
+    } else {
+        value = ((registers[I.rs1] + I.imm) >> 1) << 1;
+        WRITE_RD(pc + 4);
+    }
+    JUMP(value);
+    op_ecall:
+    SYNC_STATS();
+    // Decoded instruction is reused, clear the result of last system call
+    I.write_reg = false;
+    this->HandleSystemCall(&I, registers[REG_a7], &registers[REG_a0]);
+    if (I.write_reg)
+        WRITE_RD(I.write_back_value);
+    if (this->exit_flag) {
+        this->reg_pc = pc;
+        return;
+    }
+    NEXT();
+    op_sb:
+    STORE(registers[I.rs1] + I.imm, 1);
+    op_sh:
+    STORE(registers[I.rs1] + I.imm, 2);
+    op_sw:
+    STORE(registers[I.rs1] + I.imm, 4);
+    op_sd:
+    STORE(registers[I.rs1] + I.imm, 8);
+    op_beq:
+    BRANCH(registers[I.rs1] == registers[I.rs2]);
+    op_bne:
+    BRANCH(registers[I.rs1] != registers[I.rs2]);
+    op_blt:
+    BRANCH(registers[I.rs1] < registers[I.rs2]);
+    op_bge:
+    BRANCH(registers[I.rs1] >= registers[I.rs2]);
+    op_auipc:
+    WRITE_RD(pc + I.imm);
+    NEXT();
+    op_lui:
+    WRITE_RD(I.imm);
+    NEXT();
+    op_jal:
+    WRITE_RD(pc + 4);
+    JUMP(pc + I.imm);
+    op_li:
+    WRITE_RD(I.imm);
+    NEXT();
+    op_subw:
+    WRITE_RD((int64_t) ((int32_t) (registers[I.rs1] - registers[I.rs2])));
+    NEXT();
+    op_addw:
+    WRITE_RD((int64_t) ((int32_t) (registers[I.rs1] + registers[I.rs2])));
+    NEXT();
+    op_j:
+    JUMP(pc + I.imm);
+    op_beqz:
+    BRANCH(registers[I.rs1] == 0);
+    op_bnez:
+    BRANCH(registers[I.rs1] != 0);
+    op_lwsp:
+    LOAD(registers[REG_sp] + I.imm, 4);
+    WRITE_RD(value);
+    NEXT();
+    op_ldsp:
+    LOAD(registers[REG_sp] + I.imm, 8);
+    WRITE_RD(value);
+    NEXT();
+    op_swsp:
+    STORE(registers[REG_sp] + I.imm, 4);
+    op_sdsp:
+    STORE(registers[REG_sp] + I.imm, 8);
+    op_mv:
+    WRITE_RD(registers[I.rs2]);
+    NEXT();
+    op_bltu:
+    BRANCH((uint64_t) registers[I.rs1] < (uint64_t) registers[I.rs2]);
+    op_bgeu:
+    BRANCH((uint64_t) registers[I.rs1] >= (uint64_t) registers[I.rs2]);
+    op_jr:
+    JUMP(registers[I.rs1]);
+    op_slliw:
+    WRITE_RD((int64_t) (((int32_t) registers[I.rs1]) << (I.imm & 0b11111)));
+    NEXT();
+    op_srliw:
+    WRITE_RD((int64_t) (int32_t) (((uint32_t) registers[I.rs1]) >> (I.imm & 0b11111)));
+    NEXT();
+    op_sraiw:
+    WRITE_RD((int64_t) (((int32_t) registers[I.rs1]) >> (I.imm & 0b11111)));
+    NEXT();
+    op_sllw:
+    WRITE_RD((int64_t) (((int32_t) registers[I.rs1]) << (registers[I.rs2] & 0b11111)));
+    NEXT();
+    op_srlw:
+    WRITE_RD((int64_t) (int32_t) (((uint32_t) registers[I.rs1]) >> (registers[I.rs2] & 0b11111)));
+    NEXT();
+    op_sraw:
+    WRITE_RD((int64_t) (((int32_t) registers[I.rs1]) >> (registers[I.rs2] & 0b11111)));
+    NEXT();
+    op_lbu:
+    LOAD(registers[I.rs1] + I.imm, 1);
+    WRITE_RD((int64_t) ((uint8_t) value));
+    NEXT();
+    op_lhu:
+    LOAD(registers[I.rs1] + I.imm, 2);
+    WRITE_RD((int64_t) ((uint16_t) value));
+    NEXT();
+    op_mulw:
+    WRITE_RD((int64_t) ((int32_t) registers[I.rs1] * (int32_t) registers[I.rs2]));
+    NEXT();
+    op_csr:
+    SYNC_STATS();
+    value = this->ExecuteCSR(&I, registers[I.rs1]);
+    WRITE_RD(value);
+    NEXT();
+    op_sltu:
+    WRITE_RD((uint64_t) registers[I.rs1] < (uint64_t) registers[I.rs2] ? 1 : 0);
+    NEXT();
+    op_sltiu:
+    WRITE_RD((uint64_t) registers[I.rs1] < (uint64_t) (int64_t) I.imm ? 1 : 0);
+    NEXT();
+    op_mulhsu:
+    WRITE_RD(RiscvMulHSU(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_mulhu:
+    WRITE_RD(RiscvMulHU(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_divu:
+    WRITE_RD(RiscvDivU(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_remu:
+    WRITE_RD(RiscvRemU(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_divw:
+    WRITE_RD(RiscvDivW(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_divuw:
+    WRITE_RD(RiscvDivUW(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_remw:
+    WRITE_RD(RiscvRemW(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_remuw:
+    WRITE_RD(RiscvRemUW(registers[I.rs1], registers[I.rs2]));
+    NEXT();
+    op_lwu:
+    LOAD(registers[I.rs1] + I.imm, 4);
+    WRITE_RD((int64_t) ((uint32_t) value));
+    NEXT();
+    op_invalid:
+    this->reg_pc = pc;
+    SYNC_STATS();
+    FATAL("Invalid op type %d\n", I.op_type);
+}
+
+void Machine::PrintFusionStats() {
+    int64_t instructions = stats->GetInstructions();
+    printf("\n****************\n");
+    printf("%-16s %10s %14s %12s\n", "Fused pair", "Sites", "Executions", "Coverage");
+    for (int i = 0; i < NUM_OF_FUSIONS; i++) {
+        // A fused pair covers two instructions
+        double coverage = instructions == 0 ? 0 : 200.0 * fusion_counts[i] / instructions;
+        printf("%-16s %10ld %14ld %11.2lf%%\n", fusion_strings[i], fusion_sites[i], fusion_counts[i], coverage);
+    }
+}
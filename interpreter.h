@@ -0,0 +1,118 @@
+//
+// Name: interpreter
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_INTERPRETER_H
+#define RISC_V_SIMULATOR_INTERPRETER_H
+
+#include "utility.h"
+#include "instruction.h"
+#include <map>
+
+// Instruction pairs fused into one handler
+#define FUSION_LUI_ADDI 0
+#define FUSION_LUI_ADDIW 1
+#define FUSION_AUIPC_ADDI 2
+#define FUSION_AUIPC_JALR 3
+#define FUSION_AUIPC_LD 4
+#define FUSION_COMPARE_BRANCH 5
+#define FUSION_LI_BRANCH 6
+#define NUM_OF_FUSIONS 7
+
+// Instructions are 2 byte aligned, so a page has PageSize / 2 slots
+#define SLOTS_PER_DECODED_PAGE (PageSize >> 1)
+
+// Is op type a conditional branch?
+static inline bool IsBranch(int8_t op_type) {
+    switch (op_type) {
+        case OP_BEQ:
+        case OP_BNE:
+        case OP_BLT:
+        case OP_BGE:
+        case OP_BLTU:
+        case OP_BGEU:
+        case OP_BEQZ:
+        case OP_BNEZ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Is the branch taken, same as Machine::Execute
+static inline bool BranchTaken(const Instruction *branch, const int64_t *registers) {
+    int64_t value_rs1 = registers[branch->rs1], value_rs2 = registers[branch->rs2];
+    switch (branch->op_type) {
+        case OP_BEQ:
+            return value_rs1 == value_rs2;
+        case OP_BNE:
+            return value_rs1 != value_rs2;
+        case OP_BLT:
+            return value_rs1 < value_rs2;
+        case OP_BGE:
+            return value_rs1 >= value_rs2;
+        case OP_BLTU:
+            return (uint64_t) value_rs1 < (uint64_t) value_rs2;
+        case OP_BGEU:
+            return (uint64_t) value_rs1 >= (uint64_t) value_rs2;
+        case OP_BEQZ:
+            return value_rs1 == 0;
+        case OP_BNEZ:
+            return value_rs1 != 0;
+        default: FATAL("Invalid branch op type %d\n", branch->op_type);
+    }
+}
+
+// Instruction decoded once, with the address of its handler in the functional interpreter
+typedef struct DecodedInstruction_ {
+    void *handler;                  // label of handler, or of decode routine if not decoded yet
+    int64_t length;                 // length of the instruction in bytes, 2 or 4
+    void *native;                   // translated block which starts here, NULL if not translated
+    int32_t heat;                   // times a block is entered here, -1 if it can not be translated
+    Instruction instruction;
+} DecodedInstruction;
+
+// Decoded instructions of one code page
+typedef struct DecodedPage_ {
+    int64_t start_address;
+    DecodedInstruction slots[SLOTS_PER_DECODED_PAGE];
+} DecodedPage;
+
+class DecodeCache {
+private:
+    std::map<int64_t, DecodedPage *> pages;     // decoded pages indexed by start address
+    void *decode_handler;                       // handler of slots which are not decoded
+    int64_t low_address;                        // all decoded pages are in [low_address, high_address)
+    int64_t high_address;
+
+    // Reset all slots of page to be decoded again
+    void ResetPage(DecodedPage *page);
+
+public:
+    DecodeCache(void *decode_handler);
+
+    ~DecodeCache();
+
+    // Find or create the decoded page which contains given address
+    DecodedPage *GetPage(int64_t address);
+
+    // A store to [address, address + size) modified code, decode the page again when it is executed
+    inline void Invalidate(int64_t address, int32_t size) {
+        // Data is rarely stored near code, filter most stores by address range
+        if (address + size <= low_address || address >= high_address)
+            return;
+        this->InvalidatePage(address);
+        this->InvalidatePage(address + size - 1);
+    }
+
+    // Decode the page which contains given address again when it is executed
+    void InvalidatePage(int64_t address);
+
+    // Detach all translated blocks and reset their heat
+    void ClearNative();
+};
+
+#endif //RISC_V_SIMULATOR_INTERPRETER_H
@@ -0,0 +1,82 @@
+//
+// Name: interval_stats
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "interval_stats.h"
+
+#define NUM_OF_INTERVAL_FIELDS (6 + 6 * NUM_OF_STORAGE_LEVELS)
+
+static const char *storage_level_names[NUM_OF_STORAGE_LEVELS] = {"l1", "l2", "l3", "mem"};
+
+IntervalSampler::IntervalSampler(const char *file_name, int format, int64_t interval) {
+    ASSERT(format == INTERVAL_FORMAT_CSV || format == INTERVAL_FORMAT_BINARY);
+    ASSERT(interval > 0);
+    this->writer = new BufferedWriter(file_name, DEFAULT_WRITER_BUFFER_SIZE);
+    this->format = format;
+    this->interval = interval;
+    this->next_sample_cycle = interval;
+    memset(&this->last, 0, sizeof(this->last));
+    this->WriteHeader();
+}
+
+IntervalSampler::~IntervalSampler() {
+    delete writer;
+}
+
+void IntervalSampler::WriteHeader() {
+    if (format == INTERVAL_FORMAT_BINARY) {
+        int32_t header[3] = {INTERVAL_BINARY_MAGIC, INTERVAL_BINARY_VERSION, NUM_OF_INTERVAL_FIELDS};
+        writer->Write(header, sizeof(header));
+        return;
+    }
+
+    writer->Printf("cycle,instructions,cycles,ctrl_stalls,data_stalls,memory_stalls");
+    for (int i = 0; i < NUM_OF_STORAGE_LEVELS; i++) {
+        const char *name = storage_level_names[i];
+        writer->Printf(",%s_access,%s_miss,%s_access_time,%s_replace,%s_fetch,%s_prefetch",
+                       name, name, name, name, name, name);
+    }
+    writer->Printf("\n");
+}
+
+void IntervalSampler::Sample(const IntervalSnapshot &current) {
+    int64_t record[NUM_OF_INTERVAL_FIELDS];
+    record[0] = current.cycles;
+    record[1] = current.instructions - last.instructions;
+    record[2] = current.cycles - last.cycles;
+    record[3] = current.stalls_by_ctrl - last.stalls_by_ctrl;
+    record[4] = current.stalls_by_data - last.stalls_by_data;
+    record[5] = current.stalls_by_memory - last.stalls_by_memory;
+    for (int i = 0; i < NUM_OF_STORAGE_LEVELS; i++) {
+        int64_t *level_record = &record[6 + 6 * i];
+        level_record[0] = current.storage[i].access_counter - last.storage[i].access_counter;
+        level_record[1] = current.storage[i].miss_num - last.storage[i].miss_num;
+        level_record[2] = current.storage[i].access_time - last.storage[i].access_time;
+        level_record[3] = current.storage[i].replace_num - last.storage[i].replace_num;
+        level_record[4] = current.storage[i].fetch_num - last.storage[i].fetch_num;
+        level_record[5] = current.storage[i].prefetch_num - last.storage[i].prefetch_num;
+    }
+
+    if (format == INTERVAL_FORMAT_BINARY) {
+        writer->Write(record, sizeof(record));
+    } else {
+        writer->Printf("%ld", record[0]);
+        for (int i = 1; i < NUM_OF_INTERVAL_FIELDS; i++)
+            writer->Printf(",%ld", record[i]);
+        writer->Printf("\n");
+    }
+
+    last = current;
+    // Long memory stalls may cross several intervals, they are reported in one record
+    while (next_sample_cycle <= current.cycles)
+        next_sample_cycle += interval;
+}
+
+void IntervalSampler::Finish(const IntervalSnapshot &current) {
+    if (current.cycles != last.cycles)
+        this->Sample(current);
+    writer->Flush();
+}
@@ -0,0 +1,67 @@
+//
+// Name: interval_stats
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_INTERVAL_STATS_H
+#define RISC_V_SIMULATOR_INTERVAL_STATS_H
+
+#include "utility.h"
+#include "storage.h"
+#include "buffered_writer.h"
+
+#define INTERVAL_FORMAT_CSV 0
+#define INTERVAL_FORMAT_BINARY 1
+
+#define DEFAULT_INTERVAL 100000
+
+#define STORAGE_LEVEL_L1 0
+#define STORAGE_LEVEL_L2 1
+#define STORAGE_LEVEL_L3 2
+#define STORAGE_LEVEL_MEMORY 3
+#define NUM_OF_STORAGE_LEVELS 4
+
+// Binary format: "RVIS" magic, version, number of int64 fields per record,
+// then one record of little endian int64 values per interval in the order of the CSV header
+#define INTERVAL_BINARY_MAGIC 0x53495652
+#define INTERVAL_BINARY_VERSION 1
+
+// Counters of the whole machine at one moment
+typedef struct IntervalSnapshot_ {
+    int64_t instructions;
+    int64_t cycles;
+    int64_t stalls_by_ctrl;
+    int64_t stalls_by_data;
+    int64_t stalls_by_memory;
+    StorageStats storage[NUM_OF_STORAGE_LEVELS];
+} IntervalSnapshot;
+
+class IntervalSampler {
+private:
+    BufferedWriter *writer;         // output file
+    int format;                     // one of INTERVAL_FORMAT_***
+    int64_t interval;               // sample once every interval cycles
+    int64_t next_sample_cycle;      // cycle number of next sample
+    IntervalSnapshot last;          // snapshot at the end of last interval
+
+    // Write header of output file
+    void WriteHeader();
+
+public:
+    IntervalSampler(const char *file_name, int format, int64_t interval);
+
+    ~IntervalSampler();
+
+    // Is a sample due at given cycle?
+    inline bool Due(int64_t cycle) const { return cycle >= next_sample_cycle; }
+
+    // Write the delta between current snapshot and last one
+    void Sample(const IntervalSnapshot &current);
+
+    // Write the last partial interval and flush output
+    void Finish(const IntervalSnapshot &current);
+};
+
+#endif //RISC_V_SIMULATOR_INTERVAL_STATS_H
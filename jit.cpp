@@ -0,0 +1,739 @@
+//
+// Name: jit
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "jit.h"
+#include <cstring>
+#include <cstddef>
+#include <sys/mman.h>
+
+// Entry of generated code: saves callee saved host registers, sets rbx = registers, rbp = context, jumps to block
+typedef int64_t (*JITEntry)(int64_t *registers, JITContext *context, void *block);
+
+// Helpers called by generated code, loads return the value in rax
+static int64_t JITLoad(JITContext *context, int64_t address, int64_t size) {
+    int64_t value;
+    context->memory->ReadMemory(address, (int32_t) size, &value);
+    return value;
+}
+
+static int64_t JITLoadUnsigned(JITContext *context, int64_t address, int64_t size) {
+    int64_t value;
+    context->memory->ReadMemory(address, (int32_t) size, &value);
+    if (size == 1)
+        return (int64_t) ((uint8_t) value);
+    if (size == 2)
+        return (int64_t) ((uint16_t) value);
+    return (int64_t) ((uint32_t) value);
+}
+
+// Division must not trap on zero or overflow like idiv does, MULHSU has no single host instruction
+static int64_t JITArithmetic(int64_t a, int64_t b, int64_t op_type) {
+    switch (op_type) {
+        case OP_DIV:
+            return RiscvDiv(a, b);
+        case OP_REM:
+            return RiscvRem(a, b);
+        case OP_DIVU:
+            return RiscvDivU(a, b);
+        case OP_REMU:
+            return RiscvRemU(a, b);
+        case OP_DIVW:
+            return RiscvDivW(a, b);
+        case OP_DIVUW:
+            return RiscvDivUW(a, b);
+        case OP_REMW:
+            return RiscvRemW(a, b);
+        case OP_REMUW:
+            return RiscvRemUW(a, b);
+        case OP_MULHSU:
+            return RiscvMulHSU(a, b);
+        default: FATAL("Invalid op type %ld\n", op_type);
+    }
+}
+
+static void JITStore(JITContext *context, int64_t address, int64_t value, int64_t size) {
+    context->memory->WriteMemory(address, (int32_t) size, value);
+    context->decode_cache->Invalidate(address, (int32_t) size);
+    context->jit->CodeWritten(address, (int32_t) size);
+}
+
+JIT::JIT(Memory *memory, DecodeCache *decode_cache) {
+    code_buffer = (uint8_t *) mmap(NULL, JIT_CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code_buffer == MAP_FAILED) {
+        FATAL("Unable to allocate JIT code buffer\n");
+    }
+    code_pointer = code_buffer;
+
+    // push rbx; push rbp; push r12; mov rbx, rdi; mov rbp, rsi; jmp rdx
+    // Three pushes keep rsp 16 byte aligned for helper calls
+    trampoline = code_pointer;
+    Emit8(0x53);
+    Emit8(0x55);
+    Emit8(0x41);
+    Emit8(0x54);
+    Emit8(0x48);
+    Emit8(0x89);
+    Emit8(0xFB);
+    Emit8(0x48);
+    Emit8(0x89);
+    Emit8(0xF5);
+    Emit8(0xFF);
+    Emit8(0xE2);
+
+    // pop r12; pop rbp; pop rbx; ret
+    exit_routine = code_pointer;
+    Emit8(0x41);
+    Emit8(0x5C);
+    Emit8(0x5D);
+    Emit8(0x5B);
+    Emit8(0xC3);
+
+    context.executed = 0;
+    context.flush = false;
+    context.memory = memory;
+    context.decode_cache = decode_cache;
+    context.jit = this;
+    low_address = 0;
+    high_address = 0;
+}
+
+JIT::~JIT() {
+    munmap(code_buffer, JIT_CODE_BUFFER_SIZE);
+}
+
+void JIT::Emit8(int32_t value) {
+    *code_pointer++ = (uint8_t) value;
+}
+
+void JIT::Emit32(int32_t value) {
+    memcpy(code_pointer, &value, sizeof(value));
+    code_pointer += sizeof(value);
+}
+
+void JIT::Emit64(int64_t value) {
+    memcpy(code_pointer, &value, sizeof(value));
+    code_pointer += sizeof(value);
+}
+
+void JIT::EmitLoadGuest(int32_t host, int32_t guest) {
+    if (guest == REG_zero) {
+        // xor host32, host32
+        Emit8(0x31);
+        Emit8(0xC0 | (host << 3) | host);
+        return;
+    }
+    // mov host, [rbx + guest * 8]
+    Emit8(0x48);
+    Emit8(0x8B);
+    Emit8(0x80 | (host << 3) | HOST_RBX);
+    Emit32(guest * sizeof(int64_t));
+}
+
+void JIT::EmitStoreGuest(int32_t guest, int32_t host) {
+    if (guest == REG_zero)
+        return;
+    // mov [rbx + guest * 8], host
+    Emit8(0x48);
+    Emit8(0x89);
+    Emit8(0x80 | (host << 3) | HOST_RBX);
+    Emit32(guest * sizeof(int64_t));
+}
+
+void JIT::EmitMoveImmediate(int32_t host, int64_t imm) {
+    if (imm == (int64_t) (int32_t) imm) {
+        // mov host, sign extended imm32
+        Emit8(0x48);
+        Emit8(0xC7);
+        Emit8(0xC0 | host);
+        Emit32((int32_t) imm);
+    } else {
+        // mov host, imm64
+        Emit8(0x48);
+        Emit8(0xB8 | host);
+        Emit64(imm);
+    }
+}
+
+void JIT::EmitCallHelper(void *helper) {
+    // mov rdi, rbp
+    Emit8(0x48);
+    Emit8(0x89);
+    Emit8(0xEF);
+    this->EmitCall(helper);
+}
+
+void JIT::EmitCall(void *function) {
+    // mov rax, function; call rax
+    Emit8(0x48);
+    Emit8(0xB8);
+    Emit64((int64_t) function);
+    Emit8(0xFF);
+    Emit8(0xD0);
+}
+
+void JIT::EmitExit(int64_t target, int32_t executed, bool chain) {
+    // add qword [rbp + executed], imm32
+    Emit8(0x48);
+    Emit8(0x81);
+    Emit8(0x45);
+    Emit8(offsetof(JITContext, executed));
+    Emit32(executed);
+    // mov rax, target; jmp exit_routine
+    Emit8(0x48);
+    Emit8(0xB8);
+    Emit64(target);
+    Emit8(0xE9);
+    uint8_t *site = code_pointer;
+    Emit32(0);
+    PatchJump(site, exit_routine);
+
+    if (chain) {
+        std::map<int64_t, uint8_t *>::iterator it = blocks.find(target);
+        if (it != blocks.end())
+            PatchJump(site, it->second);
+        else
+            pending_exits.insert(std::make_pair(target, site));
+    }
+}
+
+void JIT::EmitFlushCheck(int64_t next_pc, int32_t executed) {
+    // cmp byte [rbp + flush], 0; je over the exit
+    Emit8(0x80);
+    Emit8(0x7D);
+    Emit8(offsetof(JITContext, flush));
+    Emit8(0x00);
+    Emit8(0x74);
+    uint8_t *site = code_pointer;
+    Emit8(0);
+    // Flush discards all blocks, so this exit never chains
+    EmitExit(next_pc, executed, false);
+    *site = (uint8_t) (code_pointer - site - 1);
+}
+
+void JIT::PatchJump(uint8_t *site, uint8_t *target) {
+    int32_t offset = (int32_t) (target - (site + sizeof(int32_t)));
+    memcpy(site, &offset, sizeof(offset));
+}
+
+void JIT::AddCodePage(int64_t address) {
+    int64_t start_address = address & ~((int64_t) PageSize - 1);
+    if (code_pages.empty() || start_address < low_address)
+        low_address = start_address;
+    if (code_pages.empty() || start_address + PageSize > high_address)
+        high_address = start_address + PageSize;
+    code_pages.insert(start_address);
+}
+
+bool JIT::DecodeAt(int64_t pc, Instruction *instruction, int64_t *length) {
+    int64_t value;
+    memset(instruction, 0, sizeof(Instruction));
+    // Memory allocates untouched pages zero filled, so reading code can not fail
+    context.memory->ReadMemory(pc, sizeof(int16_t), &value);
+    instruction->binary_code = (int32_t) (uint16_t) value;
+    *length = 2;
+    if (Decode_c_opcode(instruction->binary_code) == 0x3) {
+        context.memory->ReadMemory(pc + 2, sizeof(int16_t), &value);
+        instruction->binary_code |= (int32_t) value << 16;
+        *length = 4;
+    }
+    instruction->instr_pc = pc;
+    instruction->trace_id = -1;
+    return instruction->Decode();
+}
+
+bool JIT::TranslateInstruction(Instruction *instruction, int64_t length, int32_t executed, bool *end_block) {
+    int64_t pc = instruction->instr_pc;
+    int32_t imm = instruction->imm;
+    int32_t rd = instruction->rd, rs1 = instruction->rs1, rs2 = instruction->rs2;
+    int32_t alu = -1;           // opcode of "op rax, rcx"
+    int32_t condition = -1;     // second byte of "jcc rel32"
+    int32_t shift = -1;         // modrm of "shift rax, cl"
+    bool word = false;          // 32 bit operation, result is sign extended
+    int32_t size = 0;           // size of memory access
+    *end_block = false;
+
+    // Semantics follow Machine::Execute
+    switch (instruction->op_type) {
+        case OP_ADD:
+        case OP_SUB:
+        case OP_XOR:
+        case OP_OR:
+        case OP_AND:
+        case OP_MUL:
+        case OP_MULH:
+        case OP_MULHU:
+        case OP_MULHSU:
+        case OP_SLT:
+        case OP_SLTU:
+        case OP_DIV:
+        case OP_REM:
+        case OP_DIVU:
+        case OP_REMU:
+        case OP_DIVW:
+        case OP_DIVUW:
+        case OP_REMW:
+        case OP_REMUW:
+            EmitLoadGuest(HOST_RAX, rs1);
+            EmitLoadGuest(HOST_RCX, rs2);
+            break;
+        case OP_ADDI:
+        case OP_XORI:
+        case OP_ORI:
+        case OP_ANDI:
+        case OP_SLTI:
+        case OP_SLTIU:
+        case OP_ADDIW:
+            EmitLoadGuest(HOST_RAX, rs1);
+            EmitMoveImmediate(HOST_RCX, imm);
+            break;
+        case OP_SLL:
+        case OP_SRL:
+        case OP_SRA:
+            EmitLoadGuest(HOST_RAX, rs1);
+            EmitLoadGuest(HOST_RCX, rs2);
+            break;
+        case OP_SLLI:
+        case OP_SRLI:
+        case OP_SRAI:
+            EmitLoadGuest(HOST_RAX, rs1);
+            EmitMoveImmediate(HOST_RCX, imm & 0b111111);
+            break;
+        case OP_SLLIW:
+        case OP_SRLIW:
+        case OP_SRAIW:
+            EmitLoadGuest(HOST_RAX, rs1);
+            EmitMoveImmediate(HOST_RCX, imm & 0b11111);
+            break;
+        case OP_SLLW:
+        case OP_SRLW:
+        case OP_SRAW:
+        case OP_MULW:
+        case OP_ADDW:
+        case OP_SUBW:
+            EmitLoadGuest(HOST_RAX, rs1);
+            EmitLoadGuest(HOST_RCX, rs2);
+            break;
+        case OP_MV:
+        case OP_LI:
+        case OP_LUI:
+        case OP_AUIPC:
+            break;
+        case OP_LB:
+        case OP_LH:
+        case OP_LW:
+        case OP_LD:
+        case OP_LBU:
+        case OP_LHU:
+        case OP_LWU:
+        case OP_SB:
+        case OP_SH:
+        case OP_SW:
+        case OP_SD:
+            EmitLoadGuest(HOST_RAX, rs1);
+            break;
+        case OP_LWSP:
+        case OP_LDSP:
+        case OP_SWSP:
+        case OP_SDSP:
+            EmitLoadGuest(HOST_RAX, REG_sp);
+            break;
+        case OP_BEQ:
+        case OP_BNE:
+        case OP_BLT:
+        case OP_BGE:
+        case OP_BLTU:
+        case OP_BGEU:
+        case OP_BEQZ:
+        case OP_BNEZ:
+            EmitLoadGuest(HOST_RAX, rs1);
+            if (instruction->op_type == OP_BEQZ || instruction->op_type == OP_BNEZ)
+                EmitLoadGuest(HOST_RCX, REG_zero);
+            else
+                EmitLoadGuest(HOST_RCX, rs2);
+            break;
+        case OP_JAL:
+        case OP_J:
+        case OP_JALR:
+        case OP_JR:
+            break;
+        default:
+            // ECALL, CSR and invalid instructions are left to the interpreter
+            return false;
+    }
+
+    switch (instruction->op_type) {
+        case OP_ADD:
+        case OP_ADDI:
+            alu = 0x01;
+            break;
+        case OP_SUB:
+            alu = 0x29;
+            break;
+        case OP_XOR:
+        case OP_XORI:
+            alu = 0x31;
+            break;
+        case OP_OR:
+        case OP_ORI:
+            alu = 0x09;
+            break;
+        case OP_AND:
+        case OP_ANDI:
+            alu = 0x21;
+            break;
+        case OP_ADDIW:
+        case OP_ADDW:
+            alu = 0x01;
+            word = true;
+            break;
+        case OP_SUBW:
+            alu = 0x29;
+            word = true;
+            break;
+        case OP_SLL:
+        case OP_SLLI:
+            shift = 0xE0;
+            break;
+        case OP_SRL:
+        case OP_SRLI:
+            shift = 0xE8;
+            break;
+        case OP_SRA:
+        case OP_SRAI:
+            shift = 0xF8;
+            break;
+        case OP_BEQ:
+        case OP_BEQZ:
+            condition = 0x84;
+            break;
+        case OP_BNE:
+        case OP_BNEZ:
+            condition = 0x85;
+            break;
+        case OP_BLT:
+            condition = 0x8C;
+            break;
+        case OP_BGE:
+            condition = 0x8D;
+            break;
+        case OP_BLTU:
+            condition = 0x82;
+            break;
+        case OP_BGEU:
+            condition = 0x83;
+            break;
+        case OP_LB:
+        case OP_LBU:
+        case OP_SB:
+            size = 1;
+            break;
+        case OP_LH:
+        case OP_LHU:
+        case OP_SH:
+            size = 2;
+            break;
+        case OP_LW:
+        case OP_LWU:
+        case OP_LWSP:
+        case OP_SW:
+        case OP_SWSP:
+            size = 4;
+            break;
+        case OP_LD:
+        case OP_LDSP:
+        case OP_SD:
+        case OP_SDSP:
+            size = 8;
+            break;
+        default:
+            break;
+    }
+
+    if (alu >= 0) {
+        // op rax, rcx, in 32 bit for word operations
+        if (!word)
+            Emit8(0x48);
+        Emit8(alu);
+        Emit8(0xC8);
+        if (word) {
+            // movsxd rax, eax
+            Emit8(0x48);
+            Emit8(0x63);
+            Emit8(0xC0);
+        }
+        EmitStoreGuest(rd, HOST_RAX);
+        return true;
+    }
+    if (shift >= 0) {
+        // shift rax, cl
+        Emit8(0x48);
+        Emit8(0xD3);
+        Emit8(shift);
+        EmitStoreGuest(rd, HOST_RAX);
+        return true;
+    }
+    if (condition >= 0) {
+        // cmp rax, rcx; jcc taken; fall through exit; taken: exit
+        Emit8(0x48);
+        Emit8(0x39);
+        Emit8(0xC8);
+        Emit8(0x0F);
+        Emit8(condition);
+        uint8_t *site = code_pointer;
+        Emit32(0);
+        EmitExit(pc + length, executed, true);
+        PatchJump(site, code_pointer);
+        EmitExit(pc + imm, executed, true);
+        *end_block = true;
+        return true;
+    }
+    if (size > 0) {
+        // Address in rsi, size in rcx for loads and rdx for stores
+        EmitMoveImmediate(HOST_RCX, imm);
+        Emit8(0x48);
+        Emit8(0x01);
+        Emit8(0xC8);
+        Emit8(0x48);
+        Emit8(0x89);
+        Emit8(0xC6);
+        switch (instruction->op_type) {
+            case OP_SB:
+            case OP_SH:
+            case OP_SW:
+            case OP_SD:
+            case OP_SWSP:
+            case OP_SDSP:
+                EmitLoadGuest(HOST_RDX, rs2);
+                EmitMoveImmediate(HOST_RCX, size);
+                EmitCallHelper((void *) JITStore);
+                EmitFlushCheck(pc + length, executed);
+                break;
+            default:
+                EmitMoveImmediate(HOST_RDX, size);
+                if (instruction->op_type == OP_LBU || instruction->op_type == OP_LHU ||
+                    instruction->op_type == OP_LWU)
+                    EmitCallHelper((void *) JITLoadUnsigned);
+                else
+                    EmitCallHelper((void *) JITLoad);
+                EmitStoreGuest(rd, HOST_RAX);
+                break;
+        }
+        return true;
+    }
+
+    switch (instruction->op_type) {
+        case OP_MUL:
+            // imul rax, rcx
+            Emit8(0x48);
+            Emit8(0x0F);
+            Emit8(0xAF);
+            Emit8(0xC1);
+            break;
+        case OP_MULW:
+            // imul eax, ecx; movsxd rax, eax
+            Emit8(0x0F);
+            Emit8(0xAF);
+            Emit8(0xC1);
+            Emit8(0x48);
+            Emit8(0x63);
+            Emit8(0xC0);
+            break;
+        case OP_MULH:
+        case OP_MULHU:
+            // imul rcx or mul rcx, high half of the product is in rdx; mov rax, rdx
+            Emit8(0x48);
+            Emit8(0xF7);
+            Emit8(instruction->op_type == OP_MULH ? 0xE9 : 0xE1);
+            Emit8(0x48);
+            Emit8(0x89);
+            Emit8(0xD0);
+            break;
+        case OP_MULHSU:
+        case OP_DIV:
+        case OP_REM:
+        case OP_DIVU:
+        case OP_REMU:
+        case OP_DIVW:
+        case OP_DIVUW:
+        case OP_REMW:
+        case OP_REMUW:
+            // mov rdi, rax; mov rsi, rcx; op type in rdx
+            Emit8(0x48);
+            Emit8(0x89);
+            Emit8(0xC7);
+            Emit8(0x48);
+            Emit8(0x89);
+            Emit8(0xCE);
+            EmitMoveImmediate(HOST_RDX, instruction->op_type);
+            this->EmitCall((void *) JITArithmetic);
+            break;
+        case OP_SLT:
+        case OP_SLTI:
+        case OP_SLTU:
+        case OP_SLTIU:
+            // cmp rax, rcx; setl al or setb al; movzx eax, al
+            Emit8(0x48);
+            Emit8(0x39);
+            Emit8(0xC8);
+            Emit8(0x0F);
+            Emit8(instruction->op_type == OP_SLT || instruction->op_type == OP_SLTI ? 0x9C : 0x92);
+            Emit8(0xC0);
+            Emit8(0x0F);
+            Emit8(0xB6);
+            Emit8(0xC0);
+            break;
+        case OP_SLLIW:
+        case OP_SLLW:
+            // shl eax, cl; movsxd rax, eax
+            Emit8(0xD3);
+            Emit8(0xE0);
+            Emit8(0x48);
+            Emit8(0x63);
+            Emit8(0xC0);
+            break;
+        case OP_SRLIW:
+        case OP_SRLW:
+            // shr eax, cl; movsxd rax, eax
+            Emit8(0xD3);
+            Emit8(0xE8);
+            Emit8(0x48);
+            Emit8(0x63);
+            Emit8(0xC0);
+            break;
+        case OP_SRAIW:
+        case OP_SRAW:
+            // sar eax, cl; movsxd rax, eax
+            Emit8(0xD3);
+            Emit8(0xF8);
+            Emit8(0x48);
+            Emit8(0x63);
+            Emit8(0xC0);
+            break;
+        case OP_MV:
+            EmitLoadGuest(HOST_RAX, rs2);
+            break;
+        case OP_LI:
+        case OP_LUI:
+            EmitMoveImmediate(HOST_RAX, imm);
+            break;
+        case OP_AUIPC:
+            EmitMoveImmediate(HOST_RAX, pc + imm);
+            break;
+        case OP_JAL:
+            EmitMoveImmediate(HOST_RAX, pc + 4);
+            EmitStoreGuest(rd, HOST_RAX);
+            EmitExit(pc + imm, executed, true);
+            *end_block = true;
+            return true;
+        case OP_J:
+            EmitExit(pc + imm, executed, true);
+            *end_block = true;
+            return true;
+        case OP_JALR:
+        case OP_JR:
+            // Target is computed before link register is written, rcx survives the exit code
+            EmitLoadGuest(HOST_RCX, rs1);
+            if (instruction->op_type == OP_JALR && instruction->instr_type != INSTR_CR) {
+                EmitMoveImmediate(HOST_RAX, imm);
+                Emit8(0x48);
+                Emit8(0x01);
+                Emit8(0xC1);
+                // and rcx, -2
+                Emit8(0x48);
+                Emit8(0x83);
+                Emit8(0xE1);
+                Emit8(0xFE);
+            }
+            if (instruction->op_type == OP_JALR) {
+                EmitMoveImmediate(HOST_RAX, pc + (instruction->instr_type == INSTR_CR ? 2 : 4));
+                EmitStoreGuest(rd, HOST_RAX);
+            }
+            // add qword [rbp + executed], imm32; mov rax, rcx; jmp exit_routine
+            Emit8(0x48);
+            Emit8(0x81);
+            Emit8(0x45);
+            Emit8(offsetof(JITContext, executed));
+            Emit32(executed);
+            Emit8(0x48);
+            Emit8(0x89);
+            Emit8(0xC8);
+            Emit8(0xE9);
+            Emit32(0);
+            PatchJump(code_pointer - sizeof(int32_t), exit_routine);
+            *end_block = true;
+            return true;
+        default: FATAL("Invalid op type %d in JIT\n", instruction->op_type);
+    }
+    EmitStoreGuest(rd, HOST_RAX);
+    return true;
+}
+
+bool JIT::Translate(int64_t pc, DecodedInstruction *entry) {
+    if (code_buffer + JIT_CODE_BUFFER_SIZE - code_pointer < JIT_MAX_BLOCK_SIZE) {
+        // Code buffer is full, start again
+        this->Flush();
+    }
+
+    uint8_t *block = code_pointer;
+    int64_t block_pc = pc;
+    int32_t executed = 0;
+    bool end_block = false;
+    while (!end_block && executed < JIT_MAX_BLOCK_INSTRUCTIONS) {
+        Instruction instruction;
+        int64_t length;
+        if (!this->DecodeAt(pc, &instruction, &length))
+            break;
+        if (!this->TranslateInstruction(&instruction, length, executed + 1, &end_block))
+            break;
+        this->AddCodePage(pc);
+        this->AddCodePage(pc + length - 1);
+        executed++;
+        if (!end_block)
+            pc += length;
+    }
+
+    if (executed == 0) {
+        // First instruction is left to the interpreter, never try again
+        code_pointer = block;
+        entry->heat = -1;
+        return false;
+    }
+    if (!end_block)
+        EmitExit(pc, executed, true);
+
+    entry->native = block;
+    blocks[block_pc] = block;
+    // Chain exits waiting for this block
+    std::multimap<int64_t, uint8_t *>::iterator it = pending_exits.lower_bound(block_pc);
+    while (it != pending_exits.end() && it->first == block_pc) {
+        PatchJump(it->second, block);
+        pending_exits.erase(it++);
+    }
+    return true;
+}
+
+int64_t JIT::Run(int64_t *registers, void *block) {
+    return ((JITEntry) trampoline)(registers, &context, block);
+}
+
+int64_t JIT::TakeExecuted() {
+    int64_t executed = context.executed;
+    context.executed = 0;
+    return executed;
+}
+
+void JIT::Flush() {
+    code_pointer = exit_routine + 5;
+    blocks.clear();
+    pending_exits.clear();
+    code_pages.clear();
+    low_address = 0;
+    high_address = 0;
+    context.flush = false;
+    context.decode_cache->ClearNative();
+}
@@ -0,0 +1,133 @@
+//
+// Name: jit
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_JIT_H
+#define RISC_V_SIMULATOR_JIT_H
+
+#include "utility.h"
+#include "instruction.h"
+#include "mem.h"
+#include "interpreter.h"
+#include <map>
+#include <set>
+
+// A block is translated after it is entered this many times by the interpreter
+#define JIT_HOT_THRESHOLD 16
+#define JIT_MAX_BLOCK_INSTRUCTIONS 64
+// Native code of one block never exceeds this size
+#define JIT_MAX_BLOCK_SIZE (JIT_MAX_BLOCK_INSTRUCTIONS * 128)
+#define JIT_CODE_BUFFER_SIZE (32 << 20)
+
+// Host registers used by generated code
+#define HOST_RAX 0
+#define HOST_RCX 1
+#define HOST_RDX 2
+#define HOST_RBX 3
+#define HOST_RBP 5
+#define HOST_RSI 6
+#define HOST_RDI 7
+
+class JIT;
+
+// State shared by generated code and its helpers, pointed to by rbp in generated code
+typedef struct JITContext_ {
+    int64_t executed;               // guest instructions executed in generated code
+    int8_t flush;                   // translated code is written, all blocks must be discarded
+    Memory *memory;
+    DecodeCache *decode_cache;
+    JIT *jit;
+} JITContext;
+
+// Translates hot guest basic blocks of RV64IMC into x86-64 code
+class JIT {
+private:
+    uint8_t *code_buffer;                           // executable buffer of generated code
+    uint8_t *code_pointer;                          // next free byte in code buffer
+    uint8_t *exit_routine;                          // restores host registers and returns next pc in rax
+    uint8_t *trampoline;                            // entry of generated code, see JITEntry
+    std::map<int64_t, uint8_t *> blocks;            // translated blocks indexed by guest pc
+    std::multimap<int64_t, uint8_t *> pending_exits;    // jumps to exit routine which can chain to a block
+    std::set<int64_t> code_pages;                   // start addresses of pages which contain translated code
+    int64_t low_address;                            // all code pages are in [low_address, high_address)
+    int64_t high_address;
+    JITContext context;
+
+    // Emit bytes to code buffer
+    void Emit8(int32_t value);
+
+    void Emit32(int32_t value);
+
+    void Emit64(int64_t value);
+
+    // Load guest register into host register
+    void EmitLoadGuest(int32_t host, int32_t guest);
+
+    // Store host register into guest register, writes to zero register are dropped
+    void EmitStoreGuest(int32_t guest, int32_t host);
+
+    // Move immediate into host register
+    void EmitMoveImmediate(int32_t host, int64_t imm);
+
+    // Call a helper function, arguments should be in rsi, rdx and rcx
+    void EmitCallHelper(void *helper);
+
+    // Call a function which takes no context, arguments should be in rdi, rsi and rdx
+    void EmitCall(void *function);
+
+    // Leave the block to guest target pc, count executed instructions of the block
+    // Exit jumps to the target block if it is translated when chain is true
+    void EmitExit(int64_t target, int32_t executed, bool chain);
+
+    // Leave the block if a store has written translated code
+    void EmitFlushCheck(int64_t next_pc, int32_t executed);
+
+    // Translate one instruction, return false if it is not supported
+    // Control transfer instructions end the block and set end_block
+    bool TranslateInstruction(Instruction *instruction, int64_t length, int32_t executed, bool *end_block);
+
+    // Read and decode instruction at pc, return false if it can not be decoded
+    bool DecodeAt(int64_t pc, Instruction *instruction, int64_t *length);
+
+    // Patch a rel32 jump to a new target
+    void PatchJump(uint8_t *site, uint8_t *target);
+
+    // Record page of address as containing translated code
+    void AddCodePage(int64_t address);
+
+public:
+    JIT(Memory *memory, DecodeCache *decode_cache);
+
+    ~JIT();
+
+    // Translate the block which starts at pc and attach it to the decoded slot, return false if not translatable
+    bool Translate(int64_t pc, DecodedInstruction *entry);
+
+    // Run generated code from given block until it exits, return the next guest pc
+    int64_t Run(int64_t *registers, void *block);
+
+    // Take the number of guest instructions executed in generated code since last call
+    int64_t TakeExecuted();
+
+    // Guest memory [address, address + size) is written, translated code in it must be discarded
+    inline void CodeWritten(int64_t address, int32_t size) {
+        if (address + size <= low_address || address >= high_address)
+            return;
+        if (code_pages.count(address & ~((int64_t) PageSize - 1)) ||
+            code_pages.count((address + size - 1) & ~((int64_t) PageSize - 1)))
+            context.flush = true;
+    }
+
+    // Has translated code been written?
+    inline bool NeedFlush() {
+        return context.flush;
+    }
+
+    // Discard all translated blocks
+    void Flush();
+};
+
+#endif //RISC_V_SIMULATOR_JIT_H
@@ -84,10 +84,45 @@ void *mem_alloc(long size) {
     return address;
 }
 
+void mem_free(void *address) {
+    asm("mv a0, %0\n\t": : "r"(address):"a0");
+    asm("addi a7, zero, 16\n\t");
+    asm("ecall\n\t");
+}
+
 long time() {
     long time;
     asm("addi a7, zero, 12\n\t");
     asm("ecall\n\t");
     asm("mv %0, a7\n\t":"=r"(time)::);
     return time;
-}
\ No newline at end of file
+}
+
+void *mem_copy(void *dest, const void *src, long size) {
+    asm("mv a0, %0\n\tmv a1, %1\n\tmv a2, %2\n\t": : "r"(dest), "r"(src), "r"(size):"a0", "a1", "a2");
+    asm("addi a7, zero, 13\n\t");
+    asm("ecall\n\t");
+    return dest;
+}
+
+void *mem_set(void *dest, int value, long size) {
+    asm("mv a0, %0\n\tmv a1, %1\n\tmv a2, %2\n\t": : "r"(dest), "r"(value), "r"(size):"a0", "a1", "a2");
+    asm("addi a7, zero, 14\n\t");
+    asm("ecall\n\t");
+    return dest;
+}
+
+void *mem_move(void *dest, const void *src, long size) {
+    asm("mv a0, %0\n\tmv a1, %1\n\tmv a2, %2\n\t": : "r"(dest), "r"(src), "r"(size):"a0", "a1", "a2");
+    asm("addi a7, zero, 15\n\t");
+    asm("ecall\n\t");
+    return dest;
+}
+
+long cycle_count() {
+    return read_csr(cycle);
+}
+
+long instret_count() {
+    return read_csr(instret);
+}
@@ -21,8 +21,30 @@
 #define RISCV_SYSCALL_RAND 10
 #define RISCV_SYSCALL_MALLOC 11
 #define RISCV_SYSCALL_TIME 12
+#define RISCV_SYSCALL_MEMCPY 13
+#define RISCV_SYSCALL_MEMSET 14
+#define RISCV_SYSCALL_MEMMOVE 15
+#define RISCV_SYSCALL_FREE 16
+
+// Events which can be selected by writing mhpmevent3-31 CSRs
+#define HPM_EVENT_NONE 0
+#define HPM_EVENT_STALL_CTRL 1
+#define HPM_EVENT_STALL_DATA 2
+#define HPM_EVENT_STALL_MEMORY 3
+#define HPM_EVENT_L1_ACCESS 4
+#define HPM_EVENT_L1_MISS 5
+#define HPM_EVENT_L2_ACCESS 6
+#define HPM_EVENT_L2_MISS 7
+#define HPM_EVENT_L3_ACCESS 8
+#define HPM_EVENT_L3_MISS 9
+#define HPM_EVENT_MEMORY_ACCESS 10
+
+// Access CSR by name, e.g. read_csr(hpmcounter3), write_csr(mhpmevent3, HPM_EVENT_L1_MISS)
+#define read_csr(csr) ({ long __value; asm volatile("csrr %0, " #csr : "=r"(__value)); __value; })
+#define write_csr(csr, value) asm volatile("csrw " #csr ", %0" : : "r"((long) (value)))
 
 #define malloc mem_alloc
+#define free mem_free
 #define rand rand_int
 #define srand set_rand_seed
 
@@ -50,6 +72,19 @@ int rand_int();
 
 void *mem_alloc(long size);
 
+void mem_free(void *address);
+
 long time();
 
+// Copy, set and move memory on the simulator host, each is one system call instead of a loop of instructions
+void *mem_copy(void *dest, const void *src, long size);
+
+void *mem_set(void *dest, int value, long size);
+
+void *mem_move(void *dest, const void *src, long size);
+
+long cycle_count();
+
+long instret_count();
+
 #endif //LIB_H
@@ -8,19 +8,33 @@
 #include "machine.h"
 #include <cstring>
 #include <elf.h>
-#include "stats.h"
+#include <unistd.h>
 #include "config.h"
+#include "trace.h"
 
-extern Stats *stats;
 extern char reg_strings[32][8];
 
+thread_local bool debug_enabled;
+
 Instruction *Machine::FetchInstruction() {
     Instruction *instruction = new Instruction();
     int64_t instruction_value;
-    this->ReadMemory(this->reg_pc, sizeof(int32_t), &instruction_value);
+    int64_t fetch_cycle = stats->GetCycles();
+    this->access_pc = reg_pc;
+    if (!main_memory->ReadMemory(this->reg_pc, sizeof(int32_t), &instruction_value)) {
+        FATAL("Unable to fetch instruction at %lx", reg_pc);
+    }
+    this->AccessCache(this->reg_pc, sizeof(int32_t), 1, true);
     instruction->binary_code = (int32_t) instruction_value;
     instruction->instr_pc = reg_pc;
     instruction->decoded = false;
+    instruction->trace_id = -1;
+    if (image_cache != NULL)
+        image_cache->Lookup(instruction->instr_pc, instruction);
+    if (pipeline_tracer != NULL) {
+        pipeline_tracer->Fetch(instruction, fetch_cycle);
+        pipeline_tracer->Stall(instruction, "Fetch", stats->GetCycles() - fetch_cycle, fetch_cycle);
+    }
     if (Decode_imm(instruction->binary_code, 0, 2, 0) == 0x3)
         this->reg_pc += 4;
     else
@@ -38,40 +52,52 @@ void Machine::Execute(Instruction *instruction) {
 
     bool jump = false;
     if (instruction != NULL) {
+        if (pipeline_tracer != NULL)
+            pipeline_tracer->Stage(instruction, TRACE_STAGE_EXECUTE, stats->GetCycles());
         stats->IncreaseInstruction();
+        if (profiler != NULL)
+            profiler->IncreaseInstruction(instruction->instr_pc);
+        if (hooks != NULL && hooks->instruction != NULL && hooks->instruction(hooks->instruction_data, instruction))
+            stop_requested = true;
         int32_t imm = instruction->imm;
         int64_t value_rs1 = registers[instruction->rs1],
                 value_rs2 = registers[instruction->rs2],
                 value_rd = registers[instruction->rd],
                 value_sp = registers[REG_sp],
-                value_a7 = registers[REG_a7],
-                value_a0 = registers[REG_a0];
+                value_a7 = registers[REG_a7];
+        int64_t value_args[NUM_OF_SYSCALL_ARGS];
+        for (int i = 0; i < NUM_OF_SYSCALL_ARGS; i++)
+            value_args[i] = registers[REG_a0 + i];
 
-        if (regs_instr[REG_INSTR_WRITE_BACK] != NULL && regs_instr[REG_INSTR_WRITE_BACK]->write_reg) {
+        if (regs_instr[REG_INSTR_WRITE_BACK] != NULL && regs_instr[REG_INSTR_WRITE_BACK]->write_reg &&
+            regs_instr[REG_INSTR_WRITE_BACK]->rd != REG_zero) {
+            // Value written to zero register is discarded, so it is never forwarded
             // Data hazard may happen, new value should be used
             if (regs_instr[REG_INSTR_WRITE_BACK]->rd == instruction->rs1) {
                 value_rs1 = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
-                DEBUG("Use forwarded value from AccMem: %s = %16.16lx\n", reg_strings[instruction->rs1], value_rs1);
+                TRACE(PIPELINE_FORWARD, instruction->rs1, value_rs1);
             }
             if (regs_instr[REG_INSTR_WRITE_BACK]->rd == instruction->rs2) {
                 value_rs2 = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
-                DEBUG("Use forwarded value from AccMem: %s = %16.16lx\n", reg_strings[instruction->rs2], value_rs2);
+                TRACE(PIPELINE_FORWARD, instruction->rs2, value_rs2);
             }
             if (regs_instr[REG_INSTR_WRITE_BACK]->rd == instruction->rd) {
                 value_rd = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
-                DEBUG("Use forwarded value from AccMem: %s = %16.16lx\n", reg_strings[instruction->rd], value_rd);
+                TRACE(PIPELINE_FORWARD, instruction->rd, value_rd);
             }
             if (regs_instr[REG_INSTR_WRITE_BACK]->rd == REG_sp) {
                 value_sp = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
-                DEBUG("Use forwarded value from AccMem: %s = %16.16lx\n", reg_strings[REG_sp], value_sp);
+                TRACE(PIPELINE_FORWARD, REG_sp, value_sp);
             }
             if (regs_instr[REG_INSTR_WRITE_BACK]->rd == REG_a7) {
                 value_a7 = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
-                DEBUG("Use forwarded value from AccMem: %s = %16.16lx\n", reg_strings[REG_a7], value_a7);
+                TRACE(PIPELINE_FORWARD, REG_a7, value_a7);
             }
-            if (regs_instr[REG_INSTR_WRITE_BACK]->rd == REG_a0) {
-                value_a0 = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
-                DEBUG("Use forwarded value from AccMem: %s = %16.16lx\n", reg_strings[REG_a0], value_a0);
+            if (regs_instr[REG_INSTR_WRITE_BACK]->rd >= REG_a0 &&
+                regs_instr[REG_INSTR_WRITE_BACK]->rd < REG_a0 + NUM_OF_SYSCALL_ARGS) {
+                int32_t arg = regs_instr[REG_INSTR_WRITE_BACK]->rd - REG_a0;
+                value_args[arg] = regs_instr[REG_INSTR_WRITE_BACK]->write_back_value;
+                TRACE(PIPELINE_FORWARD, REG_a0 + arg, value_args[arg]);
             }
 
             // Load-use hazard?
@@ -84,8 +110,15 @@ void Machine::Execute(Instruction *instruction) {
                 case OP_LDSP:
                 case OP_LBU:
                 case OP_LHU:
+                case OP_LWU:
                     stats->IncreaseCycle();
                     stats->IncreaseStallByData();
+                    if (profiler != NULL) {
+                        profiler->AddCycles(instruction->instr_pc, 1);
+                        profiler->IncreaseStallByData(instruction->instr_pc);
+                    }
+                    if (pipeline_tracer != NULL)
+                        pipeline_tracer->Stall(instruction, "Load-use", 1, stats->GetCycles() - 1);
                     break;
                 default:
                     break;
@@ -105,6 +138,9 @@ void Machine::Execute(Instruction *instruction) {
             case OP_SLL:
                 instruction->write_back_value = value_rs1 << (value_rs2 & 0b111111);
                 break;
+            case OP_MULH:
+                instruction->write_back_value = RiscvMulH(value_rs1, value_rs2);
+                break;
             case OP_SLT:
                 instruction->write_back_value = value_rs1 < value_rs2 ? 1 : 0;
                 break;
@@ -112,19 +148,19 @@ void Machine::Execute(Instruction *instruction) {
                 instruction->write_back_value = value_rs1 ^ value_rs2;
                 break;
             case OP_DIV:
-                instruction->write_back_value = value_rs1 / value_rs2;
+                instruction->write_back_value = RiscvDiv(value_rs1, value_rs2);
                 break;
             case OP_SRL:
-                instruction->write_back_value = ((uint64_t) value_rs1) << (value_rs2 & 0b111111);
+                instruction->write_back_value = ((uint64_t) value_rs1) >> (value_rs2 & 0b111111);
                 break;
             case OP_SRA:
-                instruction->write_back_value = ((int64_t) value_rs1) << (value_rs2 & 0b111111);
+                instruction->write_back_value = ((int64_t) value_rs1) >> (value_rs2 & 0b111111);
                 break;
             case OP_OR:
                 instruction->write_back_value = value_rs1 | value_rs2;
                 break;
             case OP_REM:
-                instruction->write_back_value = value_rs1 % value_rs2;
+                instruction->write_back_value = RiscvRem(value_rs1, value_rs2);
                 break;
             case OP_AND:
                 instruction->write_back_value = value_rs1 & value_rs2;
@@ -142,10 +178,7 @@ void Machine::Execute(Instruction *instruction) {
                 instruction->write_back_value = value_rs1 + imm;
                 break;
             case OP_ADDI:
-                if (instruction->instr_type == INSTR_CIW) // ADDI4SPN
-                    instruction->write_back_value = (value_sp << 1) + imm;
-                else
-                    instruction->write_back_value = value_rs1 + imm;
+                instruction->write_back_value = value_rs1 + imm;
                 break;
             case OP_SLLI:
                 instruction->write_back_value = value_rs1 << (imm & 0b111111);
@@ -183,7 +216,7 @@ void Machine::Execute(Instruction *instruction) {
                 }
                 break;
             case OP_ECALL:
-                this->HandleSystemCall(instruction, value_a7, value_a0);
+                this->HandleSystemCall(instruction, value_a7, value_args);
                 break;
             case OP_SB:
                 instruction->write_back_value = value_rs1 + imm;
@@ -236,10 +269,10 @@ void Machine::Execute(Instruction *instruction) {
                 instruction->write_back_value = imm;
                 break;
             case OP_SUBW:
-                instruction->write_back_value = (int64_t) ((int32_t) (value_rd - value_rs2));
+                instruction->write_back_value = (int64_t) ((int32_t) (value_rs1 - value_rs2));
                 break;
             case OP_ADDW:
-                instruction->write_back_value = (int64_t) ((int32_t) (value_rd + value_rs2));
+                instruction->write_back_value = (int64_t) ((int32_t) (value_rs1 + value_rs2));
                 break;
             case OP_J:
                 reg_pc = instruction->instr_pc + imm;
@@ -292,7 +325,7 @@ void Machine::Execute(Instruction *instruction) {
                 instruction->write_back_value = (int64_t) (((int32_t) value_rs1) << (imm & 0b11111));
                 break;
             case OP_SRLIW:
-                instruction->write_back_value = (int64_t) (((uint32_t) value_rs1) >> (imm & 0b11111));
+                instruction->write_back_value = (int64_t) (int32_t) (((uint32_t) value_rs1) >> (imm & 0b11111));
                 break;
             case OP_SRAIW:
                 instruction->write_back_value = (int64_t) (((int32_t) value_rs1) >> (imm & 0b11111));
@@ -301,7 +334,7 @@ void Machine::Execute(Instruction *instruction) {
                 instruction->write_back_value = (int64_t) (((int32_t) value_rs1) << (value_rs2 & 0b11111));
                 break;
             case OP_SRLW:
-                instruction->write_back_value = (int64_t) (((uint32_t) value_rs1) >> (value_rs2 & 0b11111));
+                instruction->write_back_value = (int64_t) (int32_t) (((uint32_t) value_rs1) >> (value_rs2 & 0b11111));
                 break;
             case OP_SRAW:
                 instruction->write_back_value = (int64_t) (((int32_t) value_rs1) >> (value_rs2 & 0b11111));
@@ -315,6 +348,47 @@ void Machine::Execute(Instruction *instruction) {
             case OP_MULW:
                 instruction->write_back_value = (int64_t) ((int32_t) value_rs1 * (int32_t) value_rs2);
                 break;
+            case OP_CSRRW:
+            case OP_CSRRS:
+            case OP_CSRRC:
+            case OP_CSRRWI:
+            case OP_CSRRSI:
+            case OP_CSRRCI:
+                instruction->write_back_value = this->ExecuteCSR(instruction, value_rs1);
+                break;
+            case OP_SLTU:
+                instruction->write_back_value = (uint64_t) value_rs1 < (uint64_t) value_rs2 ? 1 : 0;
+                break;
+            case OP_SLTIU:
+                instruction->write_back_value = (uint64_t) value_rs1 < (uint64_t) (int64_t) imm ? 1 : 0;
+                break;
+            case OP_MULHSU:
+                instruction->write_back_value = RiscvMulHSU(value_rs1, value_rs2);
+                break;
+            case OP_MULHU:
+                instruction->write_back_value = RiscvMulHU(value_rs1, value_rs2);
+                break;
+            case OP_DIVU:
+                instruction->write_back_value = RiscvDivU(value_rs1, value_rs2);
+                break;
+            case OP_REMU:
+                instruction->write_back_value = RiscvRemU(value_rs1, value_rs2);
+                break;
+            case OP_DIVW:
+                instruction->write_back_value = RiscvDivW(value_rs1, value_rs2);
+                break;
+            case OP_DIVUW:
+                instruction->write_back_value = RiscvDivUW(value_rs1, value_rs2);
+                break;
+            case OP_REMW:
+                instruction->write_back_value = RiscvRemW(value_rs1, value_rs2);
+                break;
+            case OP_REMUW:
+                instruction->write_back_value = RiscvRemUW(value_rs1, value_rs2);
+                break;
+            case OP_LWU:
+                instruction->write_back_value = value_rs1 + imm;
+                break;
             default: FATAL("Invalid op type %d\n", instruction->op_type);
         }
     }
@@ -322,11 +396,18 @@ void Machine::Execute(Instruction *instruction) {
     // Move instruction of last pipeline step here
     if (jump) {
         if (regs_instr[REG_INSTR_DECODE] != NULL) {
+            if (pipeline_tracer != NULL)
+                pipeline_tracer->Flush(regs_instr[REG_INSTR_DECODE], stats->GetCycles());
             delete regs_instr[REG_INSTR_DECODE];
             regs_instr[REG_INSTR_DECODE] = NULL;
         }
         regs_instr[REG_INSTR_EXECUTE] = NULL;
         stats->IncreaseStallByCtrl();
+        bubble_pc = instruction->instr_pc;
+        if (profiler != NULL)
+            profiler->IncreaseStallByCtrl(instruction->instr_pc);
+        if (call_stack_sampler != NULL)
+            this->TrackCallStack(instruction);
     } else
         regs_instr[REG_INSTR_EXECUTE] = regs_instr[REG_INSTR_DECODE];
 }
@@ -335,6 +416,10 @@ void Machine::AccessMemory(Instruction *instruction) {
     // When this step is going to execute, WriteBack step of i-1 instruction has already done
     // So there won't be any hazard. It's okay to directly load value from registers
     if (instruction != NULL) {
+        int64_t access_cycle = stats->GetCycles();
+        if (pipeline_tracer != NULL)
+            pipeline_tracer->Stage(instruction, TRACE_STAGE_ACCESS_MEM, access_cycle);
+        this->access_pc = instruction->instr_pc;
         switch (instruction->op_type) {
             case OP_LB:
                 this->ReadMemory(instruction->write_back_value, 1, &instruction->write_back_value);
@@ -358,6 +443,10 @@ void Machine::AccessMemory(Instruction *instruction) {
                 this->ReadMemory(instruction->write_back_value, 2, &instruction->write_back_value);
                 instruction->write_back_value = (int64_t) ((uint16_t) instruction->write_back_value);
                 break;
+            case OP_LWU:
+                this->ReadMemory(instruction->write_back_value, 4, &instruction->write_back_value);
+                instruction->write_back_value = (int64_t) ((uint32_t) instruction->write_back_value);
+                break;
             case OP_SB:
                 this->WriteMemory(instruction->write_back_value, 1, registers[instruction->rs2]);
                 break;
@@ -375,6 +464,8 @@ void Machine::AccessMemory(Instruction *instruction) {
             default:
                 break;
         }
+        if (pipeline_tracer != NULL)
+            pipeline_tracer->Stall(instruction, "Memory", stats->GetCycles() - access_cycle, access_cycle);
     }
 
     // Move instruction of last pipeline step here
@@ -383,8 +474,13 @@ void Machine::AccessMemory(Instruction *instruction) {
 
 void Machine::WriteBack(Instruction *instruction) {
     if (instruction != NULL) {
-        if (instruction->write_reg)
+        // Execute runs later in the same cycle and must still read zero from x0
+        if (instruction->write_reg && instruction->rd != REG_zero)
             registers[instruction->rd] = instruction->write_back_value;
+        if (pipeline_tracer != NULL) {
+            pipeline_tracer->Stage(instruction, TRACE_STAGE_WRITE_BACK, stats->GetCycles());
+            pipeline_tracer->Retire(instruction);
+        }
     }
 
     // Delete current instruction and move instruction of last pipeline step here
@@ -393,8 +489,34 @@ void Machine::WriteBack(Instruction *instruction) {
     regs_instr[REG_INSTR_WRITE_BACK] = regs_instr[REG_INSTR_ACCESS_MEM];
 }
 
+void Machine::TrackCallStack(Instruction *instruction) {
+    switch (instruction->op_type) {
+        case OP_JAL:
+        case OP_JALR:
+            if (instruction->rd == REG_ra)
+                call_stack_sampler->Call(reg_pc);
+            else if (instruction->rd == REG_zero && instruction->rs1 == REG_ra)
+                call_stack_sampler->Return();
+            break;
+        case OP_JR:
+            if (instruction->rs1 == REG_ra)
+                call_stack_sampler->Return();
+            break;
+        default:
+            break;
+    }
+}
+
 void Machine::SetHeapPointer(int64_t address) {
-    this->heap_pointer = address;
+    heap->SetStart(address);
+}
+
+int64_t Machine::SetBreak(int64_t address) {
+    int64_t old_break = heap->Break();
+    int64_t new_break = heap->SetBreak(address);
+    if (new_break < old_break)
+        this->HostWritten(new_break, old_break - new_break);
+    return new_break;
 }
 
 Machine::Machine() {
@@ -402,6 +524,38 @@ Machine::Machine() {
     memset(this->registers, 0, sizeof(this->registers));
     for (int i = 0; i < SIZE_REG_INSTR; i++)
         this->regs_instr[i] = NULL;
+    this->exit_flag = false;
+    this->exit_code = 0;
+    this->exit_message = true;
+    this->stats = new Stats();
+    this->total_access_time = 0;
+    this->symbol_table = new SymbolTable();
+    this->profiler = NULL;
+    this->access_pc = 0;
+    this->bubble_pc = 0;
+    this->call_stack_sampler = NULL;
+    memset(this->hpm_events, 0, sizeof(this->hpm_events));
+    memset(this->counter_offsets, 0, sizeof(this->counter_offsets));
+    this->interval_sampler = NULL;
+    this->pipeline_tracer = NULL;
+    this->access_trace = NULL;
+    this->cpi_estimator = NULL;
+    this->decode_cache = NULL;
+    this->jit = NULL;
+    memset(this->fusion_sites, 0, sizeof(this->fusion_sites));
+    this->console = new ConsoleBuffer(STDOUT_FILENO, DEFAULT_CONSOLE_BUFFER_SIZE, CONSOLE_FLUSH_FULL);
+    memset(this->fusion_counts, 0, sizeof(this->fusion_counts));
+    this->accel_cache = false;
+    this->sandbox = new FileSandbox();
+    this->image_cache = NULL;
+    this->heap = new HeapAllocator(this->main_memory);
+    this->input = stdin;
+    this->hooks = NULL;
+    this->stop_requested = false;
+    this->syscall_log = NULL;
+    this->clock_frequency = 0;
+    memset(&this->random_data, 0, sizeof(this->random_data));
+    initstate_r(1, this->random_state, RANDOM_STATE_SIZE, &this->random_data);
 
     // Build cache hierarchy
     memory = new MemoryForCache();
@@ -430,13 +584,47 @@ Machine::Machine() {
 
 Machine::~Machine() {
     delete main_memory;
-    for (int i = 0; i < SIZE_REG_INSTR; i++)
-        if (this->regs_instr[i] != NULL)
+    // A stage register may still share its instruction with the next stage when the machine exits
+    for (int i = 0; i < SIZE_REG_INSTR; i++) {
+        if (this->regs_instr[i] == NULL)
+            continue;
+        bool shared = false;
+        for (int j = 0; j < i; j++)
+            shared = shared || regs_instr[j] == regs_instr[i];
+        if (!shared)
             delete regs_instr[i];
+    }
     delete memory;
     delete l1;
     delete l2;
     delete l3;
+    delete symbol_table;
+    if (profiler != NULL)
+        delete profiler;
+    if (call_stack_sampler != NULL)
+        delete call_stack_sampler;
+    if (interval_sampler != NULL)
+        delete interval_sampler;
+    if (pipeline_tracer != NULL)
+        delete pipeline_tracer;
+    if (access_trace != NULL)
+        delete access_trace;
+    if (cpi_estimator != NULL)
+        delete cpi_estimator;
+    if (jit != NULL)
+        delete jit;
+    if (decode_cache != NULL)
+        delete decode_cache;
+    delete console;
+    delete sandbox;
+    delete heap;
+    if (image_cache != NULL)
+        delete image_cache;
+    if (input != stdin)
+        fclose(input);
+    if (syscall_log != NULL)
+        delete syscall_log;
+    delete stats;
 }
 
 void Machine::PrintRegisters() {
@@ -476,8 +664,9 @@ void Machine::PrintPipeLineInstructions() {
 }
 
 void Machine::DumpState() {
+    console->Flush();
     printf("PC: %16.16lx\n", this->reg_pc);
-    printf("HeapPointer: %16.16lx\n", this->heap_pointer);
+    printf("HeapPointer: %16.16lx\n", heap->Break());
     this->PrintRegisters();
     stats->PrintStats();
 }
@@ -485,6 +674,22 @@ void Machine::DumpState() {
 void Machine::OneCycle() {
     ASSERT(!this->exit_flag);
     stats->IncreaseCycle();
+    if (profiler != NULL) {
+        // A cycle belongs to the instruction in Execute stage, or the jump which makes the bubble
+        if (regs_instr[REG_INSTR_EXECUTE] != NULL)
+            profiler->AddCycles(regs_instr[REG_INSTR_EXECUTE]->instr_pc, 1);
+        else
+            profiler->AddCycles(bubble_pc, 1);
+    }
+    if (call_stack_sampler != NULL)
+        call_stack_sampler->Sample(stats->GetCycles());
+    if (pipeline_tracer != NULL)
+        pipeline_tracer->BeginCycle(stats->GetCycles());
+    if (interval_sampler != NULL && interval_sampler->Due(stats->GetCycles())) {
+        IntervalSnapshot snapshot;
+        this->TakeSnapshot(&snapshot);
+        interval_sampler->Sample(snapshot);
+    }
 
     this->WriteBack(regs_instr[REG_INSTR_WRITE_BACK]);
 
@@ -495,11 +700,17 @@ void Machine::OneCycle() {
     if (this->exit_flag)
         return;
 
-    if (regs_instr[REG_INSTR_DECODE] != NULL)
-        if (!regs_instr[REG_INSTR_DECODE]->Decode()) {
+    if (regs_instr[REG_INSTR_DECODE] != NULL) {
+        if (pipeline_tracer != NULL)
+            pipeline_tracer->Stage(regs_instr[REG_INSTR_DECODE], TRACE_STAGE_DECODE, stats->GetCycles());
+        // Instructions found in pre-decoded image are decoded already
+        if (!regs_instr[REG_INSTR_DECODE]->decoded && !regs_instr[REG_INSTR_DECODE]->Decode()) {
             this->DumpState();
             FATAL("Decode error, machine state dumped\n");
         }
+        if (pipeline_tracer != NULL)
+            pipeline_tracer->Decoded(regs_instr[REG_INSTR_DECODE], stats->GetCycles());
+    }
 
     regs_instr[REG_INSTR_DECODE] = this->FetchInstruction();
 
@@ -510,32 +721,88 @@ void Machine::OneCycle() {
     }
 }
 
-void Machine::ReadMemory(int64_t address, int32_t size, int64_t *value) {
-    if (!main_memory->ReadMemory(address, size, value)) {
-        FATAL("Unable to read memory at %lx", address);
-    }
+void Machine::AccessCache(int64_t address, int32_t size, int read, bool fetch) {
     int hit, time;
-    l1->HandleRequest(address, size, 1, hit, time);
+    if (access_trace != NULL)
+        access_trace->Record(fetch ? ACCESS_FETCH : read ? ACCESS_READ : ACCESS_WRITE, address, size, access_pc,
+                             stats->GetCycles(), stats->GetInstructions());
+    StorageStats before[NUM_OF_PROFILE_LEVELS];
+    if (profiler != NULL) {
+        l1->GetStats(before[PROFILE_LEVEL_L1]);
+        l2->GetStats(before[PROFILE_LEVEL_L2]);
+        l3->GetStats(before[PROFILE_LEVEL_L3]);
+    }
+
+    l1->HandleRequest(address, size, read, hit, time);
 
     // The pipeline need to stall for time-1 cycles waiting for data from memory
-    DEBUG("Access time: %d\n", time);
+    TRACE(PIPELINE_ACCESS_TIME, time);
     stats->AddStallByMemory(time - 1);
     stats->AddCycle(time - 1);
     total_access_time += time;
+
+    if (profiler != NULL) {
+        StorageStats after[NUM_OF_PROFILE_LEVELS];
+        l1->GetStats(after[PROFILE_LEVEL_L1]);
+        l2->GetStats(after[PROFILE_LEVEL_L2]);
+        l3->GetStats(after[PROFILE_LEVEL_L3]);
+        profiler->AddCycles(access_pc, time - 1);
+        profiler->AddStallByMemory(access_pc, time - 1);
+        for (int i = 0; i < NUM_OF_PROFILE_LEVELS; i++)
+            if (after[i].miss_num != before[i].miss_num)
+                profiler->AddMiss(access_pc, i, after[i].miss_num - before[i].miss_num);
+    }
+}
+
+void Machine::AccessCacheBlock(int64_t address, int64_t size, int read) {
+    if (size <= 0)
+        return;
+    CacheConfig config;
+    l1->GetConfig(config);
+    int64_t block_size = config.block_size;
+    int64_t end = address + size;
+    for (int64_t line = address & ~(block_size - 1); line < end; line += block_size) {
+        // Each line costs a cycle to issue like a load or store, plus its access time
+        stats->IncreaseCycle();
+        if (profiler != NULL)
+            profiler->AddCycles(access_pc, 1);
+        this->AccessCache(line, (int32_t) block_size, read, false);
+    }
+}
+
+void Machine::HostWritten(int64_t address, int64_t size) {
+    if (decode_cache == NULL)
+        return;
+    while (size > 0) {
+        int64_t chunk = PageSize - (address & (PageSize - 1));
+        if (chunk > size)
+            chunk = size;
+        decode_cache->Invalidate(address, (int32_t) chunk);
+        if (jit != NULL)
+            jit->CodeWritten(address, (int32_t) chunk);
+        address += chunk;
+        size -= chunk;
+    }
+}
+
+void Machine::ReadMemory(int64_t address, int32_t size, int64_t *value) {
+    if (!main_memory->ReadMemory(address, size, value)) {
+        FATAL("Unable to read memory at %lx", address);
+    }
+    if (hooks != NULL && hooks->memory_access != NULL &&
+        hooks->memory_access(hooks->memory_access_data, access_pc, address, size, 1))
+        stop_requested = true;
+    this->AccessCache(address, size, 1, false);
 }
 
 void Machine::WriteMemory(int64_t address, int32_t size, int64_t value) {
     if (!main_memory->WriteMemory(address, size, value)) {
         FATAL("Unable to write memory at %lx", address);
     }
-    int hit, time;
-    l1->HandleRequest(address, size, 0, hit, time);
-
-    // The pipeline need to stall for time-1 cycles writing data to memory
-    DEBUG("Access time: %d\n", time);
-    stats->AddStallByMemory(time - 1);
-    stats->AddCycle(time - 1);
-    total_access_time += time;
+    if (hooks != NULL && hooks->memory_access != NULL &&
+        hooks->memory_access(hooks->memory_access_data, access_pc, address, size, 0))
+        stop_requested = true;
+    this->AccessCache(address, size, 0, false);
 }
 
 bool Machine::IsExit() {
@@ -549,32 +816,255 @@ int64_t Machine::NextToExecute() {
         return regs_instr[REG_INSTR_EXECUTE]->instr_pc;
 }
 
+void Machine::PrintHeapStats() {
+    heap->PrintStats();
+}
+
 void Machine::PrintCacheStats() {
     printf("\n****************\n");
     StorageStats stats;
     float miss_rate;
     l1->GetStats(stats);
     miss_rate = (float) stats.miss_num / stats.access_counter;
-    printf("Total L1 access time: %d cycle, access count: %d, miss rate: %.6f\n",
+    printf("Total L1 access time: %ld cycle, access count: %ld, miss rate: %.6f\n",
            stats.access_time, stats.access_counter, miss_rate);
-    printf("        miss num: %d, replace num: %d\n", stats.miss_num, stats.replace_num);
-    printf("        fetch num: %d, prefetch num: %d\n", stats.fetch_num, stats.prefetch_num);
+    printf("        miss num: %ld, replace num: %ld\n", stats.miss_num, stats.replace_num);
+    printf("        fetch num: %ld, prefetch num: %ld\n", stats.fetch_num, stats.prefetch_num);
 
     l2->GetStats(stats);
     miss_rate = (float) stats.miss_num / stats.access_counter;
-    printf("Total L2 access time: %d cycle, access count: %d, miss rate: %.6f\n",
+    printf("Total L2 access time: %ld cycle, access count: %ld, miss rate: %.6f\n",
            stats.access_time, stats.access_counter, miss_rate);
-    printf("        miss num: %d, replace num: %d\n", stats.miss_num, stats.replace_num);
-    printf("        fetch num: %d, prefetch num: %d\n", stats.fetch_num, stats.prefetch_num);
+    printf("        miss num: %ld, replace num: %ld\n", stats.miss_num, stats.replace_num);
+    printf("        fetch num: %ld, prefetch num: %ld\n", stats.fetch_num, stats.prefetch_num);
 
     l3->GetStats(stats);
     miss_rate = (float) stats.miss_num / stats.access_counter;
-    printf("Total L3 access time: %d cycle, access count: %d, miss rate: %.6f\n",
+    printf("Total L3 access time: %ld cycle, access count: %ld, miss rate: %.6f\n",
            stats.access_time, stats.access_counter, miss_rate);
-    printf("        miss num: %d, replace num: %d\n", stats.miss_num, stats.replace_num);
-    printf("        fetch num: %d, prefetch num: %d\n", stats.fetch_num, stats.prefetch_num);
+    printf("        miss num: %ld, replace num: %ld\n", stats.miss_num, stats.replace_num);
+    printf("        fetch num: %ld, prefetch num: %ld\n", stats.fetch_num, stats.prefetch_num);
 
     memory->GetStats(stats);
-    printf("Total memory access time: %d cycle, access count: %d\n", stats.access_time, stats.access_counter);
-    printf("TOTAL ACCESS TIME: %d cycle\n", total_access_time);
+    printf("Total memory access time: %ld cycle, access count: %ld\n", stats.access_time, stats.access_counter);
+    printf("TOTAL ACCESS TIME: %ld cycle\n", total_access_time);
+}
+
+void Machine::EnableProfiler() {
+    if (profiler == NULL)
+        profiler = new Profiler();
+}
+
+void Machine::PrintProfile(FILE *file) {
+    ASSERT(profiler != NULL);
+    profiler->PrintReport(file, symbol_table, main_memory);
+}
+
+void Machine::EnableCallStackSampler(int64_t sample_period) {
+    if (call_stack_sampler == NULL)
+        call_stack_sampler = new CallStackSampler(reg_pc, sample_period);
+}
+
+void Machine::WriteFlameGraph(FILE *file) {
+    ASSERT(call_stack_sampler != NULL);
+    call_stack_sampler->WriteCollapsedStacks(file, symbol_table);
+}
+
+void Machine::TakeSnapshot(IntervalSnapshot *snapshot) {
+    snapshot->instructions = stats->GetInstructions();
+    snapshot->cycles = stats->GetCycles();
+    snapshot->stalls_by_ctrl = stats->GetStallsByCtrl();
+    snapshot->stalls_by_data = stats->GetStallsByData();
+    snapshot->stalls_by_memory = stats->GetStallsByMemory();
+    l1->GetStats(snapshot->storage[STORAGE_LEVEL_L1]);
+    l2->GetStats(snapshot->storage[STORAGE_LEVEL_L2]);
+    l3->GetStats(snapshot->storage[STORAGE_LEVEL_L3]);
+    memory->GetStats(snapshot->storage[STORAGE_LEVEL_MEMORY]);
+}
+
+void Machine::EnableIntervalStats(const char *file_name, int format, int64_t interval) {
+    if (interval_sampler == NULL)
+        interval_sampler = new IntervalSampler(file_name, format, interval);
+}
+
+void Machine::FinishIntervalStats() {
+    ASSERT(interval_sampler != NULL);
+    IntervalSnapshot snapshot;
+    this->TakeSnapshot(&snapshot);
+    interval_sampler->Finish(snapshot);
+    delete interval_sampler;
+    interval_sampler = NULL;
+}
+
+void Machine::EnablePipelineTrace(const char *file_name, int64_t start_cycle, int64_t end_cycle) {
+    if (pipeline_tracer == NULL)
+        pipeline_tracer = new PipelineTracer(file_name, start_cycle, end_cycle);
+}
+
+void Machine::FinishPipelineTrace() {
+    ASSERT(pipeline_tracer != NULL);
+    delete pipeline_tracer;
+    pipeline_tracer = NULL;
+}
+
+void Machine::EnableAccessTrace(const char *file_name) {
+    if (access_trace == NULL)
+        access_trace = new AccessTraceWriter(file_name);
+}
+
+void Machine::FinishAccessTrace() {
+    ASSERT(access_trace != NULL);
+    delete access_trace;
+    access_trace = NULL;
+}
+
+void Machine::EnableCPIEstimator() {
+    if (cpi_estimator != NULL)
+        return;
+    cpi_estimator = new CPIEstimator();
+    for (int level = 0; level < NUM_OF_STORAGE_LEVELS; level++) {
+        CacheConfig config;
+        StorageLatency latency;
+        if (level != STORAGE_LEVEL_MEMORY)
+            this->GetCacheConfig(level, config);
+        this->GetStorageLatency(level, latency);
+        cpi_estimator->SetLevel(level, config, latency);
+    }
+}
+
+void Machine::PrintCPIEstimate(FILE *file, Stats *detailed) {
+    ASSERT(cpi_estimator != NULL);
+    cpi_estimator->PrintReport(file, detailed);
+}
+
+void Machine::SetConsole(int fd, int64_t buffer_size, int policy) {
+    delete console;
+    console = new ConsoleBuffer(fd, buffer_size, policy);
+}
+
+void Machine::FlushConsole() {
+    console->Flush();
+}
+
+void Machine::EnableAccelCache() {
+    this->accel_cache = true;
+}
+
+void Machine::SetSandboxRoot(const char *directory) {
+    sandbox->SetRoot(directory);
+}
+
+bool Machine::ReopenGuestFiles() {
+    return sandbox->ReopenFiles();
+}
+
+void Machine::EnableImageCache(const char *directory) {
+    this->image_cache = new ImageCache(directory);
+}
+
+Cache *Machine::CacheLevel(int level) {
+    switch (level) {
+        case STORAGE_LEVEL_L1:
+            return l1;
+        case STORAGE_LEVEL_L2:
+            return l2;
+        case STORAGE_LEVEL_L3:
+            return l3;
+        default: FATAL("Invalid cache level %d\n", level);
+    }
+}
+
+void Machine::SetCacheConfig(int level, CacheConfig config) {
+    this->CacheLevel(level)->SetConfig(config);
+}
+
+void Machine::GetCacheConfig(int level, CacheConfig &config) {
+    this->CacheLevel(level)->GetConfig(config);
+}
+
+void Machine::GetStorageLatency(int level, StorageLatency &latency) {
+    if (level == STORAGE_LEVEL_MEMORY)
+        memory->GetLatency(latency);
+    else
+        this->CacheLevel(level)->GetLatency(latency);
+}
+
+void Machine::SetStorageLatency(int level, StorageLatency latency) {
+    if (level == STORAGE_LEVEL_MEMORY)
+        memory->SetLatency(latency);
+    else
+        this->CacheLevel(level)->SetLatency(latency);
+}
+
+void Machine::SetWritePolicy(int level, int write_through, int write_allocate) {
+    this->CacheLevel(level)->SetWritePolicy(write_through, write_allocate);
+}
+
+void Machine::SetInput(const char *file_name) {
+    FILE *file = fopen(file_name, "r");
+    if (file == NULL) {
+        FATAL("Unable to open input file %s\n", file_name);
+    }
+    if (input != stdin)
+        fclose(input);
+    input = file;
+    sandbox->SetStdin(fileno(input));
+}
+
+void Machine::SetSyscallLog(const char *file_name, int mode) {
+    if (syscall_log != NULL)
+        delete syscall_log;
+    syscall_log = new SyscallLog(file_name, mode);
+}
+
+void Machine::EnableSimulatedClock(int64_t frequency) {
+    ASSERT(frequency > 0);
+    this->clock_frequency = frequency;
+}
+
+void Machine::SetExitMessage(bool enabled) {
+    this->exit_message = enabled;
+}
+
+int64_t Machine::GetExitCode() {
+    return exit_code;
+}
+
+Stats *Machine::GetStats() {
+    return stats;
+}
+
+void Machine::SetHooks(MachineHooks *hooks) {
+    this->hooks = hooks;
+}
+
+bool Machine::TakeStopRequest() {
+    bool requested = stop_requested;
+    stop_requested = false;
+    return requested;
+}
+
+int64_t Machine::ReadRegister(int32_t reg) {
+    ASSERT(reg >= 0 && reg < 32);
+    return registers[reg];
+}
+
+void Machine::WriteRegister(int32_t reg, int64_t value) {
+    ASSERT(reg >= 0 && reg < 32);
+    // Zero register stays zero
+    if (reg != REG_zero)
+        registers[reg] = value;
+}
+
+int64_t Machine::GetPC() {
+    return reg_pc;
+}
+
+void Machine::ReadBlock(int64_t address, void *data, int64_t size) {
+    main_memory->ReadBlock(address, data, size);
+}
+
+void Machine::WriteBlock(int64_t address, const void *data, int64_t size) {
+    main_memory->WriteBlock(address, data, size);
+    this->HostWritten(address, size);
 }
@@ -13,6 +13,22 @@
 #include "instruction.h"
 #include "memory.h"
 #include "cache.h"
+#include "elf_reader.h"
+#include "profiler.h"
+#include "call_stack.h"
+#include "csr.h"
+#include "interval_stats.h"
+#include "pipeline_trace.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "console.h"
+#include "sandbox.h"
+#include "heap.h"
+#include "image_cache.h"
+#include "stats.h"
+#include "syscall_log.h"
+#include "access_trace.h"
+#include "cpi_estimator.h"
 
 #define REG_INSTR_DECODE 0
 #define REG_INSTR_EXECUTE 1
@@ -20,19 +36,69 @@
 #define REG_INSTR_WRITE_BACK 3
 #define SIZE_REG_INSTR 4
 
+#define NUM_OF_SYSCALL_ARGS 6       // system call arguments are passed in a0-a5
+#define RANDOM_STATE_SIZE 128       // same state size as rand() of glibc, so sequences are the same
+
+// Callbacks observing the pipeline, each returns true to ask the driver to stop after the current cycle
+// Called for every instruction reaching Execute stage, which is the last one an instruction can be flushed before
+typedef bool (*InstructionCallback)(void *user_data, const Instruction *instruction);
+// Called for every data access of a load or store in Access Memory stage
+typedef bool (*MemoryAccessCallback)(void *user_data, int64_t pc, int64_t address, int32_t size, int read);
+// Called before a system call is handled, args holds values of a0-a5
+typedef bool (*SystemCallCallback)(void *user_data, int64_t pc, int64_t number, const int64_t *args);
+
+// Callbacks registered by an embedding program, unused ones are NULL
+typedef struct MachineHooks_ {
+    InstructionCallback instruction;
+    void *instruction_data;
+    MemoryAccessCallback memory_access;
+    void *memory_access_data;
+    SystemCallCallback system_call;
+    void *system_call_data;
+} MachineHooks;
+
 class Machine {
 private:
     bool exit_flag;                             // exit flag to indicate if the program should exit
+    int64_t exit_code;                          // exit code of the program, valid after exit
+    bool exit_message;                          // print exit code to stdout on exit
+    Stats *stats;                               // instruction, cycle and stall counts of this machine
     Memory *main_memory;                        // memory with memory management
     Instruction *regs_instr[SIZE_REG_INSTR];    // Save instructions for every pipeline stage
     int64_t registers[32];                      // register file
     int64_t reg_pc;                             // pc register
-    int64_t heap_pointer;                       // points to top of heap
+    HeapAllocator *heap;                        // guest heap and program break
     MemoryForCache *memory;                     // memory for cache use
     Cache *l1;                                  // L1 cache
     Cache *l2;                                  // L2 cache
     Cache *l3;                                  // L3 cache
     int64_t total_access_time;
+    SymbolTable *symbol_table;                  // function symbols of loaded executable
+    Profiler *profiler;                         // per-pc profiler, NULL if disabled
+    int64_t access_pc;                          // pc of instruction which is accessing memory
+    int64_t bubble_pc;                          // pc of last jump, cycles of pipeline bubbles belong to it
+    CallStackSampler *call_stack_sampler;       // shadow call stack sampler, NULL if disabled
+    int64_t hpm_events[NUM_OF_COUNTERS];        // event selected by each mhpmevent CSR
+    int64_t counter_offsets[NUM_OF_COUNTERS];   // subtracted from raw counter values, set by counter writes
+    IntervalSampler *interval_sampler;          // interval statistics sampler, NULL if disabled
+    PipelineTracer *pipeline_tracer;            // Konata pipeline tracer, NULL if disabled
+    AccessTraceWriter *access_trace;            // accesses sent to L1 cache, NULL if not captured
+    CPIEstimator *cpi_estimator;                // observer of functional interpreter, NULL if not estimating
+    DecodeCache *decode_cache;                  // decoded pages of functional interpreter, NULL if not used
+    JIT *jit;                                   // translator of hot blocks, NULL if not used
+    int64_t fusion_sites[NUM_OF_FUSIONS];       // instruction pairs fused by functional interpreter
+    int64_t fusion_counts[NUM_OF_FUSIONS];      // times each kind of fused pair is executed
+    ConsoleBuffer *console;                     // output of the simulated program
+    bool accel_cache;                           // charge cache hierarchy for memory touched by bulk system calls
+    FileSandbox *sandbox;                       // files opened by the simulated program
+    ImageCache *image_cache;                    // pre-decoded image of executable, NULL if not used
+    FILE *input;                                // input of the simulated program, stdin by default
+    struct random_data random_data;             // generator of rand system call
+    char random_state[RANDOM_STATE_SIZE];
+    MachineHooks *hooks;                        // callbacks of embedding program, NULL if there is none
+    SyscallLog *syscall_log;                    // record or replay of nondeterministic results, NULL if not used
+    int64_t clock_frequency;                    // cycles per simulated second, 0 to use host clock
+    bool stop_requested;                        // a callback asked to stop
 
     // Fetch stage of pipeline
     Instruction *FetchInstruction();
@@ -46,21 +112,82 @@ private:
     // Write Back stage of pipeline
     void WriteBack(Instruction *instruction);
 
-    // System call handler
-    void HandleSystemCall(Instruction *instruction, int64_t system_call_number, int64_t system_call_arg);
+    // System call handler, args holds values of a0-a5
+    void HandleSystemCall(Instruction *instruction, int64_t system_call_number, const int64_t *args);
+
+    // Charge cache hierarchy once per cache line of [address, address + size) touched by a bulk system call
+    void AccessCacheBlock(int64_t address, int64_t size, int read);
+
+    // Memory [address, address + size) is written by host, decoded and translated code in it must be discarded
+    void HostWritten(int64_t address, int64_t size);
+
+    // Execute a Zicsr instruction, return old value of the CSR
+    int64_t ExecuteCSR(Instruction *instruction, int64_t value_rs1);
+
+    // Read CSR, return false if CSR is not implemented
+    bool ReadCSR(int32_t csr, int64_t *value);
+
+    // Write CSR, return false if CSR is not implemented or read only
+    bool WriteCSR(int32_t csr, int64_t value);
+
+    // Raw value of a performance counter, before offset is applied
+    int64_t ReadCounter(int32_t counter);
+
+    // Current count of a hpm event
+    int64_t ReadHPMEvent(int64_t event);
 
     // Initialize the heap pointer
     void SetHeapPointer(int64_t address);
 
+    // Move program break to address, return the new break or the current one if address is out of heap
+    int64_t SetBreak(int64_t address);
+
+    // Print exit message and stop the machine
+    void Exit(int64_t exit_code);
+
+    // Linux write: copy guest memory to a file a page at a time, return bytes written or negative errno
+    int64_t WriteFile(int64_t fd, int64_t address, int64_t size);
+
+    // Linux read: copy from a file into guest pages, return bytes read or negative errno
+    int64_t ReadFile(int64_t fd, int64_t address, int64_t size);
+
+    // Linux openat: read path from guest memory and open it in sandbox
+    int64_t OpenFile(int64_t dirfd, int64_t path_address, int64_t flags, int64_t mode);
+
+    // Are nondeterministic results taken from system call log instead of host?
+    bool IsReplaying();
+
+    // Record value produced by system call number, or return the recorded one, value is kept if there is no log
+    int64_t LogValue(int64_t number, int64_t value);
+
+    // Linux read through system call log, data read is recorded, or written to guest memory when replaying
+    int64_t LogReadFile(int64_t number, int64_t fd, int64_t address, int64_t size);
+
+    // Current time in microseconds, from cycle count if simulated clock is enabled
+    int64_t CurrentTime();
+
+    // Send request to cache hierarchy and account the access time, fetch is true for instruction fetches
+    void AccessCache(int64_t address, int32_t size, int read, bool fetch);
+
+    // Cache of a level, one of STORAGE_LEVEL_L1/L2/L3
+    Cache *CacheLevel(int level);
+
+    // Push or pop shadow call stack if a jump instruction is a call or return
+    void TrackCallStack(Instruction *instruction);
+
 public:
 
     Machine();
 
     ~Machine();
 
-    // Load executable file into memory
+    // Load executable file into memory, return false with a message on stderr if it can not be loaded
     bool LoadExecutableFile(const char *file_name);
 
+    // Load ELF executable of file_size bytes at file into memory, return false if it is not a RISC-V executable
+    // or a segment is out of file, segments before a bad one are left in memory
+    bool LoadExecutable(const char *file, int64_t file_size);
+
     // Print values of all registers
     void PrintRegisters();
 
@@ -70,6 +197,13 @@ public:
     // Run a cycle
     void OneCycle();
 
+    // Run until exit with the functional interpreter, which has no pipeline or cache timing
+    // Hot blocks are translated to host code if use_jit is true
+    void RunFunctional(bool use_jit);
+
+    // Print how often instruction pairs are fused by functional interpreter
+    void PrintFusionStats();
+
     // Print machine status
     void DumpState();
 
@@ -86,6 +220,121 @@ public:
     int64_t NextToExecute();
 
     void PrintCacheStats();
+
+    // Print peak heap usage of malloc and free system calls
+    void PrintHeapStats();
+
+    // Attribute cycles, stalls and cache misses to instruction pcs
+    void EnableProfiler();
+
+    // Print profile report aggregated by function
+    void PrintProfile(FILE *file);
+
+    // Sample shadow call stack every sample_period cycles, should be called after executable is loaded
+    void EnableCallStackSampler(int64_t sample_period);
+
+    // Write sampled call stacks in collapsed format for flame graph tools
+    void WriteFlameGraph(FILE *file);
+
+    // Stream deltas of all counters to file every interval cycles
+    void EnableIntervalStats(const char *file_name, int format, int64_t interval);
+
+    // Write the last partial interval and close interval statistics file
+    void FinishIntervalStats();
+
+    // Trace lifecycle of instructions fetched in [start_cycle, end_cycle) in Konata format
+    void EnablePipelineTrace(const char *file_name, int64_t start_cycle, int64_t end_cycle);
+
+    // Flush and close pipeline trace file
+    void FinishPipelineTrace();
+
+    // Capture every access sent to L1 cache to file in the compressed access trace format
+    void EnableAccessTrace(const char *file_name);
+
+    // Write the last block and the index of access trace and close it
+    void FinishAccessTrace();
+
+    // Estimate pipeline cycles while RunFunctional runs, from op mix and a cache model with the current configs
+    // Instructions are not fused, and the functional interpreter is slower
+    void EnableCPIEstimator();
+
+    // Print estimated CPI, compared with the counters of a pipeline run of the same program if detailed is not NULL
+    void PrintCPIEstimate(FILE *file, Stats *detailed);
+
+    // Send program output to fd through a buffer of buffer_size bytes, flushed according to policy
+    void SetConsole(int fd, int64_t buffer_size, int policy);
+
+    // Hand pending program output to the host
+    void FlushConsole();
+
+    // Charge cache hierarchy for memory copied or set by bulk memory system calls
+    void EnableAccelCache();
+
+    // Allow the simulated program to open files under directory
+    void SetSandboxRoot(const char *directory);
+
+    // Reopen files of the simulated program after fork, so that the offsets are not shared with the parent
+    bool ReopenGuestFiles();
+
+    // Keep pre-decoded images of executables in directory, should be called before executable is loaded
+    void EnableImageCache(const char *directory);
+
+    // Replace config of a cache level, one of STORAGE_LEVEL_L1/L2/L3, should be called before running
+    void SetCacheConfig(int level, CacheConfig config);
+
+    // Config of a cache level, one of STORAGE_LEVEL_L1/L2/L3
+    void GetCacheConfig(int level, CacheConfig &config);
+
+    // Read program input from file instead of stdin
+    void SetInput(const char *file_name);
+
+    // Record results of nondeterministic system calls to file, or replay them from file, mode is SYSCALL_LOG_*
+    void SetSyscallLog(const char *file_name, int mode);
+
+    // Let time system calls see cycles / frequency seconds since epoch instead of host time
+    void EnableSimulatedClock(int64_t frequency);
+
+    // Print exit code to stdout when program exits, enabled by default
+    void SetExitMessage(bool enabled);
+
+    // Exit code of the program
+    int64_t GetExitCode();
+
+    // Instruction, cycle and stall counts
+    Stats *GetStats();
+
+    // Call hooks from pipeline, hooks is owned by caller, NULL to remove
+    void SetHooks(MachineHooks *hooks);
+
+    // Has a callback asked to stop since last call? The request is cleared
+    bool TakeStopRequest();
+
+    // Value of a register in register file
+    int64_t ReadRegister(int32_t reg);
+
+    // Set a register, an instruction in flight which writes the same register overwrites it
+    void WriteRegister(int32_t reg, int64_t value);
+
+    // Pc of next instruction to fetch
+    int64_t GetPC();
+
+    // Copy guest memory to host without cache accounting
+    void ReadBlock(int64_t address, void *data, int64_t size);
+
+    // Copy host data into guest memory without cache accounting, decoded code in it is discarded
+    void WriteBlock(int64_t address, const void *data, int64_t size);
+
+    // Collect counters of stats and storage hierarchy
+    void TakeSnapshot(IntervalSnapshot *snapshot);
+
+    // Latency of a storage level, one of STORAGE_LEVEL_*
+    void GetStorageLatency(int level, StorageLatency &latency);
+
+    // Change latency of a storage level, cached blocks are kept
+    void SetStorageLatency(int level, StorageLatency latency);
+
+    // Change write policy of a cache level, one of STORAGE_LEVEL_L1/L2/L3, cached blocks are kept
+    void SetWritePolicy(int level, int write_through, int write_allocate);
 };
 
 #endif //RISC_V_SIMULATOR_MACHINE_H
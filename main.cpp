@@ -8,14 +8,56 @@
 #include "utility.h"
 #include "machine.h"
 #include "stats.h"
+#include "batch.h"
+#include "fanout.h"
+#include "trace.h"
+#include "cache_replay.h"
+#include "cpi_estimator.h"
+#include "config.h"
 #include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 
 // Global variables
-bool initializing;
-bool debug_enabled;
 bool interactive;
-Machine *machine;
-Stats *stats;
+bool functional;
+bool use_jit;
+FILE *profile_file;
+FILE *flame_graph_file;
+int64_t sample_period;
+const char *interval_file_name;
+int interval_format;
+int64_t interval;
+const char *konata_file_name;
+int64_t konata_start_cycle;
+int64_t konata_end_cycle;
+int console_fd;
+int64_t console_buffer_size;
+int console_flush;
+bool accel_cache;
+const char *sandbox_directory;
+const char *image_cache_directory;
+const char *batch_file_name;
+int32_t batch_jobs;
+int64_t fork_cycle;
+const char *syscall_log_file_name;
+int syscall_log_mode;
+int64_t clock_frequency;
+const char *trace_file_name;
+uint32_t trace_categories;
+const char *access_trace_file_name;
+const char *decode_access_trace_file_name;
+int64_t access_trace_from;
+const char *replay_trace_file_name;
+bool replay_custom_cache[STORAGE_LEVEL_MEMORY];
+CacheConfig replay_cache_config[STORAGE_LEVEL_MEMORY];
+ForkFanout *fanout;
+bool estimate;
+bool estimate_compare;
+bool temporary_syscall_log;
+char temporary_syscall_log_name[] = "/tmp/riscv-sim-log-XXXXXX";
+Stats detailed_stats;
 
 void PrintHelpMessage(FILE *file) {
     fprintf(file, "Usage: rsv-sim [options] <executable>\n");
@@ -23,6 +65,40 @@ void PrintHelpMessage(FILE *file) {
     fprintf(file, "-d debug           : Set debug flag as true\n");
     fprintf(file, "-h help            : Print this help message and exit\n");
     fprintf(file, "-i interactive     : Interactive debug mode\n");
+    fprintf(file, "-f functional      : Run functional interpreter without pipeline and cache timing\n");
+    fprintf(file, "-j jit             : Run functional interpreter and translate hot blocks to host code\n");
+    fprintf(file, "-p profile <file>  : Write per-function cycle/stall/miss profile to <file>\n");
+    fprintf(file, "-g flame <file>    : Write sampled call stacks in collapsed format to <file>\n");
+    fprintf(file, "--sample-period <n>: Sample call stack every <n> cycles, default %d\n", DEFAULT_SAMPLE_PERIOD);
+    fprintf(file, "--interval-output <file>   : Stream interval statistics to <file>\n");
+    fprintf(file, "--interval <n>             : Length of an interval in cycles, default %d\n", DEFAULT_INTERVAL);
+    fprintf(file, "--interval-format csv|bin  : Format of interval statistics, default csv\n");
+    fprintf(file, "--konata <file>            : Write pipeline trace in Konata format to <file>\n");
+    fprintf(file, "--konata-start <cycle>     : Trace instructions fetched from <cycle>, default 0\n");
+    fprintf(file, "--konata-end <cycle>       : Trace instructions fetched before <cycle>, default no limit\n");
+    fprintf(file, "--console-fd <fd>          : Write output of the program to <fd>, default 1\n");
+    fprintf(file, "--console-buffer <bytes>   : Size of program output buffer, default %d\n", DEFAULT_CONSOLE_BUFFER_SIZE);
+    fprintf(file, "--console-flush full|line|always : When program output is flushed, default full, always with -d\n");
+    fprintf(file, "--accel-cache              : Charge cache hierarchy for memory touched by mem_copy/set/move\n");
+    fprintf(file, "--sandbox <dir>            : Let the program open files under <dir>, default no file access\n");
+    fprintf(file, "--image-cache <dir>        : Keep pre-decoded images of executables in <dir> for later runs\n");
+    fprintf(file, "--batch <manifest>         : Run jobs listed in <manifest> concurrently instead of <executable>\n");
+    fprintf(file, "--jobs <n>                 : Number of batch worker threads, default number of host cores\n");
+    fprintf(file, "--fork-at <cycle>          : Run to <cycle>, then fork a child per --fork config and compare them\n");
+    fprintf(file, "--fork <name>:<changes>    : Config of a forked child, e.g. slow:mem-latency=200,l1-write=through\n");
+    fprintf(file, "--record <file>            : Record results of time, rand and input system calls to <file>\n");
+    fprintf(file, "--replay <file>            : Take results of time, rand and input system calls from <file>\n");
+    fprintf(file, "--sim-clock <hz>           : Time system calls count cycles at <hz> from epoch instead of host time\n");
+    fprintf(file, "--trace <file>             : Record tracepoints to binary <file>, needs a build with make TRACE=<mask>\n");
+    fprintf(file, "--trace-categories <list>  : Tracepoints to record or print with -d, e.g. cache,memory, default all\n");
+    fprintf(file, "--decode-trace <file>      : Print binary trace <file> as text and exit\n");
+    fprintf(file, "--access-trace <file>      : Capture every access sent to L1 cache to compressed <file>\n");
+    fprintf(file, "--decode-access-trace <file> : Print access trace <file> as text and exit\n");
+    fprintf(file, "--access-trace-from <n>    : Start decoding at the access made after <n> instructions\n");
+    fprintf(file, "--replay-trace <file>      : Drive only the cache hierarchy with access trace <file>, no program runs\n");
+    fprintf(file, "--replay-cache <level>=<size>[K|M]:<assoc> : Cache config of replay, e.g. l2=512K:16\n");
+    fprintf(file, "--estimate                 : Run functional interpreter and estimate pipeline CPI from miss counts\n");
+    fprintf(file, "--estimate-compare         : Also run the program on the pipeline first and compare the estimate\n");
 }
 
 void PrintInteractiveHelpMessage(FILE *file) {
@@ -37,13 +113,153 @@ void PrintInteractiveHelpMessage(FILE *file) {
 }
 
 
-void Initialize(int argc, char **argv) {
+// Print accesses of decode_access_trace_file_name from access_trace_from instructions
+void DecodeAccessTrace() {
+    static const char *kinds[NUM_OF_ACCESS_KINDS] = {"fetch", "read", "write"};
+    AccessTraceReader reader(decode_access_trace_file_name, false);
+    if (access_trace_from > 0 && !reader.SeekInstruction(access_trace_from)) {
+        FATAL("Access trace %s has no index, it was not finished and can only be read from the start\n",
+              decode_access_trace_file_name);
+    }
+    printf("%14s %14s %16s %-5s %16s %s\n", "Instruction", "Cycle", "PC", "Kind", "Address", "Size");
+    AccessRecord record;
+    while (reader.Next(&record))
+        printf("%14ld %14ld %16.16lx %-5s %16.16lx %d\n", record.instruction, record.cycle, record.pc,
+               kinds[record.kind], record.address, record.size);
+}
+
+// Replay replay_trace_file_name through the cache hierarchy and print its counters
+void ReplayTrace() {
+    CacheReplay replay;
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++)
+        if (replay_custom_cache[level])
+            replay.SetCacheConfig(level, replay_cache_config[level]);
+    replay.Run(replay_trace_file_name);
+    replay.PrintStats(stdout);
+}
+
+// Create a machine with executable loaded and configured by the options
+Machine *CreateMachine(const char *executable_file_name) {
+    Machine *machine = new Machine();
+    if (image_cache_directory != NULL)
+        machine->EnableImageCache(image_cache_directory);
+    if (!machine->LoadExecutableFile(executable_file_name)) {
+        FATAL("Unable to load executable file %s\n", executable_file_name);
+    }
+    if (profile_file != NULL)
+        machine->EnableProfiler();
+    // Debug messages are interleaved with program output, so it is not held back by default
+    if (console_flush < 0)
+        console_flush = debug_enabled ? CONSOLE_FLUSH_ALWAYS : CONSOLE_FLUSH_FULL;
+    machine->SetConsole(console_fd, console_buffer_size, console_flush);
+    if (accel_cache)
+        machine->EnableAccelCache();
+    if (sandbox_directory != NULL)
+        machine->SetSandboxRoot(sandbox_directory);
+    if (syscall_log_file_name != NULL)
+        machine->SetSyscallLog(syscall_log_file_name, syscall_log_mode);
+    if (clock_frequency > 0)
+        machine->EnableSimulatedClock(clock_frequency);
+    if (flame_graph_file != NULL)
+        machine->EnableCallStackSampler(sample_period);
+    if (interval_file_name != NULL)
+        machine->EnableIntervalStats(interval_file_name, interval_format, interval);
+    if (konata_file_name != NULL)
+        machine->EnablePipelineTrace(konata_file_name, konata_start_cycle, konata_end_cycle);
+    if (access_trace_file_name != NULL)
+        machine->EnableAccessTrace(access_trace_file_name);
+    // Tracepoints hit while loading are left out of debug output, as they would come before the pipeline state
+    if (debug_enabled && trace_file_name == NULL && TRACE_CATEGORIES != 0)
+        TraceStartText(stdout, trace_categories);
+    if (estimate)
+        machine->EnableCPIEstimator();
+    return machine;
+}
+
+void Run(Machine *machine) {
+    for (;;) {
+        machine->OneCycle();
+        if (machine->IsExit())
+            break;
+    }
+}
+
+// Run executable on the pipeline into detailed_stats with its output discarded, its system call results are
+// recorded for the estimate run to replay, so both runs see the same input and time
+void RunDetailed(const char *executable_file_name) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd < 0) {
+        FATAL("Unable to open /dev/null\n");
+    }
+    if (syscall_log_file_name == NULL) {
+        int fd = mkstemp(temporary_syscall_log_name);
+        if (fd < 0) {
+            FATAL("Unable to create system call log %s\n", temporary_syscall_log_name);
+        }
+        close(fd);
+        syscall_log_file_name = temporary_syscall_log_name;
+        temporary_syscall_log = true;
+    }
+    int saved_console_fd = console_fd;
+    console_fd = null_fd;
+    estimate = false;
+    Machine *machine = CreateMachine(executable_file_name);
+    machine->SetExitMessage(false);
+    Run(machine);
+    detailed_stats = *machine->GetStats();
+    delete machine;
+    close(null_fd);
+    console_fd = saved_console_fd;
+    estimate = true;
+    syscall_log_mode = SYSCALL_LOG_REPLAY;
+}
+
+// Parse options, return the machine to run or NULL in batch and trace replay mode
+Machine *Initialize(int argc, char **argv) {
+    Machine *machine;
+    const char *executable_file_name = NULL;
+
     // Global variables initialize
     debug_enabled = false;
     interactive = false;
-    initializing = true;
-    machine = new Machine();
-    stats = new Stats();
+    functional = false;
+    use_jit = false;
+    profile_file = NULL;
+    flame_graph_file = NULL;
+    sample_period = DEFAULT_SAMPLE_PERIOD;
+    interval_file_name = NULL;
+    interval_format = INTERVAL_FORMAT_CSV;
+    interval = DEFAULT_INTERVAL;
+    konata_file_name = NULL;
+    konata_start_cycle = 0;
+    konata_end_cycle = INT64_MAX;
+    console_fd = STDOUT_FILENO;
+    console_buffer_size = DEFAULT_CONSOLE_BUFFER_SIZE;
+    console_flush = -1;
+    accel_cache = false;
+    sandbox_directory = NULL;
+    image_cache_directory = NULL;
+    batch_file_name = NULL;
+    fork_cycle = -1;
+    syscall_log_file_name = NULL;
+    syscall_log_mode = SYSCALL_LOG_RECORD;
+    clock_frequency = 0;
+    trace_file_name = NULL;
+    trace_categories = TRACE_ALL;
+    access_trace_file_name = NULL;
+    decode_access_trace_file_name = NULL;
+    access_trace_from = 0;
+    replay_trace_file_name = NULL;
+    for (int level = 0; level < STORAGE_LEVEL_MEMORY; level++)
+        replay_custom_cache[level] = false;
+    fanout = NULL;
+    estimate = false;
+    estimate_compare = false;
+    temporary_syscall_log = false;
+    batch_jobs = std::thread::hardware_concurrency();
+    if (batch_jobs <= 0)
+        batch_jobs = 1;
+    Instruction::BuildDecodeTables();
 
     // Parse cmd arguments
     if (argc < 1) {
@@ -60,24 +276,228 @@ void Initialize(int argc, char **argv) {
         } else if (!strcmp(argv[i], "-i") || !strcmp(argv[i], "--interactive")) {
             interactive = true;
             debug_enabled = true;
+        } else if (!strcmp(argv[i], "-f") || !strcmp(argv[i], "--functional")) {
+            functional = true;
+        } else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jit")) {
+            functional = true;
+            use_jit = true;
+        } else if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--profile")) {
+            ASSERT(i + 1 < argc);
+            profile_file = fopen(argv[++i], "w");
+            if (profile_file == NULL) {
+                FATAL("Unable to open profile file %s\n", argv[i]);
+            }
+        } else if (!strcmp(argv[i], "-g") || !strcmp(argv[i], "--flame")) {
+            ASSERT(i + 1 < argc);
+            flame_graph_file = fopen(argv[++i], "w");
+            if (flame_graph_file == NULL) {
+                FATAL("Unable to open flame graph file %s\n", argv[i]);
+            }
+        } else if (!strcmp(argv[i], "--sample-period")) {
+            ASSERT(i + 1 < argc);
+            sample_period = atol(argv[++i]);
+            ASSERT(sample_period > 0);
+        } else if (!strcmp(argv[i], "--interval-output")) {
+            ASSERT(i + 1 < argc);
+            interval_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--interval")) {
+            ASSERT(i + 1 < argc);
+            interval = atol(argv[++i]);
+            ASSERT(interval > 0);
+        } else if (!strcmp(argv[i], "--interval-format")) {
+            ASSERT(i + 1 < argc);
+            i++;
+            if (!strcmp(argv[i], "csv"))
+                interval_format = INTERVAL_FORMAT_CSV;
+            else if (!strcmp(argv[i], "bin") || !strcmp(argv[i], "binary"))
+                interval_format = INTERVAL_FORMAT_BINARY;
+            else {
+                FATAL("Unknown interval format %s\n", argv[i]);
+            }
+        } else if (!strcmp(argv[i], "--konata")) {
+            ASSERT(i + 1 < argc);
+            konata_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--konata-start")) {
+            ASSERT(i + 1 < argc);
+            konata_start_cycle = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--konata-end")) {
+            ASSERT(i + 1 < argc);
+            konata_end_cycle = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--console-fd")) {
+            ASSERT(i + 1 < argc);
+            console_fd = atoi(argv[++i]);
+            if (fcntl(console_fd, F_GETFD) < 0) {
+                FATAL("Console file descriptor %d is not open\n", console_fd);
+            }
+        } else if (!strcmp(argv[i], "--console-buffer")) {
+            ASSERT(i + 1 < argc);
+            console_buffer_size = atol(argv[++i]);
+            ASSERT(console_buffer_size > 0);
+        } else if (!strcmp(argv[i], "--console-flush")) {
+            ASSERT(i + 1 < argc);
+            i++;
+            if (!strcmp(argv[i], "full"))
+                console_flush = CONSOLE_FLUSH_FULL;
+            else if (!strcmp(argv[i], "line"))
+                console_flush = CONSOLE_FLUSH_LINE;
+            else if (!strcmp(argv[i], "always"))
+                console_flush = CONSOLE_FLUSH_ALWAYS;
+            else {
+                FATAL("Unknown console flush policy %s\n", argv[i]);
+            }
+        } else if (!strcmp(argv[i], "--accel-cache")) {
+            accel_cache = true;
+        } else if (!strcmp(argv[i], "--image-cache")) {
+            ASSERT(i + 1 < argc);
+            image_cache_directory = argv[++i];
+        } else if (!strcmp(argv[i], "--sandbox")) {
+            ASSERT(i + 1 < argc);
+            sandbox_directory = argv[++i];
+        } else if (!strcmp(argv[i], "--batch")) {
+            ASSERT(i + 1 < argc);
+            batch_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--jobs")) {
+            ASSERT(i + 1 < argc);
+            batch_jobs = atoi(argv[++i]);
+            ASSERT(batch_jobs > 0);
+        } else if (!strcmp(argv[i], "--record") || !strcmp(argv[i], "--replay")) {
+            ASSERT(i + 1 < argc);
+            if (syscall_log_file_name != NULL) {
+                FATAL("Only one of --record and --replay can be given\n");
+            }
+            syscall_log_mode = !strcmp(argv[i], "--record") ? SYSCALL_LOG_RECORD : SYSCALL_LOG_REPLAY;
+            syscall_log_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--sim-clock")) {
+            ASSERT(i + 1 < argc);
+            clock_frequency = atol(argv[++i]);
+            ASSERT(clock_frequency > 0);
+        } else if (!strcmp(argv[i], "--trace")) {
+            ASSERT(i + 1 < argc);
+            trace_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--trace-categories")) {
+            ASSERT(i + 1 < argc);
+            trace_categories = TraceParseCategories(argv[++i]);
+            if (trace_categories == 0) {
+                FATAL("Unknown trace categories %s\n", argv[i]);
+            }
+        } else if (!strcmp(argv[i], "--decode-trace")) {
+            ASSERT(i + 1 < argc);
+            if (!TraceDecode(argv[++i], stdout)) {
+                FATAL("%s is not a trace file of this simulator\n", argv[i]);
+            }
+            exit(0);
+        } else if (!strcmp(argv[i], "--access-trace")) {
+            ASSERT(i + 1 < argc);
+            access_trace_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--decode-access-trace")) {
+            ASSERT(i + 1 < argc);
+            decode_access_trace_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--access-trace-from")) {
+            ASSERT(i + 1 < argc);
+            access_trace_from = atol(argv[++i]);
+            ASSERT(access_trace_from >= 0);
+        } else if (!strcmp(argv[i], "--replay-trace")) {
+            ASSERT(i + 1 < argc);
+            replay_trace_file_name = argv[++i];
+        } else if (!strcmp(argv[i], "--replay-cache")) {
+            ASSERT(i + 1 < argc);
+            const char *spec = argv[++i];
+            int level = (spec[0] == 'l' || spec[0] == 'L') ? spec[1] - '1' : -1;
+            if (level < 0 || level >= STORAGE_LEVEL_MEMORY || spec[2] != '=' ||
+                !parse_cache_config(spec + 3, replay_cache_config[level])) {
+                FATAL("Invalid replay cache config %s\n", spec);
+            }
+            replay_custom_cache[level] = true;
+        } else if (!strcmp(argv[i], "--estimate")) {
+            functional = true;
+            estimate = true;
+        } else if (!strcmp(argv[i], "--estimate-compare")) {
+            functional = true;
+            estimate = true;
+            estimate_compare = true;
+        } else if (!strcmp(argv[i], "--fork-at")) {
+            ASSERT(i + 1 < argc);
+            fork_cycle = atol(argv[++i]);
+            ASSERT(fork_cycle >= 0);
+        } else if (!strcmp(argv[i], "--fork")) {
+            ASSERT(i + 1 < argc);
+            if (fanout == NULL)
+                fanout = new ForkFanout();
+            if (!fanout->AddConfig(argv[++i])) {
+                FATAL("Invalid fork config %s\n", argv[i]);
+            }
         } else {
             // It should be the executable file name
             ASSERT(i == argc - 1);
-            machine->LoadExecutableFile(argv[i]);
+            executable_file_name = argv[i];
         }
     }
-    initializing = false;
-}
-
-void Run() {
-    for (;;) {
-        machine->OneCycle();
-        if (machine->IsExit())
-            break;
+    if (decode_access_trace_file_name != NULL) {
+        DecodeAccessTrace();
+        exit(0);
+    }
+    if (replay_trace_file_name != NULL) {
+        if (executable_file_name != NULL || batch_file_name != NULL) {
+            FATAL("Trace replay runs no program, it can not be used with an executable or batch mode\n");
+        }
+        return NULL;
+    }
+    // Estimator observes every instruction the interpreter runs on its own
+    if (estimate && (use_jit || batch_file_name != NULL || fork_cycle >= 0)) {
+        FATAL("CPI estimate can not be used with jit, batch or fork mode\n");
+    }
+    // Pipeline run of the comparison would print its own debug messages
+    if (estimate_compare && debug_enabled) {
+        FATAL("CPI comparison can not be used with debug mode\n");
+    }
+    // Records carry the thread that made them, so a binary trace may be shared by batch jobs
+    if (trace_file_name != NULL)
+        TraceStart(trace_file_name, trace_categories);
+    if (batch_file_name != NULL) {
+        // Jobs share stdout and stdin of the process, so only their results are reported
+        if (executable_file_name != NULL || debug_enabled || profile_file != NULL || flame_graph_file != NULL ||
+            interval_file_name != NULL || konata_file_name != NULL || access_trace_file_name != NULL) {
+            FATAL("Batch mode can not be used with an executable, debugging, profiling or tracing\n");
+        }
+        // Jobs are configured only by their manifest lines, options of one run would be silently dropped
+        if (syscall_log_file_name != NULL || clock_frequency > 0) {
+            FATAL("Batch mode can not be used with --record, --replay or --sim-clock\n");
+        }
+        return NULL;
+    }
+    if (executable_file_name == NULL) {
+        PrintHelpMessage(stderr);
+        exit(-1);
+    }
+    if (functional && (interactive || profile_file != NULL || flame_graph_file != NULL ||
+                       interval_file_name != NULL || konata_file_name != NULL || access_trace_file_name != NULL ||
+                       accel_cache)) {
+        FATAL("Functional mode can not be used with interactive mode, profiling, tracing or cache accounting\n");
+    }
+    // Children only report counters, and files written by profiling or tracing would be shared by all of them
+    if (fork_cycle >= 0 && (functional || interactive || profile_file != NULL || flame_graph_file != NULL ||
+                            interval_file_name != NULL || konata_file_name != NULL || trace_file_name != NULL ||
+                            access_trace_file_name != NULL)) {
+        FATAL("Fork fan-out can not be used with functional or interactive mode, profiling or tracing\n");
     }
+    // Children share one log file, and each of them would take the system calls after the fork point from it
+    if (fork_cycle >= 0 && syscall_log_file_name != NULL) {
+        FATAL("Fork fan-out can not be used with --record or --replay\n");
+    }
+    if (fanout != NULL && fork_cycle < 0) {
+        FATAL("Fork configs are given without --fork-at\n");
+    }
+    if (fork_cycle >= 0 && fanout == NULL)
+        fanout = new ForkFanout();
+    if (estimate_compare)
+        RunDetailed(executable_file_name);
+    machine = CreateMachine(executable_file_name);
+    if (temporary_syscall_log)
+        unlink(temporary_syscall_log_name);
+    return machine;
 }
 
-void InteractiveRun() {
+void InteractiveRun(Machine *machine) {
     char cmd[8];
     int64_t cmd_arg, value;
 
@@ -121,13 +541,70 @@ void InteractiveRun() {
     }
 }
 
+// Run jobs of manifest on a pool of batch_jobs threads and print their results
+void BatchRun() {
+    BatchDefaults defaults;
+    defaults.mode = use_jit ? BATCH_MODE_JIT : functional ? BATCH_MODE_FUNCTIONAL : BATCH_MODE_PIPELINE;
+    defaults.accel_cache = accel_cache;
+    defaults.sandbox_directory = sandbox_directory;
+    defaults.image_cache_directory = image_cache_directory;
+    BatchRunner runner(batch_file_name, defaults);
+    runner.Run(batch_jobs);
+    runner.PrintResults(stdout);
+}
+
 int main(int argc, char **argv) {
-    Initialize(argc, argv);
+    Machine *machine = Initialize(argc, argv);
+    if (machine == NULL) {
+        if (replay_trace_file_name != NULL)
+            ReplayTrace();
+        else
+            BatchRun();
+        TraceStop();
+        return 0;
+    }
+    Stats *stats = machine->GetStats();
+    double start_time = HostTime();
     if (interactive)
-        InteractiveRun();
-    else
-        Run();
+        InteractiveRun(machine);
+    else if (functional)
+        machine->RunFunctional(use_jit);
+    else if (fork_cycle >= 0) {
+        // Warm up to the fork point, the children run the rest
+        while (!machine->IsExit() && stats->GetCycles() < fork_cycle)
+            machine->OneCycle();
+        if (!machine->IsExit()) {
+            fanout->Run(machine, stdout);
+            return 0;
+        }
+    } else
+        Run(machine);
+    machine->FlushConsole();
+    double host_time = HostTime() - start_time;
+    if (interval_file_name != NULL)
+        machine->FinishIntervalStats();
+    if (konata_file_name != NULL)
+        machine->FinishPipelineTrace();
+    if (access_trace_file_name != NULL)
+        machine->FinishAccessTrace();
     stats->PrintStats();
-    machine->PrintCacheStats();
+    printf("Host time: %.3lf s, simulation speed: %.3lf MIPS\n", host_time,
+           host_time == 0 ? 0 : stats->GetInstructions() / host_time / 1e6);
+    if (estimate)
+        machine->PrintCPIEstimate(stdout, estimate_compare ? &detailed_stats : NULL);
+    else if (functional)
+        machine->PrintFusionStats();
+    else
+        machine->PrintCacheStats();
+    machine->PrintHeapStats();
+    if (profile_file != NULL) {
+        machine->PrintProfile(profile_file);
+        fclose(profile_file);
+    }
+    if (flame_graph_file != NULL) {
+        machine->WriteFlameGraph(flame_graph_file);
+        fclose(flame_graph_file);
+    }
+    TraceStop();
     return 0;
 }
@@ -6,9 +6,11 @@
 //
 
 #include "mem.h"
+#include "trace.h"
 
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 MemoryPage::MemoryPage(int64_t start_address) : start_address(start_address) {
     this->content = new char[PageSize];
@@ -24,7 +26,7 @@ bool MemoryPage::ReadMemory(int64_t address, int32_t size, int64_t *value) const
     ASSERT(this->AddressInPage(address) && this->AddressInPage(address + size - 1));
 
     int64_t index_in_block = address - start_address;
-    DEBUG("Read memory, address %16.16lx, size %d\n", address, size);
+    TRACE(MEMORY_READ, address, size);
 
     // Read memory
     switch (size) {
@@ -43,7 +45,7 @@ bool MemoryPage::ReadMemory(int64_t address, int32_t size, int64_t *value) const
         default:
             ASSERT(false);
     }
-    DEBUG("\tRead value = %16.16lx\n", *value);
+    TRACE(MEMORY_READ_VALUE, *value);
 
     return true;
 }
@@ -53,7 +55,7 @@ bool MemoryPage::WriteMemory(int64_t address, int32_t size, int64_t value) const
     ASSERT(this->AddressInPage(address) && this->AddressInPage(address + size - 1));
 
     int64_t index_in_block = address - start_address;
-    DEBUG("Write memory, address %16.16lx, size %d\n", address, size);
+    TRACE(MEMORY_WRITE, address, size);
 
     // Write memory
     switch (size) {
@@ -72,7 +74,7 @@ bool MemoryPage::WriteMemory(int64_t address, int32_t size, int64_t value) const
         default:
             ASSERT(false);
     }
-    DEBUG("\tWrite value = %16.16lx\n", value);
+    TRACE(MEMORY_WRITE_VALUE, value);
 
     return true;
 }
@@ -85,69 +87,169 @@ bool operator<(const MemoryPage &a, const MemoryPage &b) {
     return a.start_address < b.start_address;
 }
 
-std::set<MemoryPage>::iterator Memory::FindPage(int64_t address) {
-    for (std::set<MemoryPage>::iterator it = this->memory_page_list.begin(); it != this->memory_page_list.end(); it++) {
-        if (it->AddressInPage(address))
-            return it;
+Memory::Memory() {
+    this->last_page = NULL;
+}
+
+Memory::~Memory() {
+    for (std::map<int64_t, MemoryPage *>::iterator it = memory_page_list.begin(); it != memory_page_list.end(); it++)
+        delete it->second;
+}
+
+MemoryPage *Memory::FindPage(int64_t address) {
+    // Accesses are mostly to the same page as last one
+    if (this->last_page != NULL && this->last_page->AddressInPage(address))
+        return this->last_page;
+
+    std::map<int64_t, MemoryPage *>::iterator it = this->memory_page_list.find(address & ~((int64_t) PageSize - 1));
+    if (it == this->memory_page_list.end()) {
+        // Accessed address is not allocated
+        return NULL;
     }
+    this->last_page = it->second;
+    return it->second;
+}
+
+MemoryPage *Memory::FindOrAllocatePage(int64_t address) {
+    MemoryPage *page = this->FindPage(address);
 
-    // Accessed address is not allocated
-    return this->memory_page_list.end();
+    // If address is not allocated, allocate a page
+    if (page == NULL) {
+        bool result = this->AllocatePage(address);
+        if (!result) {
+            FATAL("Cannot allocate page of address %lx\n", address);
+        }
+        page = this->FindPage(address);
+    }
+    return page;
 }
 
 bool Memory::AllocatePage(int64_t address) {
-    std::set<MemoryPage>::iterator it = this->FindPage(address);
-
     // We have to insure this address is not allocated
-    ASSERT(it == this->memory_page_list.end());
+    ASSERT(this->FindPage(address) == NULL);
 
-    int64_t start_address = address & (~0xFFF);
-    MemoryPage *new_page = new MemoryPage(start_address);
-    this->memory_page_list.insert(*new_page);
+    int64_t start_address = address & ~((int64_t) PageSize - 1);
+    this->memory_page_list[start_address] = new MemoryPage(start_address);
 
     return true;
 }
 
 bool Memory::DeallocatePage(int64_t address) {
-    std::set<MemoryPage>::iterator it = this->FindPage(address);
+    MemoryPage *page = this->FindPage(address);
 
     // We have to insure this address is allocated
-    ASSERT(it != this->memory_page_list.end());
+    ASSERT(page != NULL);
 
-    this->memory_page_list.erase(it);
+    this->memory_page_list.erase(page->start_address);
+    if (this->last_page == page)
+        this->last_page = NULL;
+    delete page;
 
     return true;
 }
 
+bool Memory::IsAllocated(int64_t address) {
+    return this->FindPage(address) != NULL;
+}
+
 
 bool Memory::ReadMemory(int64_t address, int32_t size, int64_t *value) {
-    std::set<MemoryPage>::iterator it = this->FindPage(address);
+    return this->FindOrAllocatePage(address)->ReadMemory(address, size, value);
+}
 
-    // We have to insure this address is allocated
-    // If address is not allocated, allocate a page
-    if (it == this->memory_page_list.end()) {
-        bool result = this->AllocatePage(address);
-        if (!result) {
-            FATAL("Cannot allocate page of address %lx\n", address);
-        }
-        it = this->FindPage(address);
-    }
 
-    return it->ReadMemory(address, size, value);
+bool Memory::WriteMemory(int64_t address, int32_t size, int64_t value) {
+    return this->FindOrAllocatePage(address)->WriteMemory(address, size, value);
 }
 
+char *Memory::GetSpan(int64_t address, int64_t *size) {
+    MemoryPage *page = this->FindOrAllocatePage(address);
+    *size = page->start_address + PageSize - address;
+    return page->content + (address - page->start_address);
+}
 
-bool Memory::WriteMemory(int64_t address, int32_t size, int64_t value) {
-    std::set<MemoryPage>::iterator it = this->FindPage(address);
+void Memory::ReadBlock(int64_t address, void *data, int64_t size) {
+    TRACE(MEMORY_READ_BLOCK, address, size);
+    char *destination = (char *) data;
+    while (size > 0) {
+        int64_t span_size;
+        char *span = this->GetSpan(address, &span_size);
+        if (span_size > size)
+            span_size = size;
+        memcpy(destination, span, span_size);
+        destination += span_size;
+        address += span_size;
+        size -= span_size;
+    }
+}
 
-    // If address is not allocated, allocate a page
-    if (it == this->memory_page_list.end()) {
-        bool result = this->AllocatePage(address);
-        if (!result) {
-            FATAL("Cannot allocate page of address %lx\n", address);
+void Memory::WriteBlock(int64_t address, const void *data, int64_t size) {
+    TRACE(MEMORY_WRITE_BLOCK, address, size);
+    const char *source = (const char *) data;
+    while (size > 0) {
+        int64_t span_size;
+        char *span = this->GetSpan(address, &span_size);
+        if (span_size > size)
+            span_size = size;
+        memcpy(span, source, span_size);
+        source += span_size;
+        address += span_size;
+        size -= span_size;
+    }
+}
+
+void Memory::MoveBlock(int64_t destination, int64_t source, int64_t size) {
+    TRACE(MEMORY_MOVE_BLOCK, source, destination, size);
+    if ((uint64_t) (destination - source) >= (uint64_t) size) {
+        // Destination does not start inside source, copying forward never reads a byte already overwritten
+        while (size > 0) {
+            int64_t destination_size, source_size;
+            char *destination_span = this->GetSpan(destination, &destination_size);
+            char *source_span = this->GetSpan(source, &source_size);
+            int64_t chunk = std::min(size, std::min(destination_size, source_size));
+            memmove(destination_span, source_span, chunk);
+            destination += chunk;
+            source += chunk;
+            size -= chunk;
+        }
+    } else {
+        // Destination overlaps the end of source, copy backward from the ends of both blocks
+        while (size > 0) {
+            int64_t destination_size = ((destination + size - 1) & (PageSize - 1)) + 1;
+            int64_t source_size = ((source + size - 1) & (PageSize - 1)) + 1;
+            int64_t chunk = std::min(size, std::min(destination_size, source_size));
+            size -= chunk;
+            char *destination_span = this->GetSpan(destination + size, &destination_size);
+            char *source_span = this->GetSpan(source + size, &source_size);
+            memmove(destination_span, source_span, chunk);
         }
-        it = this->FindPage(address);
     }
+}
 
-    return it->WriteMemory(address, size, value);
-}
\ No newline at end of file
+void Memory::FillBlock(int64_t address, int8_t value, int64_t size) {
+    TRACE(MEMORY_FILL_BLOCK, address, size);
+    while (size > 0) {
+        int64_t span_size;
+        char *span = this->GetSpan(address, &span_size);
+        if (span_size > size)
+            span_size = size;
+        memset(span, value, span_size);
+        address += span_size;
+        size -= span_size;
+    }
+}
+
+int64_t Memory::FindByte(int64_t address, int64_t size, int8_t value) {
+    int64_t offset = 0;
+    while (offset < size) {
+        int64_t span_size;
+        char *span = this->GetSpan(address + offset, &span_size);
+        if (span_size > size - offset)
+            span_size = size - offset;
+        char *found = (char *) memchr(span, value, span_size);
+        if (found != NULL)
+            return offset + (found - span);
+        offset += span_size;
+    }
+    return -1;
+}
@@ -9,7 +9,7 @@
 #define RISC_V_SIMULATOR_MEM_H
 
 #include "utility.h"
-#include <set>
+#include <map>
 
 
 class MemoryPage {
@@ -35,24 +35,52 @@ bool operator<(const MemoryPage &a, const MemoryPage &b);
 
 class Memory {
 private:
-    std::set<MemoryPage> memory_page_list;      // use a set (speed up searching) to store memory pages
+    std::map<int64_t, MemoryPage *> memory_page_list;   // memory pages indexed by start address
+    MemoryPage *last_page;                              // page found by last lookup, NULL if none
 
-    // Find the page that contains accessed address
-    std::set<MemoryPage>::iterator FindPage(int64_t address);
+    // Find the page that contains accessed address, NULL if it is not allocated
+    MemoryPage *FindPage(int64_t address);
+
+    // Find the page that contains accessed address, allocate it if needed
+    MemoryPage *FindOrAllocatePage(int64_t address);
 
 public:
+    Memory();
+
+    ~Memory();
+
     // Allocate a page that contains given address
     bool AllocatePage(int64_t address);
 
     // Deallocate a page that contains given address
     bool DeallocatePage(int64_t address);
 
+    // Is the page that contains given address allocated?
+    bool IsAllocated(int64_t address);
+
     // Read memory, size should be 1, 2, 4 or 8
     bool ReadMemory(int64_t address, int32_t size, int64_t *value);
 
     // Write memory, size should be 1, 2, 4 or 8
     bool WriteMemory(int64_t address, int32_t size, int64_t value);
 
+    // Host pointer to guest memory at address, size is set to the number of bytes until end of its page
+    char *GetSpan(int64_t address, int64_t *size);
+
+    // Copy size bytes of guest memory from address to data, the block may cross pages
+    void ReadBlock(int64_t address, void *data, int64_t size);
+
+    // Copy size bytes from data to guest memory at address, the block may cross pages
+    void WriteBlock(int64_t address, const void *data, int64_t size);
+
+    // Copy size bytes of guest memory from source to destination, the two blocks may overlap
+    void MoveBlock(int64_t destination, int64_t source, int64_t size);
+
+    // Set size bytes of guest memory at address to value
+    void FillBlock(int64_t address, int8_t value, int64_t size);
+
+    // Offset of the first byte equal to value in [address, address + size), -1 if not found
+    int64_t FindByte(int64_t address, int64_t size, int8_t value);
 };
 
 #endif //RISC_V_SIMULATOR_MEM_H
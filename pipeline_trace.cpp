@@ -0,0 +1,97 @@
+//
+// Name: pipeline_trace
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "pipeline_trace.h"
+
+PipelineTracer::PipelineTracer(const char *file_name, int64_t start_cycle, int64_t end_cycle) {
+    ASSERT(start_cycle >= 0 && start_cycle < end_cycle);
+    this->writer = new BufferedWriter(file_name, DEFAULT_WRITER_BUFFER_SIZE);
+    this->start_cycle = start_cycle;
+    this->end_cycle = end_cycle;
+    this->current_cycle = 0;
+    this->started = false;
+    this->next_id = 0;
+    this->next_retire_id = 0;
+}
+
+PipelineTracer::~PipelineTracer() {
+    BeginCycle(current_cycle + 1);
+    delete writer;
+}
+
+void PipelineTracer::AdvanceTo(int64_t cycle) {
+    if (cycle > current_cycle) {
+        writer->Printf("C\t%ld\n", cycle - current_cycle);
+        current_cycle = cycle;
+    }
+}
+
+void PipelineTracer::Fetch(Instruction *instruction, int64_t cycle) {
+    if (cycle < start_cycle || cycle >= end_cycle) {
+        instruction->trace_id = -1;
+        return;
+    }
+    if (!started) {
+        writer->Printf("Kanata\t0004\nC=\t%ld\n", cycle);
+        current_cycle = cycle;
+        started = true;
+    }
+
+    AdvanceTo(cycle);
+    instruction->trace_id = next_id++;
+    writer->Printf("I\t%ld\t%ld\t0\n", instruction->trace_id, instruction->trace_id);
+    writer->Printf("L\t%ld\t0\t%lx: \n", instruction->trace_id, instruction->instr_pc);
+    writer->Printf("S\t%ld\t0\t%s\n", instruction->trace_id, TRACE_STAGE_FETCH);
+}
+
+void PipelineTracer::Stage(Instruction *instruction, const char *stage, int64_t cycle) {
+    if (instruction->trace_id < 0)
+        return;
+    AdvanceTo(cycle);
+    writer->Printf("S\t%ld\t0\t%s\n", instruction->trace_id, stage);
+}
+
+void PipelineTracer::Decoded(Instruction *instruction, int64_t cycle) {
+    if (instruction->trace_id < 0)
+        return;
+    char text[64];
+    instruction->Disassemble(text, sizeof(text));
+    const char *label = text;
+    while (*label == ' ')
+        label++;
+    AdvanceTo(cycle);
+    writer->Printf("L\t%ld\t0\t%s\n", instruction->trace_id, label);
+}
+
+void PipelineTracer::Stall(Instruction *instruction, const char *reason, int64_t stall_cycles, int64_t cycle) {
+    if (instruction->trace_id < 0 || stall_cycles <= 0)
+        return;
+    AdvanceTo(cycle);
+    writer->Printf("L\t%ld\t1\t%s stall %ld cycles at %ld; \n", instruction->trace_id, reason, stall_cycles, cycle);
+}
+
+void PipelineTracer::BeginCycle(int64_t cycle) {
+    if (pending_retires.empty())
+        return;
+    AdvanceTo(cycle);
+    for (int i = 0; i < pending_retires.size(); i++)
+        writer->Printf("R\t%ld\t%ld\t0\n", pending_retires[i], next_retire_id++);
+    pending_retires.clear();
+}
+
+void PipelineTracer::Retire(Instruction *instruction) {
+    if (instruction->trace_id < 0)
+        return;
+    pending_retires.push_back(instruction->trace_id);
+}
+
+void PipelineTracer::Flush(Instruction *instruction, int64_t cycle) {
+    if (instruction->trace_id < 0)
+        return;
+    AdvanceTo(cycle);
+    writer->Printf("R\t%ld\t0\t1\n", instruction->trace_id);
+}
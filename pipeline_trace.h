@@ -0,0 +1,65 @@
+//
+// Name: pipeline_trace
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_PIPELINE_TRACE_H
+#define RISC_V_SIMULATOR_PIPELINE_TRACE_H
+
+#include "utility.h"
+#include "instruction.h"
+#include "buffered_writer.h"
+#include <vector>
+
+// Stage names shown in Konata
+#define TRACE_STAGE_FETCH "F"
+#define TRACE_STAGE_DECODE "D"
+#define TRACE_STAGE_EXECUTE "X"
+#define TRACE_STAGE_ACCESS_MEM "M"
+#define TRACE_STAGE_WRITE_BACK "W"
+
+// Writes lifecycle of every instruction in Konata (Kanata 0004) log format
+class PipelineTracer {
+private:
+    BufferedWriter *writer;         // output file
+    int64_t start_cycle;            // instructions fetched in [start_cycle, end_cycle) are traced
+    int64_t end_cycle;
+    int64_t current_cycle;          // cycle of last written command
+    bool started;                   // has the header been written?
+    int64_t next_id;                // id of next traced instruction
+    int64_t next_retire_id;         // id of next retired instruction
+    std::vector<int64_t> pending_retires;   // instructions which finished Write Back in last cycle
+
+    // Write cycle command if time has advanced
+    void AdvanceTo(int64_t cycle);
+
+public:
+    PipelineTracer(const char *file_name, int64_t start_cycle, int64_t end_cycle);
+
+    ~PipelineTracer();
+
+    // A new cycle begins, instructions finished Write Back in last cycle leave the pipeline
+    void BeginCycle(int64_t cycle);
+
+    // Instruction is fetched, assign trace id if cycle is in traced range
+    void Fetch(Instruction *instruction, int64_t cycle);
+
+    // Instruction enters a pipeline stage
+    void Stage(Instruction *instruction, const char *stage, int64_t cycle);
+
+    // Append disassembly to the label of instruction
+    void Decoded(Instruction *instruction, int64_t cycle);
+
+    // Instruction is stalled for some cycles, shown in the detail of instruction
+    void Stall(Instruction *instruction, const char *reason, int64_t stall_cycles, int64_t cycle);
+
+    // Instruction finishes Write Back stage, it retires when next cycle begins
+    void Retire(Instruction *instruction);
+
+    // Instruction is removed from the pipeline by a jump
+    void Flush(Instruction *instruction, int64_t cycle);
+};
+
+#endif //RISC_V_SIMULATOR_PIPELINE_TRACE_H
@@ -0,0 +1,189 @@
+//
+// Name: profiler
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "profiler.h"
+#include "instruction.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// Profile of a function, used when aggregating pc profiles
+typedef struct FunctionProfile_ {
+    std::string name;
+    int64_t start;                  // start address, or lowest profiled pc of unknown code
+    int64_t end;                    // end address, or just after highest profiled pc if size is unknown
+    bool known;                     // is this function found in symbol table?
+    PCProfile profile;
+} FunctionProfile;
+
+static bool CompareFunctionCycles(const FunctionProfile &a, const FunctionProfile &b) {
+    return a.profile.cycles > b.profile.cycles;
+}
+
+static void AccumulateProfile(PCProfile &to, const PCProfile &from) {
+    to.cycles += from.cycles;
+    to.instructions += from.instructions;
+    to.stalls_by_ctrl += from.stalls_by_ctrl;
+    to.stalls_by_data += from.stalls_by_data;
+    to.stalls_by_memory += from.stalls_by_memory;
+    for (int i = 0; i < NUM_OF_PROFILE_LEVELS; i++)
+        to.misses[i] += from.misses[i];
+}
+
+Profiler::Profiler() {
+    last_pc = -1;
+    last_profile = NULL;
+}
+
+PCProfile *Profiler::GetProfile(int64_t pc) {
+    if (pc == last_pc)
+        return last_profile;
+
+    std::map<int64_t, PCProfile>::iterator it = pc_profiles.find(pc);
+    if (it == pc_profiles.end()) {
+        PCProfile profile;
+        memset(&profile, 0, sizeof(profile));
+        it = pc_profiles.insert(std::make_pair(pc, profile)).first;
+    }
+    last_pc = pc;
+    last_profile = &it->second;
+    return last_profile;
+}
+
+void Profiler::AddCycles(int64_t pc, int64_t cycles) {
+    GetProfile(pc)->cycles += cycles;
+}
+
+void Profiler::IncreaseInstruction(int64_t pc) {
+    GetProfile(pc)->instructions++;
+}
+
+void Profiler::IncreaseStallByCtrl(int64_t pc) {
+    GetProfile(pc)->stalls_by_ctrl++;
+}
+
+void Profiler::IncreaseStallByData(int64_t pc) {
+    GetProfile(pc)->stalls_by_data++;
+}
+
+void Profiler::AddStallByMemory(int64_t pc, int32_t stalls) {
+    GetProfile(pc)->stalls_by_memory += stalls;
+}
+
+void Profiler::AddMiss(int64_t pc, int level, int32_t misses) {
+    ASSERT(level >= 0 && level < NUM_OF_PROFILE_LEVELS);
+    GetProfile(pc)->misses[level] += misses;
+}
+
+void Profiler::PrintReport(FILE *file, const SymbolTable *symbol_table, Memory *memory) {
+    // Aggregate pc profiles by function, pcs without symbol go to one [unknown] entry
+    std::map<int64_t, FunctionProfile> function_map;
+    PCProfile total;
+    memset(&total, 0, sizeof(total));
+    for (std::map<int64_t, PCProfile>::iterator it = pc_profiles.begin(); it != pc_profiles.end(); it++) {
+        const FunctionSymbol *symbol = symbol_table->FindFunction(it->first);
+        int64_t key = symbol != NULL ? symbol->address : -1;
+        std::map<int64_t, FunctionProfile>::iterator function_it = function_map.find(key);
+        if (function_it == function_map.end()) {
+            FunctionProfile function;
+            memset(&function.profile, 0, sizeof(function.profile));
+            if (symbol != NULL) {
+                function.name = symbol->name;
+                function.start = symbol->address;
+                function.end = symbol->address + symbol->size;
+                function.known = true;
+            } else {
+                function.name = "[unknown]";
+                function.start = it->first;
+                function.end = it->first;
+                function.known = false;
+            }
+            function_it = function_map.insert(std::make_pair(key, function)).first;
+        }
+
+        // Functions without size end after the last profiled instruction
+        if (!function_it->second.known || function_it->second.end <= it->first)
+            function_it->second.end = it->first + 4;
+        AccumulateProfile(function_it->second.profile, it->second);
+        AccumulateProfile(total, it->second);
+    }
+
+    std::vector<FunctionProfile> functions;
+    for (std::map<int64_t, FunctionProfile>::iterator it = function_map.begin(); it != function_map.end(); it++)
+        functions.push_back(it->second);
+    std::sort(functions.begin(), functions.end(), CompareFunctionCycles);
+
+    fprintf(file, "# Total cycles: %ld, instructions: %ld\n", total.cycles, total.instructions);
+    fprintf(file, "# %8s %12s %12s %10s %10s %10s %10s %10s %10s  %s\n", "Overhead", "Cycles", "Instrs",
+            "CtrlStall", "DataStall", "MemStall", "L1Miss", "L2Miss", "L3Miss", "Function");
+    for (int i = 0; i < functions.size(); i++) {
+        const PCProfile &profile = functions[i].profile;
+        double overhead = total.cycles == 0 ? 0 : 100.0 * profile.cycles / total.cycles;
+        fprintf(file, "  %7.2lf%% %12ld %12ld %10ld %10ld %10ld %10ld %10ld %10ld  %s\n", overhead,
+                profile.cycles, profile.instructions, profile.stalls_by_ctrl, profile.stalls_by_data,
+                profile.stalls_by_memory, profile.misses[PROFILE_LEVEL_L1], profile.misses[PROFILE_LEVEL_L2],
+                profile.misses[PROFILE_LEVEL_L3], functions[i].name.c_str());
+    }
+
+    // Annotated disassembly of hottest functions
+    for (int i = 0; i < functions.size() && i < PROFILE_ANNOTATE_FUNCTIONS; i++) {
+        if (functions[i].profile.cycles == 0)
+            break;
+        PrintAnnotatedFunction(file, memory, functions[i].name.c_str(), functions[i].start, functions[i].end,
+                               functions[i].known, functions[i].profile);
+    }
+}
+
+void Profiler::PrintAnnotatedFunction(FILE *file, Memory *memory, const char *name, int64_t start, int64_t end,
+                                      bool contiguous, const PCProfile &function_profile) {
+    fprintf(file, "\n# Annotation of %s [%16.16lx, %16.16lx)\n", name, start, end);
+    fprintf(file, "# %8s %12s %10s %10s %10s %10s %10s  %s\n", "Percent", "Cycles", "Instrs", "Stalls",
+            "L1Miss", "L2Miss", "L3Miss", "Instruction");
+
+    if (contiguous) {
+        for (int64_t pc = start; pc < end;)
+            pc += PrintAnnotatedInstruction(file, memory, pc, function_profile);
+    } else {
+        // Code without symbol is not contiguous, only print profiled instructions
+        std::map<int64_t, PCProfile>::iterator it;
+        for (it = pc_profiles.lower_bound(start); it != pc_profiles.end() && it->first < end; it++)
+            PrintAnnotatedInstruction(file, memory, it->first, function_profile);
+    }
+}
+
+int32_t Profiler::PrintAnnotatedInstruction(FILE *file, Memory *memory, int64_t pc,
+                                            const PCProfile &function_profile) {
+    PCProfile profile;
+    std::map<int64_t, PCProfile>::iterator it = pc_profiles.find(pc);
+    if (it != pc_profiles.end())
+        profile = it->second;
+    else
+        memset(&profile, 0, sizeof(profile));
+
+    // Disassemble instruction at pc, read by half words so that a trailing compressed instruction is safe
+    Instruction instruction;
+    int64_t value;
+    memset(&instruction, 0, sizeof(instruction));
+    memory->ReadMemory(pc, sizeof(int16_t), &value);
+    instruction.binary_code = (int32_t) (uint16_t) value;
+    if (Decode_c_opcode(instruction.binary_code) == 0x3) {
+        memory->ReadMemory(pc + 2, sizeof(int16_t), &value);
+        instruction.binary_code |= (int32_t) value << 16;
+    }
+    instruction.instr_pc = pc;
+    if (!instruction.Decode())
+        instruction.decoded = false;
+
+    double percent = function_profile.cycles == 0 ? 0 : 100.0 * profile.cycles / function_profile.cycles;
+    int64_t stalls = profile.stalls_by_ctrl + profile.stalls_by_data + profile.stalls_by_memory;
+    fprintf(file, "  %7.2lf%% %12ld %10ld %10ld %10ld %10ld %10ld  ", percent, profile.cycles,
+            profile.instructions, stalls, profile.misses[PROFILE_LEVEL_L1], profile.misses[PROFILE_LEVEL_L2],
+            profile.misses[PROFILE_LEVEL_L3]);
+    instruction.Print(file);
+
+    return Decode_c_opcode(instruction.binary_code) == 0x3 ? 4 : 2;
+}
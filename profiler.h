@@ -0,0 +1,75 @@
+//
+// Name: profiler
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_PROFILER_H
+#define RISC_V_SIMULATOR_PROFILER_H
+
+#include "utility.h"
+#include "elf_reader.h"
+#include "mem.h"
+#include <map>
+
+#define PROFILE_LEVEL_L1 0
+#define PROFILE_LEVEL_L2 1
+#define PROFILE_LEVEL_L3 2
+#define NUM_OF_PROFILE_LEVELS 3
+
+// Number of functions shown in annotated disassembly
+#define PROFILE_ANNOTATE_FUNCTIONS 10
+
+// Events attributed to one instruction (or one function when aggregated)
+typedef struct PCProfile_ {
+    int64_t cycles;
+    int64_t instructions;
+    int64_t stalls_by_ctrl;
+    int64_t stalls_by_data;
+    int64_t stalls_by_memory;
+    int64_t misses[NUM_OF_PROFILE_LEVELS];
+} PCProfile;
+
+class Profiler {
+private:
+    std::map<int64_t, PCProfile> pc_profiles;   // profile of each instruction pc
+    int64_t last_pc;                            // pc of last looked up profile
+    PCProfile *last_profile;                    // last looked up profile, most lookups hit the same pc
+
+    // Find or create the profile of given pc
+    PCProfile *GetProfile(int64_t pc);
+
+    // Print annotated disassembly of a function
+    void PrintAnnotatedFunction(FILE *file, Memory *memory, const char *name, int64_t start, int64_t end,
+                                bool contiguous, const PCProfile &function_profile);
+
+    // Print one annotated instruction, return the length of the instruction
+    int32_t PrintAnnotatedInstruction(FILE *file, Memory *memory, int64_t pc, const PCProfile &function_profile);
+
+public:
+    Profiler();
+
+    // Add cycles to given pc
+    void AddCycles(int64_t pc, int64_t cycles);
+
+    // Add one to instruction number of given pc
+    void IncreaseInstruction(int64_t pc);
+
+    // Add one to ctrl stall number of given pc
+    void IncreaseStallByCtrl(int64_t pc);
+
+    // Add one to data stall number of given pc
+    void IncreaseStallByData(int64_t pc);
+
+    // Add to memory stall number of given pc
+    void AddStallByMemory(int64_t pc, int32_t stalls);
+
+    // Add to cache miss number of given pc at given level
+    void AddMiss(int64_t pc, int level, int32_t misses);
+
+    // Print perf-style report sorted by cycles, followed by annotated disassembly
+    void PrintReport(FILE *file, const SymbolTable *symbol_table, Memory *memory);
+};
+
+#endif //RISC_V_SIMULATOR_PROFILER_H
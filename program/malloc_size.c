@@ -0,0 +1,16 @@
+#include "../lib.h"
+
+// Sizes which are not positive or do not fit in the heap get NULL, and the heap is still usable after them
+
+int main() {
+    int pass = 1;
+    if (malloc(-1) != 0 || malloc(-4096) != 0 || malloc(0) != 0 || malloc(1L << 62) != 0)
+        pass = 0;
+    char *block = malloc(16);
+    if (block == 0)
+        pass = 0;
+    else
+        block[15] = 1;
+    print_string(pass ? "malloc_size: PASS\n" : "malloc_size: FAIL\n");
+    exit(0);
+}
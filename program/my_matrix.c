@@ -40,6 +40,15 @@ int main() {
     multiply(a, b, c, size);
     long finish_time = time();
 
+    for (int i = 0; i < size; i++) {
+        free(a[i]);
+        free(b[i]);
+        free(c[i]);
+    }
+    free(a);
+    free(b);
+    free(c);
+
     if (finish_time - start_time <= 0) {
         print_string("Insufficient duration - Increase the matrix size\n");
         return 1;
@@ -0,0 +1,18 @@
+#include "../lib.h"
+
+// Run with --sandbox on a directory where "leak" links to a file outside it, opening it must be refused
+
+long open_at(const char *path) {
+    register long a0 asm("a0") = -100;
+    register long a1 asm("a1") = (long) path;
+    register long a2 asm("a2") = 0;
+    register long a3 asm("a3") = 0;
+    register long a7 asm("a7") = 56;
+    asm volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3), "r"(a7) : "memory");
+    return a0;
+}
+
+int main() {
+    print_string(open_at("leak") < 0 ? "sandbox_symlink: PASS\n" : "sandbox_symlink: FAIL\n");
+    exit(0);
+}
@@ -0,0 +1,12 @@
+#include "../lib.h"
+
+// A jump which links to x0 is followed by an instruction reading x0, the link address must not be seen there
+
+int main() {
+    long value;
+    asm volatile("la t0, 1f\n\t"
+                 "jalr zero, 0(t0)\n\t"
+                 "1: addi %0, zero, 150\n\t" : "=r"(value) : : "t0");
+    print_string(value == 150 ? "x0_write: PASS\n" : "x0_write: FAIL\n");
+    exit(0);
+}
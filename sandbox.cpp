@@ -0,0 +1,225 @@
+//
+// Name: sandbox
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "sandbox.h"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/openat2.h>
+
+FileSandbox::FileSandbox() {
+    this->root_fd = -1;
+    for (int i = 0; i < MAX_GUEST_FILES; i++)
+        this->host_fds[i] = i <= STDERR_FILENO ? i : -1;
+}
+
+FileSandbox::~FileSandbox() {
+    for (int i = STDERR_FILENO + 1; i < MAX_GUEST_FILES; i++)
+        if (host_fds[i] >= 0)
+            close(host_fds[i]);
+    if (root_fd >= 0)
+        close(root_fd);
+}
+
+void FileSandbox::SetRoot(const char *directory) {
+    if (root_fd >= 0)
+        close(root_fd);
+    root_fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) {
+        FATAL("Unable to open sandbox directory %s\n", directory);
+    }
+}
+
+int64_t FileSandbox::Open(int64_t dirfd, const char *path, int64_t flags, int64_t mode) {
+    if (root_fd < 0)
+        return -EACCES;
+    if (path[0] != '/' && dirfd != RISCV_AT_FDCWD)
+        return -EBADF;
+
+    // Absolute paths are taken relative to root
+    while (*path == '/')
+        path++;
+    if (*path == '\0')
+        path = ".";
+
+    // Refuse to walk out of root
+    for (const char *component = path; *component != '\0';) {
+        const char *end = strchr(component, '/');
+        int64_t length = end == NULL ? strlen(component) : end - component;
+        if (length == 2 && component[0] == '.' && component[1] == '.')
+            return -EACCES;
+        component += length;
+        while (*component == '/')
+            component++;
+    }
+
+    int fd;
+    for (fd = 0; fd < MAX_GUEST_FILES; fd++)
+        if (host_fds[fd] < 0)
+            break;
+    if (fd == MAX_GUEST_FILES)
+        return -EMFILE;
+
+    int host_flags = O_CLOEXEC;
+    switch (flags & RISCV_O_ACCMODE) {
+        case 0:
+            host_flags |= O_RDONLY;
+            break;
+        case 1:
+            host_flags |= O_WRONLY;
+            break;
+        case 2:
+            host_flags |= O_RDWR;
+            break;
+        default:
+            return -EINVAL;
+    }
+    if (flags & RISCV_O_CREAT)
+        host_flags |= O_CREAT;
+    if (flags & RISCV_O_EXCL)
+        host_flags |= O_EXCL;
+    if (flags & RISCV_O_TRUNC)
+        host_flags |= O_TRUNC;
+    if (flags & RISCV_O_APPEND)
+        host_flags |= O_APPEND;
+
+    int host_fd = this->OpenBeneath(path, host_flags, (mode_t) (mode & 0777));
+    if (host_fd < 0)
+        return host_fd;
+    host_fds[fd] = host_fd;
+    return fd;
+}
+
+int FileSandbox::OpenBeneath(const char *path, int flags, mode_t mode) {
+    // Kernel resolves the whole path under root, symlinks leading out of it or to an absolute path fail with EXDEV
+    struct open_how how;
+    memset(&how, 0, sizeof(how));
+    how.flags = flags;
+    how.mode = (flags & O_CREAT) ? mode : 0;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+    int host_fd = (int) syscall(SYS_openat2, root_fd, path, &how, sizeof(how));
+    if (host_fd >= 0)
+        return host_fd;
+    if (errno == EXDEV)
+        return -EACCES;
+    if (errno != ENOSYS)
+        return -errno;
+
+    // Kernels without openat2 walk the path a component at a time and follow no symlink at all
+    int dir_fd = dup(root_fd);
+    if (dir_fd < 0)
+        return -errno;
+    std::string rest(path);
+    for (;;) {
+        size_t slash = rest.find('/');
+        if (slash == std::string::npos)
+            break;
+        std::string component = rest.substr(0, slash);
+        rest = rest.substr(slash + 1);
+        if (component.empty() || component == ".")
+            continue;
+        int next_fd = openat(dir_fd, component.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        int error = errno;
+        close(dir_fd);
+        if (next_fd < 0)
+            return error == ELOOP || error == ENOTDIR ? -EACCES : -error;
+        dir_fd = next_fd;
+    }
+    if (rest.empty())
+        rest = ".";
+    host_fd = openat(dir_fd, rest.c_str(), flags | O_NOFOLLOW, mode);
+    int error = errno;
+    close(dir_fd);
+    if (host_fd < 0)
+        return error == ELOOP ? -EACCES : -error;
+    return host_fd;
+}
+
+int64_t FileSandbox::Close(int64_t fd) {
+    int host_fd = this->HostFd(fd);
+    if (host_fd < 0)
+        return -EBADF;
+    host_fds[fd] = -1;
+    // Standard streams of guest belong to the simulator
+    if (fd <= STDERR_FILENO)
+        return 0;
+    return close(host_fd) < 0 ? -errno : 0;
+}
+
+int64_t FileSandbox::Seek(int64_t fd, int64_t offset, int64_t whence) {
+    int host_fd = this->HostFd(fd);
+    if (host_fd < 0)
+        return -EBADF;
+    // SEEK_SET, SEEK_CUR and SEEK_END have the same values on RISC-V
+    off_t result = lseek(host_fd, offset, (int) whence);
+    return result < 0 ? -errno : result;
+}
+
+int64_t FileSandbox::Stat(int64_t fd, RiscvStat *stat) {
+    int host_fd = this->HostFd(fd);
+    if (host_fd < 0)
+        return -EBADF;
+    struct stat host_stat;
+    if (fstat(host_fd, &host_stat) < 0)
+        return -errno;
+
+    memset(stat, 0, sizeof(RiscvStat));
+    stat->dev = host_stat.st_dev;
+    stat->ino = host_stat.st_ino;
+    stat->mode = host_stat.st_mode;
+    stat->nlink = host_stat.st_nlink;
+    stat->uid = host_stat.st_uid;
+    stat->gid = host_stat.st_gid;
+    stat->rdev = host_stat.st_rdev;
+    stat->size = host_stat.st_size;
+    stat->blksize = host_stat.st_blksize;
+    stat->blocks = host_stat.st_blocks;
+    stat->atime = host_stat.st_atim.tv_sec;
+    stat->atime_nsec = host_stat.st_atim.tv_nsec;
+    stat->mtime = host_stat.st_mtim.tv_sec;
+    stat->mtime_nsec = host_stat.st_mtim.tv_nsec;
+    stat->ctime = host_stat.st_ctim.tv_sec;
+    stat->ctime_nsec = host_stat.st_ctim.tv_nsec;
+    return 0;
+}
+
+int FileSandbox::HostFd(int64_t fd) {
+    if (fd < 0 || fd >= MAX_GUEST_FILES)
+        return -1;
+    return host_fds[fd];
+}
+
+void FileSandbox::SetStdin(int host_fd) {
+    host_fds[STDIN_FILENO] = host_fd;
+}
+
+bool FileSandbox::ReopenFiles() {
+    // Standard streams belong to the simulator and are left shared
+    for (int fd = STDERR_FILENO + 1; fd < MAX_GUEST_FILES; fd++) {
+        if (host_fds[fd] < 0)
+            continue;
+        // Opening the /proc link makes a new description of the same file, even if it has been unlinked
+        int flags = fcntl(host_fds[fd], F_GETFL);
+        off_t offset = lseek(host_fds[fd], 0, SEEK_CUR);
+        char path[32];
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", host_fds[fd]);
+        int host_fd = flags < 0 ? -1 : open(path, (flags & ~(O_CREAT | O_EXCL | O_TRUNC)) | O_CLOEXEC);
+        if (host_fd < 0)
+            return false;
+        if (offset >= 0 && lseek(host_fd, offset, SEEK_SET) < 0) {
+            close(host_fd);
+            return false;
+        }
+        close(host_fds[fd]);
+        host_fds[fd] = host_fd;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+//
+// Name: sandbox
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_SANDBOX_H
+#define RISC_V_SIMULATOR_SANDBOX_H
+
+#include "utility.h"
+#include <sys/types.h>
+
+#define MAX_GUEST_FILES 64              // guest file descriptors are 0 to MAX_GUEST_FILES - 1
+#define GUEST_PATH_MAX 4096             // longest path accepted from guest, including NUL
+
+// Open flags and dirfd of RISC-V Linux, translated to host values
+#define RISCV_O_ACCMODE 03
+#define RISCV_O_CREAT 0100
+#define RISCV_O_EXCL 0200
+#define RISCV_O_TRUNC 01000
+#define RISCV_O_APPEND 02000
+#define RISCV_AT_FDCWD (-100)
+
+// struct stat of RISC-V Linux (asm-generic layout), 128 bytes
+struct RiscvStat {
+    uint64_t dev;
+    uint64_t ino;
+    uint32_t mode;
+    uint32_t nlink;
+    uint32_t uid;
+    uint32_t gid;
+    uint64_t rdev;
+    uint64_t pad1;
+    int64_t size;
+    int32_t blksize;
+    int32_t pad2;
+    int64_t blocks;
+    int64_t atime;
+    uint64_t atime_nsec;
+    int64_t mtime;
+    uint64_t mtime_nsec;
+    int64_t ctime;
+    uint64_t ctime_nsec;
+    uint32_t unused4;
+    uint32_t unused5;
+};
+
+// Files opened by the simulated program, confined to a root directory on host
+// Guest file descriptors 0, 1 and 2 are host stdin, stdout and stderr
+class FileSandbox {
+private:
+    int root_fd;                        // directory which guest paths are resolved in, -1 if opening is denied
+    int host_fds[MAX_GUEST_FILES];      // host file descriptor of each guest one, -1 if it is closed
+
+    // Open path relative to root without leaving it through symlinks, return host fd or negative errno
+    int OpenBeneath(const char *path, int flags, mode_t mode);
+
+public:
+    FileSandbox();
+
+    ~FileSandbox();
+
+    // Allow the guest to open files under directory
+    void SetRoot(const char *directory);
+
+    // Open path under root, return guest file descriptor or negative errno
+    // Absolute paths start at root, paths with a ".." component and symlinks leading out of root are refused
+    int64_t Open(int64_t dirfd, const char *path, int64_t flags, int64_t mode);
+
+    // Close a guest file descriptor, return 0 or negative errno
+    int64_t Close(int64_t fd);
+
+    // Reposition offset of a guest file descriptor, return new offset or negative errno
+    int64_t Seek(int64_t fd, int64_t offset, int64_t whence);
+
+    // Fill stat in RISC-V layout, return 0 or negative errno
+    int64_t Stat(int64_t fd, RiscvStat *stat);
+
+    // Host file descriptor of a guest one, -1 if it is not open
+    int HostFd(int64_t fd);
+
+    // Read guest stdin from host_fd, which stays owned by caller
+    void SetStdin(int host_fd);
+
+    // Give each file opened by the guest its own host open file description at the same offset, so that
+    // processes forked from this one do not move offsets of each other, return false if one can not be reopened
+    bool ReopenFiles();
+};
+
+#endif //RISC_V_SIMULATOR_SANDBOX_H
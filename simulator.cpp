@@ -0,0 +1,112 @@
+//
+// Name: simulator
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "simulator.h"
+#include <cstring>
+
+Simulator::Simulator() {
+    // Only the first simulator fills the tables, the others find them ready or wait for them
+    Instruction::BuildDecodeTables();
+    this->machine = new Machine();
+    // Results are read through the API, not from stdout
+    this->machine->SetExitMessage(false);
+    memset(&this->hooks, 0, sizeof(this->hooks));
+    this->machine->SetHooks(&this->hooks);
+    this->breakpoint_cycle = -1;
+}
+
+Simulator::~Simulator() {
+    delete machine;
+}
+
+Machine *Simulator::GetMachine() {
+    return machine;
+}
+
+bool Simulator::LoadElf(const char *data, int64_t size) {
+    return machine->LoadExecutable(data, size);
+}
+
+bool Simulator::LoadElfFile(const char *file_name) {
+    return machine->LoadExecutableFile(file_name);
+}
+
+int Simulator::Run(int64_t max_cycles) {
+    return this->RunUntil(0, max_cycles);
+}
+
+int Simulator::RunUntil(int64_t pc, int64_t max_cycles) {
+    // Instruction in Execute stage is executed by the next cycle, so the one stopped at is passed after a cycle
+    bool resuming = breakpoint_cycle == machine->GetStats()->GetCycles();
+    breakpoint_cycle = -1;
+    for (int64_t cycle = 0; cycle < max_cycles; cycle++) {
+        if (machine->IsExit())
+            return SIMULATOR_STOP_EXIT;
+        if (pc != 0 && machine->NextToExecute() == pc && !(resuming && cycle == 0)) {
+            breakpoint_cycle = machine->GetStats()->GetCycles();
+            return SIMULATOR_STOP_BREAKPOINT;
+        }
+        machine->OneCycle();
+        if (machine->TakeStopRequest())
+            return machine->IsExit() ? SIMULATOR_STOP_EXIT : SIMULATOR_STOP_CALLBACK;
+    }
+    if (machine->IsExit())
+        return SIMULATOR_STOP_EXIT;
+    return SIMULATOR_STOP_CYCLES;
+}
+
+void Simulator::RunFunctional(bool use_jit) {
+    if (!machine->IsExit())
+        machine->RunFunctional(use_jit);
+}
+
+bool Simulator::IsExit() {
+    return machine->IsExit();
+}
+
+int64_t Simulator::GetExitCode() {
+    return machine->GetExitCode();
+}
+
+int64_t Simulator::ReadRegister(int32_t reg) {
+    return machine->ReadRegister(reg);
+}
+
+void Simulator::WriteRegister(int32_t reg, int64_t value) {
+    machine->WriteRegister(reg, value);
+}
+
+int64_t Simulator::GetPC() {
+    return machine->GetPC();
+}
+
+void Simulator::ReadMemory(int64_t address, void *data, int64_t size) {
+    machine->ReadBlock(address, data, size);
+}
+
+void Simulator::WriteMemory(int64_t address, const void *data, int64_t size) {
+    machine->WriteBlock(address, data, size);
+}
+
+void Simulator::GetStats(SimulatorStats *stats) {
+    machine->TakeSnapshot(stats);
+}
+
+void Simulator::SetInstructionCallback(InstructionCallback callback, void *user_data) {
+    hooks.instruction = callback;
+    hooks.instruction_data = user_data;
+}
+
+void Simulator::SetMemoryAccessCallback(MemoryAccessCallback callback, void *user_data) {
+    hooks.memory_access = callback;
+    hooks.memory_access_data = user_data;
+}
+
+void Simulator::SetSystemCallCallback(SystemCallCallback callback, void *user_data) {
+    hooks.system_call = callback;
+    hooks.system_call_data = user_data;
+}
@@ -0,0 +1,92 @@
+//
+// Name: simulator
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_SIMULATOR_H
+#define RISC_V_SIMULATOR_SIMULATOR_H
+
+#include "utility.h"
+#include "machine.h"
+#include "interval_stats.h"
+
+// Why Run returned
+#define SIMULATOR_STOP_EXIT 0           // program has exited
+#define SIMULATOR_STOP_CYCLES 1         // cycle budget is used up
+#define SIMULATOR_STOP_CALLBACK 2       // a callback returned true
+#define SIMULATOR_STOP_BREAKPOINT 3     // next instruction to execute is at the breakpoint
+
+// Counters of a simulator, storage is indexed by STORAGE_LEVEL_*
+typedef IntervalSnapshot SimulatorStats;
+
+// Entry of libriscvsim, a pipelined machine driven by the embedding program instead of main
+// Callbacks are called from the pipeline of Run only, except the system call one which is also called by
+// RunFunctional
+class Simulator {
+private:
+    Machine *machine;
+    MachineHooks hooks;
+    int64_t breakpoint_cycle;       // cycle when RunUntil last stopped at a breakpoint, -1 if it did not
+
+public:
+    Simulator();
+
+    ~Simulator();
+
+    // Machine for options which have no wrapper here, e.g. SetConsole, SetSandboxRoot or SetCacheConfig
+    Machine *GetMachine();
+
+    // Load ELF executable from memory, return false if it is not a RISC-V executable
+    bool LoadElf(const char *data, int64_t size);
+
+    // Load ELF executable file, return false if it can not be read or is not a RISC-V executable
+    bool LoadElfFile(const char *file_name);
+
+    // Run at most max_cycles cycles of pipeline, return one of SIMULATOR_STOP_*
+    int Run(int64_t max_cycles);
+
+    // Run like Run, and also stop before the instruction at pc is executed, pc 0 sets no breakpoint
+    // Called again right after stopping there, it executes that instruction first instead of stopping at once
+    int RunUntil(int64_t pc, int64_t max_cycles);
+
+    // Run until exit with the functional interpreter, translating hot blocks if use_jit is true
+    // Must not follow Run, which leaves instructions in the pipeline
+    void RunFunctional(bool use_jit);
+
+    // Has the program exited?
+    bool IsExit();
+
+    // Exit code of the program, valid after exit
+    int64_t GetExitCode();
+
+    // Read a register
+    int64_t ReadRegister(int32_t reg);
+
+    // Write a register
+    void WriteRegister(int32_t reg, int64_t value);
+
+    // Pc of next instruction to fetch
+    int64_t GetPC();
+
+    // Copy size bytes of guest memory at address to data
+    void ReadMemory(int64_t address, void *data, int64_t size);
+
+    // Copy size bytes of data to guest memory at address
+    void WriteMemory(int64_t address, const void *data, int64_t size);
+
+    // Fill stats with current counters
+    void GetStats(SimulatorStats *stats);
+
+    // Call callback for every executed instruction, NULL to remove it
+    void SetInstructionCallback(InstructionCallback callback, void *user_data);
+
+    // Call callback for every load and store, NULL to remove it
+    void SetMemoryAccessCallback(MemoryAccessCallback callback, void *user_data);
+
+    // Call callback for every system call, NULL to remove it
+    void SetSystemCallCallback(SystemCallCallback callback, void *user_data);
+};
+
+#endif //RISC_V_SIMULATOR_SIMULATOR_H
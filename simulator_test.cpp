@@ -0,0 +1,97 @@
+//
+// Name: simulator_test
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "simulator.h"
+#include <elf.h>
+#include <cstring>
+#include <vector>
+
+#define TEST_LOAD_ADDRESS 0x10000
+#define TEST_LOOP_COUNT 3
+
+static bool passed = true;
+
+// Record a failed check
+static void Check(bool condition, const char *what) {
+    if (!condition) {
+        printf("simulator_test: %s failed\n", what);
+        passed = false;
+    }
+}
+
+// Build an executable of one PT_LOAD segment holding code, entry at its start
+static std::vector<char> BuildElf(const uint32_t *code, int64_t num_instructions) {
+    int64_t code_offset = sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr);
+    std::vector<char> file(code_offset + num_instructions * sizeof(uint32_t), 0);
+    Elf64_Ehdr *header = (Elf64_Ehdr *) &file[0];
+    memcpy(header->e_ident, ELFMAG, SELFMAG);
+    header->e_ident[EI_CLASS] = ELFCLASS64;
+    header->e_ident[EI_DATA] = ELFDATA2LSB;
+    header->e_ident[EI_VERSION] = EV_CURRENT;
+    header->e_type = ET_EXEC;
+    header->e_machine = EM_RISCV;
+    header->e_version = EV_CURRENT;
+    header->e_entry = TEST_LOAD_ADDRESS;
+    header->e_phoff = sizeof(Elf64_Ehdr);
+    header->e_ehsize = sizeof(Elf64_Ehdr);
+    header->e_phentsize = sizeof(Elf64_Phdr);
+    header->e_phnum = 1;
+    Elf64_Phdr *segment = (Elf64_Phdr *) &file[sizeof(Elf64_Ehdr)];
+    segment->p_type = PT_LOAD;
+    segment->p_flags = PF_R | PF_X;
+    segment->p_offset = code_offset;
+    segment->p_vaddr = TEST_LOAD_ADDRESS;
+    segment->p_paddr = TEST_LOAD_ADDRESS;
+    segment->p_filesz = num_instructions * sizeof(uint32_t);
+    segment->p_memsz = num_instructions * sizeof(uint32_t);
+    segment->p_align = 4;
+    memcpy(&file[code_offset], code, num_instructions * sizeof(uint32_t));
+    return file;
+}
+
+// Stopping at a breakpoint in a loop body and running again must stop there once per iteration
+static void TestBreakpointResume() {
+    const uint32_t code[] = {
+            0x00300293,                 // addi t0, zero, TEST_LOOP_COUNT
+            0xfff28293,                 // loop: addi t0, t0, -1
+            0xfe029ee3,                 // bnez t0, loop
+            0x00700513,                 // addi a0, zero, 7
+            0x00000893,                 // addi a7, zero, RISCV_SYSCALL_EXIT
+            0x00000073,                 // ecall
+    };
+    std::vector<char> file = BuildElf(code, sizeof(code) / sizeof(code[0]));
+    Simulator simulator;
+    Check(simulator.LoadElf(&file[0], file.size()), "LoadElf");
+
+    int64_t loop_pc = TEST_LOAD_ADDRESS + 4;
+    int hits = 0, stop;
+    while ((stop = simulator.RunUntil(loop_pc, 1000)) == SIMULATOR_STOP_BREAKPOINT && hits <= TEST_LOOP_COUNT)
+        hits++;
+    Check(hits == TEST_LOOP_COUNT, "breakpoint hit once per iteration");
+    Check(stop == SIMULATOR_STOP_EXIT && simulator.GetExitCode() == 7, "run to exit after breakpoints");
+}
+
+// Files which can not be loaded are reported by return value, the embedding process keeps running
+static void TestLoadFailure() {
+    Simulator simulator;
+    Check(!simulator.LoadElfFile("/nonexistent/executable"), "LoadElfFile of missing file");
+    Check(!simulator.LoadElfFile("/dev/null"), "LoadElfFile of empty file");
+    const char text[] = "not an executable, just some text longer than an ELF header.......";
+    Check(!simulator.LoadElf(text, sizeof(text)), "LoadElf of text");
+
+    const uint32_t code[] = {0x00000073};
+    std::vector<char> file = BuildElf(code, 1);
+    ((Elf64_Phdr *) &file[sizeof(Elf64_Ehdr)])->p_filesz = file.size();
+    Check(!simulator.LoadElf(&file[0], file.size()), "LoadElf of segment out of file");
+}
+
+int main() {
+    TestBreakpointResume();
+    TestLoadFailure();
+    printf(passed ? "simulator_test: PASS\n" : "simulator_test: FAIL\n");
+    return passed ? 0 : 1;
+}
@@ -6,12 +6,20 @@
 //
 
 #include "stats.h"
+#include <ctime>
+
+double HostTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
 
 Stats::Stats() {
     num_of_instructions = 0;
     num_of_cycles = 0;
     num_of_stalls_by_ctrl = 0;
     num_of_stalls_by_data = 0;
+    num_of_stalls_by_memory = 0;
 }
 
 void Stats::PrintStats() {
@@ -41,10 +49,34 @@ void Stats::IncreaseStallByData() {
     num_of_stalls_by_data++;
 }
 
-void Stats::AddCycle(int cycles) {
+void Stats::AddInstructions(int64_t instructions) {
+    num_of_instructions += instructions;
+}
+
+void Stats::AddCycle(int64_t cycles) {
     this->num_of_cycles += cycles;
 }
 
 void Stats::AddStallByMemory(int32_t stalls) {
     num_of_stalls_by_memory += stalls;
 }
+
+int64_t Stats::GetInstructions() {
+    return num_of_instructions;
+}
+
+int64_t Stats::GetCycles() {
+    return num_of_cycles;
+}
+
+int64_t Stats::GetStallsByCtrl() {
+    return num_of_stalls_by_ctrl;
+}
+
+int64_t Stats::GetStallsByData() {
+    return num_of_stalls_by_data;
+}
+
+int64_t Stats::GetStallsByMemory() {
+    return num_of_stalls_by_memory;
+}
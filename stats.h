@@ -36,11 +36,29 @@ public:
     // Add one to data stall number
     void IncreaseStallByData();
 
+    // Add to instruction number
+    void AddInstructions(int64_t instructions);
+
     // Add to cycle number
-    void AddCycle(int cycles);
+    void AddCycle(int64_t cycles);
 
     // Add to memory stall number
     void AddStallByMemory(int32_t stalls);
+
+    // Get instruction number
+    int64_t GetInstructions();
+
+    // Get cycle number
+    int64_t GetCycles();
+
+    // Get ctrl stall number
+    int64_t GetStallsByCtrl();
+
+    // Get data stall number
+    int64_t GetStallsByData();
+
+    // Get memory stall number
+    int64_t GetStallsByMemory();
 };
 
 #endif //RISC_V_SIMULATOR_STATS_H
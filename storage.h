@@ -16,13 +16,14 @@
   void operator=(const TypeName&)
 
 // Storage access stats
+// 64 bit, so that counters of billions of accesses of a long run or a replayed trace do not wrap
 typedef struct StorageStats_ {
-    int access_counter;
-    int miss_num;
-    int access_time; // In cpu cycles
-    int replace_num; // Evict old lines
-    int fetch_num; // Fetch lower layer
-    int prefetch_num; // Prefetch
+    int64_t access_counter;
+    int64_t miss_num;
+    int64_t access_time; // In cpu cycles
+    int64_t replace_num; // Evict old lines
+    int64_t fetch_num; // Fetch lower layer
+    int64_t prefetch_num; // Prefetch
 } StorageStats;
 
 // Storage basic config
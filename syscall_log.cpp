@@ -0,0 +1,94 @@
+//
+// Name: syscall_log
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "syscall_log.h"
+#include <vector>
+
+SyscallLog::SyscallLog(const char *file_name, int mode) {
+    this->mode = mode;
+    this->entries = 0;
+    this->file = fopen(file_name, mode == SYSCALL_LOG_RECORD ? "wb" : "rb");
+    if (file == NULL) {
+        FATAL("Unable to open system call log %s\n", file_name);
+    }
+    if (mode == SYSCALL_LOG_RECORD) {
+        this->WriteVarint(SYSCALL_LOG_MAGIC);
+        this->WriteVarint(SYSCALL_LOG_VERSION);
+    } else if (this->ReadVarint() != SYSCALL_LOG_MAGIC || this->ReadVarint() != SYSCALL_LOG_VERSION) {
+        FATAL("%s is not a system call log of this simulator\n", file_name);
+    }
+}
+
+SyscallLog::~SyscallLog() {
+    fclose(file);
+}
+
+void SyscallLog::WriteVarint(uint64_t value) {
+    uint8_t buffer[MAX_VARINT_SIZE];
+    fwrite(buffer, 1, PutVarint(buffer, value) - buffer, file);
+}
+
+uint64_t SyscallLog::ReadVarint() {
+    // Gather bytes up to the one without continuation bit, then decode them
+    uint8_t buffer[MAX_VARINT_SIZE];
+    int32_t size = 0;
+    do {
+        int c = fgetc(file);
+        if (c == EOF) {
+            FATAL("System call log ends at entry %ld, the program has diverged from the recorded run\n", entries);
+        }
+        buffer[size++] = (uint8_t) c;
+    } while ((buffer[size - 1] & 0x80) && size < MAX_VARINT_SIZE);
+    const uint8_t *position = buffer;
+    uint64_t value;
+    if (!GetVarint(position, buffer + size, &value)) {
+        FATAL("System call log is corrupted at entry %ld\n", entries);
+    }
+    return value;
+}
+
+void SyscallLog::Tag(int64_t number) {
+    if (mode == SYSCALL_LOG_RECORD) {
+        this->WriteVarint(number);
+    } else {
+        int64_t recorded = this->ReadVarint();
+        if (recorded != number) {
+            FATAL("System call %ld at entry %ld of log was %ld when recorded, the program has diverged\n",
+                  number, entries, recorded);
+        }
+    }
+    entries++;
+}
+
+bool SyscallLog::IsReplaying() {
+    return mode == SYSCALL_LOG_REPLAY;
+}
+
+int64_t SyscallLog::Value(int64_t number, int64_t value) {
+    this->Tag(number);
+    // Zigzag keeps small negative values such as errno results short
+    if (mode == SYSCALL_LOG_RECORD) {
+        this->WriteVarint(ZigzagEncode(value));
+        return value;
+    }
+    return ZigzagDecode(this->ReadVarint());
+}
+
+void SyscallLog::Data(int64_t number, std::string &data) {
+    this->Tag(number);
+    if (mode == SYSCALL_LOG_RECORD) {
+        this->WriteVarint(data.size());
+        fwrite(data.data(), 1, data.size(), file);
+        return;
+    }
+    uint64_t size = this->ReadVarint();
+    std::vector<char> buffer(size);
+    if (size > 0 && fread(&buffer[0], 1, size, file) != size) {
+        FATAL("System call log ends at entry %ld, the program has diverged from the recorded run\n", entries);
+    }
+    data.assign(buffer.begin(), buffer.end());
+}
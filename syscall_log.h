@@ -0,0 +1,51 @@
+//
+// Name: syscall_log
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_SYSCALL_LOG_H
+#define RISC_V_SIMULATOR_SYSCALL_LOG_H
+
+#include "utility.h"
+#include <string>
+
+#define SYSCALL_LOG_RECORD 0
+#define SYSCALL_LOG_REPLAY 1
+
+#define SYSCALL_LOG_MAGIC 0x474c5352        // "RSLG"
+#define SYSCALL_LOG_VERSION 1
+
+// Results of nondeterministic system calls, so a run can be repeated exactly
+// Each entry is the system call number and a zigzag varint value or a length prefixed byte string,
+// replay checks that the program asks for the same system calls in the same order
+class SyscallLog {
+private:
+    FILE *file;
+    int mode;                       // SYSCALL_LOG_RECORD or SYSCALL_LOG_REPLAY
+    int64_t entries;                // entries written or read so far
+
+    void WriteVarint(uint64_t value);
+
+    uint64_t ReadVarint();
+
+    // Write tag of an entry, or read it and check it is for the same system call
+    void Tag(int64_t number);
+
+public:
+    SyscallLog(const char *file_name, int mode);
+
+    ~SyscallLog();
+
+    // Are results read from the log instead of the host?
+    bool IsReplaying();
+
+    // Record value of system call number, or return the recorded one
+    int64_t Value(int64_t number, int64_t value);
+
+    // Record data of system call number, or replace it with the recorded one
+    void Data(int64_t number, std::string &data);
+};
+
+#endif //RISC_V_SIMULATOR_SYSCALL_LOG_H
@@ -0,0 +1,231 @@
+//
+// Name: trace
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#include "trace.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+extern char reg_strings[][8];
+
+uint32_t trace_mask = 0;
+thread_local TraceBuffer trace_buffer;
+
+static const uint32_t event_categories[NUM_OF_TRACE_EVENTS] = {
+#define TRACE_EVENT(name, category, format) category,
+#include "trace.def"
+#undef TRACE_EVENT
+};
+
+static const char *event_formats[NUM_OF_TRACE_EVENTS] = {
+#define TRACE_EVENT(name, category, format) format,
+#include "trace.def"
+#undef TRACE_EVENT
+};
+
+static const char *category_names[] = {"cache", "memory", "pipeline", "loader", "decode"};
+
+static FILE *trace_file = NULL;
+static bool trace_text = false;         // records are printed as text instead of written as they are
+static std::mutex trace_file_mutex;     // held while a thread writes out its records
+static std::atomic<uint32_t> trace_threads(0);
+
+// Print record as format does, %s conversions print the argument as a register name
+static void PrintRecord(FILE *file, const char *format, const TraceRecord &record) {
+    int arg = 0;
+    for (const char *c = format; *c != '\0'; c++) {
+        if (*c != '%') {
+            fputc(*c, file);
+            continue;
+        }
+        if (c[1] == '%') {
+            fputc('%', file);
+            c++;
+            continue;
+        }
+        const char *end = c + 1;
+        while (*end != '\0' && strchr("diouxXs", *end) == NULL)
+            end++;
+        if (*end == '\0')
+            break;
+        std::string conversion(c, end - c + 1);
+        int64_t value = arg < TRACE_MAX_ARGS ? record.args[arg] : 0;
+        arg++;
+        if (*end == 's')
+            fprintf(file, conversion.c_str(), reg_strings[value & 31]);
+        else
+            fprintf(file, conversion.c_str(), value);
+        c = end;
+    }
+}
+
+TraceBuffer::TraceBuffer() {
+    this->records = NULL;
+    this->count = 0;
+    this->thread = 0;
+}
+
+TraceBuffer::~TraceBuffer() {
+    this->Flush();
+    delete[] records;
+}
+
+void TraceBuffer::Append(uint16_t event, int64_t arg0, int64_t arg1, int64_t arg2, int64_t arg3) {
+    if (records == NULL) {
+        records = new TraceRecord[TRACE_BUFFER_RECORDS];
+        thread = trace_threads++;
+    }
+    TraceRecord &record = records[count++];
+    record.event = event;
+    record.reserved = 0;
+    record.thread = thread;
+    record.args[0] = arg0;
+    record.args[1] = arg1;
+    record.args[2] = arg2;
+    record.args[3] = arg3;
+    // Text is interleaved with other output of the simulator, so it is printed at once
+    if (count == TRACE_BUFFER_RECORDS || trace_text)
+        this->Flush();
+}
+
+void TraceBuffer::Flush() {
+    if (count == 0)
+        return;
+    std::lock_guard<std::mutex> lock(trace_file_mutex);
+    if (trace_file != NULL) {
+        if (trace_text) {
+            for (int32_t i = 0; i < count; i++)
+                PrintRecord(trace_file, event_formats[records[i].event], records[i]);
+        } else {
+            fwrite(records, sizeof(TraceRecord), count, trace_file);
+        }
+    }
+    count = 0;
+}
+
+void TraceFlush() {
+    if (trace_file == NULL)
+        return;
+    trace_buffer.Flush();
+    std::lock_guard<std::mutex> lock(trace_file_mutex);
+    fflush(trace_file);
+}
+
+uint32_t TraceParseCategories(const char *categories) {
+    uint32_t mask = 0;
+    std::string list(categories);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos)
+            end = list.size();
+        std::string name = list.substr(start, end - start);
+        start = end + 1;
+        if (name == "all") {
+            mask |= TRACE_ALL;
+            continue;
+        }
+        uint32_t category = 0;
+        for (uint32_t i = 0; i < sizeof(category_names) / sizeof(category_names[0]); i++)
+            if (name == category_names[i])
+                category = 1u << i;
+        if (category == 0)
+            return 0;
+        mask |= category;
+    }
+    return mask;
+}
+
+void TraceStart(const char *file_name, uint32_t mask) {
+    if ((TRACE_CATEGORIES & mask) == 0) {
+        FATAL("Tracepoints of the chosen categories are not compiled in, rebuild with make TRACE=<mask>\n");
+    }
+    trace_file = fopen(file_name, "wb");
+    if (trace_file == NULL) {
+        FATAL("Unable to open trace file %s\n", file_name);
+    }
+
+    // Event table goes first, so the decoder does not depend on the build that wrote the trace
+    uint32_t header[3] = {TRACE_MAGIC, TRACE_VERSION, NUM_OF_TRACE_EVENTS};
+    fwrite(header, sizeof(uint32_t), 3, trace_file);
+    for (int i = 0; i < NUM_OF_TRACE_EVENTS; i++) {
+        uint32_t length = strlen(event_formats[i]);
+        fwrite(&event_categories[i], sizeof(uint32_t), 1, trace_file);
+        fwrite(&length, sizeof(uint32_t), 1, trace_file);
+        fwrite(event_formats[i], 1, length, trace_file);
+    }
+    trace_text = false;
+    trace_mask = mask;
+}
+
+void TraceStartText(FILE *file, uint32_t mask) {
+    trace_file = file;
+    trace_text = true;
+    trace_mask = mask;
+}
+
+void TraceStop() {
+    if (trace_file == NULL)
+        return;
+    trace_buffer.Flush();
+    trace_mask = 0;
+    std::lock_guard<std::mutex> lock(trace_file_mutex);
+    if (trace_text)
+        fflush(trace_file);
+    else
+        fclose(trace_file);
+    trace_file = NULL;
+}
+
+bool TraceDecode(const char *file_name, FILE *output) {
+    FILE *file = fopen(file_name, "rb");
+    if (file == NULL) {
+        FATAL("Unable to open trace file %s\n", file_name);
+    }
+    uint32_t header[3];
+    if (fread(header, sizeof(uint32_t), 3, file) != 3 || header[0] != TRACE_MAGIC || header[1] != TRACE_VERSION) {
+        fclose(file);
+        return false;
+    }
+    std::vector<std::string> formats(header[2]);
+    for (uint32_t i = 0; i < header[2]; i++) {
+        uint32_t category_and_length[2];
+        if (fread(category_and_length, sizeof(uint32_t), 2, file) != 2) {
+            fclose(file);
+            return false;
+        }
+        std::vector<char> format(category_and_length[1] + 1);
+        if (fread(&format[0], 1, category_and_length[1], file) != category_and_length[1]) {
+            fclose(file);
+            return false;
+        }
+        formats[i] = &format[0];
+    }
+
+    // Each thread writes a block of records at a time, a change of thread is marked where blocks meet
+    std::vector<TraceRecord> records(TRACE_BUFFER_RECORDS);
+    int64_t last_thread = -1;
+    size_t count;
+    while ((count = fread(&records[0], sizeof(TraceRecord), TRACE_BUFFER_RECORDS, file)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (records[i].thread != last_thread) {
+                if (last_thread >= 0 || records[i].thread != 0)
+                    fprintf(output, "\n---- thread %u ----\n", records[i].thread);
+                last_thread = records[i].thread;
+            }
+            if (records[i].event >= formats.size()) {
+                fprintf(output, "\nUnknown event %u\n", records[i].event);
+                continue;
+            }
+            PrintRecord(output, formats[records[i].event].c_str(), records[i]);
+        }
+    }
+    fclose(file);
+    return true;
+}
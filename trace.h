@@ -0,0 +1,104 @@
+//
+// Name: trace
+// Project: RISC_V_Simulator
+// Author: Shen Sijie
+// Date: 10/19/26
+//
+
+#ifndef RISC_V_SIMULATOR_TRACE_H
+#define RISC_V_SIMULATOR_TRACE_H
+
+#include "utility.h"
+
+// Categories of tracepoints
+#define TRACE_CACHE 0x01
+#define TRACE_MEMORY 0x02
+#define TRACE_PIPELINE 0x04
+#define TRACE_LOADER 0x08
+#define TRACE_DECODE 0x10
+#define TRACE_ALL 0x1f
+
+// Categories compiled in, set by make TRACE=<mask>, tracepoints of the other categories compile to nothing
+#ifndef TRACE_CATEGORIES
+#define TRACE_CATEGORIES 0
+#endif
+
+#define TRACE_MAX_ARGS 4
+#define TRACE_BUFFER_RECORDS 4096       // records a thread holds before writing them to the trace file
+
+#define TRACE_MAGIC 0x43525452          // "RTRC"
+#define TRACE_VERSION 1
+
+enum TraceEvent {
+#define TRACE_EVENT(name, category, format) TRACE_##name,
+#include "trace.def"
+#undef TRACE_EVENT
+    NUM_OF_TRACE_EVENTS
+};
+
+// Category of each event as a constant, so TRACE can drop disabled tracepoints at compile time
+enum TraceEventCategory {
+#define TRACE_EVENT(name, category, format) TRACE_CATEGORY_##name = category,
+#include "trace.def"
+#undef TRACE_EVENT
+};
+
+// Fixed size record of a tracepoint, arguments are formatted only when the trace is decoded
+typedef struct TraceRecord_ {
+    uint16_t event;
+    uint16_t reserved;
+    uint32_t thread;                    // threads are numbered in the order they first trace
+    int64_t args[TRACE_MAX_ARGS];
+} TraceRecord;
+
+// Records of one thread, only the owning thread appends to them, so recording takes no lock
+class TraceBuffer {
+private:
+    TraceRecord *records;               // allocated when the thread first traces
+    int32_t count;
+    uint32_t thread;
+
+public:
+    TraceBuffer();
+
+    // Write out records left when the thread exits
+    ~TraceBuffer();
+
+    // Append a record, writing out the buffer when it is full
+    void Append(uint16_t event, int64_t arg0, int64_t arg1, int64_t arg2, int64_t arg3);
+
+    // Write out the records held
+    void Flush();
+};
+
+// Categories enabled at run time, 0 if tracing has not started
+extern uint32_t trace_mask;
+extern thread_local TraceBuffer trace_buffer;
+
+// Record event if its category is compiled in and enabled, expands to a single statement
+#define TRACE(event, ...)                                                                         \
+    do {                                                                                          \
+        if ((TRACE_CATEGORIES & TRACE_CATEGORY_##event) && (trace_mask & TRACE_CATEGORY_##event)) \
+            TraceEmit(TRACE_##event, ##__VA_ARGS__);                                              \
+    } while (0)
+
+inline void TraceEmit(uint16_t event, int64_t arg0 = 0, int64_t arg1 = 0, int64_t arg2 = 0, int64_t arg3 = 0) {
+    trace_buffer.Append(event, arg0, arg1, arg2, arg3);
+}
+
+// Parse a comma separated list of categories such as "cache,memory" or "all", return 0 if it is invalid
+uint32_t TraceParseCategories(const char *categories);
+
+// Record tracepoints of mask to a binary trace file
+void TraceStart(const char *file_name, uint32_t mask);
+
+// Print tracepoints of mask to file as text as soon as they are hit
+void TraceStartText(FILE *file, uint32_t mask);
+
+// Write out records of the calling thread and close the trace, other threads must have exited
+void TraceStop();
+
+// Decode a binary trace file to text, return false if it is not a trace file
+bool TraceDecode(const char *file_name, FILE *output);
+
+#endif //RISC_V_SIMULATOR_TRACE_H
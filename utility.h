@@ -27,6 +27,50 @@ typedef unsigned long int uint64_t;
 
 #define RoundUp(value, num_of_bits) ((((value - 1) >> num_of_bits) + 1) << num_of_bits)
 
+#define MAX_VARINT_SIZE 10      // bytes of a varint of 64 bit value
+
+// Append value as a varint of 7 bit groups, lowest first, return position after it
+inline uint8_t *PutVarint(uint8_t *position, uint64_t value) {
+    while (value >= 0x80) {
+        *position++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *position++ = (uint8_t) value;
+    return position;
+}
+
+// Read a varint at position, which is moved past it, return false if it does not end before end
+inline bool GetVarint(const uint8_t *&position, const uint8_t *end, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && position < end; shift += 7) {
+        uint8_t byte = *position++;
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Zigzag keeps small negative values as short varints as small positive ones
+inline uint64_t ZigzagEncode(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+inline int64_t ZigzagDecode(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+
+// FNV-1a hash of size bytes at data, continuing from hash so that several blocks can be hashed as one
+inline uint64_t HashBytes(const void *data, int64_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    for (int64_t i = 0; i < size; i++) {
+        hash ^= ((const uint8_t *) data)[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
 
 #define ASSERT(condition)                                                                         \
     if (!(condition)) {                                                                           \
@@ -35,20 +79,20 @@ typedef unsigned long int uint64_t;
         abort();                                                                                  \
     }                                                                                             \
 
-extern bool debug_enabled;
-extern bool initializing;
+// Each thread has its own flag, so machines of batch jobs run without printing pipeline state
+extern thread_local bool debug_enabled;
 
-#define DEBUG(...)                                                                                \
-    if (!initializing && debug_enabled) {                                                         \
-        printf(__VA_ARGS__);                                                                      \
-        fflush(stdout);                                                                           \
-    }                                                                                             \
+// Write out tracepoints recorded by the calling thread, defined in trace.cpp
+void TraceFlush();
 
+// Monotonic host time in seconds, defined in stats.cpp
+double HostTime();
 
 #define FATAL(...)                                                                                \
     {                                                                                             \
         fprintf(stderr, __VA_ARGS__);                                                             \
         fflush(stderr);                                                                           \
+        TraceFlush();                                                                             \
         abort();                                                                                  \
     }                                                                                             \
 